@@ -0,0 +1,265 @@
+#include "plugin/Admission.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+using namespace std::chrono;
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::AdmissionVerdict;
+using BedrockWhiteList::Utils::PlayerInfo;
+
+
+// Shared by Decide() and the lookup it posted, which may outlive the wait.
+struct PendingLookup {
+  std::mutex              Mutex;
+  std::condition_variable Cond;
+  bool                    Done{false};
+  bool                    Failed{false};
+  bool                    Abandoned{false};
+  PlayerInfo              Info{};
+  AdmissionVerdict        Given{};
+};
+
+
+BedrockWhiteList::Utils::AdmissionController::AdmissionController(
+    PlayerDB&     playerDB,
+    VerdictCache& cache,
+    Options       options
+)
+: m_playerDB(playerDB),
+  m_cache(cache),
+  m_options(options) {}
+
+
+BedrockWhiteList::Utils::AdmissionController::~AdmissionController() { Stop(); }
+
+
+// The lookups go first, they queue newcomers.
+void BedrockWhiteList::Utils::AdmissionController::Stop() {
+  m_executor.Stop();
+  m_recorder.Stop();
+}
+
+
+void BedrockWhiteList::Utils::AdmissionController::SetRecheckCallback(
+    RecheckCallback callback
+) {
+  m_onRecheck = std::move(callback);
+}
+
+
+AdmissionVerdict BedrockWhiteList::Utils::AdmissionController::Decide(
+    const string& playerUuid,
+    const string& playerName
+) {
+  const auto startTime = steady_clock::now();
+  const auto pending   = std::make_shared<PendingLookup>();
+
+  m_decisions++;
+
+  // While an abandoned lookup is still stuck, the ones queued behind it
+  // cannot finish in time either; answer right away instead of spending the
+  // budget of every joining player.
+  const bool stalled = m_stalled > 0;
+
+  auto lookup = [this, pending, playerUuid, playerName]() {
+    PlayerInfo info{};
+    bool       failed{false};
+
+    try {
+      info = m_playerDB.GetPlayerInfoAsUUID(playerUuid);
+    } catch (...) {
+      failed = true;
+    }
+
+    bool abandoned{false};
+    {
+      std::lock_guard lock(pending->Mutex);
+      pending->Info   = info;
+      pending->Failed = failed;
+      pending->Done   = true;
+      abandoned       = pending->Abandoned;
+    }
+    pending->Cond.notify_one();
+
+    if (abandoned) {
+      m_stalled--;
+    }
+
+    if (failed) {
+      m_errors++;
+      return;
+    }
+
+
+    if (info.Empty()) {
+      PlayerInfo newcomer(Blacklist, playerName, playerUuid, -1);
+      newcomer.Flags = AutoRecorded;
+
+      RecordNewcomer(std::move(newcomer));
+    }
+
+    if (abandoned) {
+      m_rechecks++;
+
+      if (m_onRecheck) {
+        m_onRecheck(info, pending->Given);
+      }
+    }
+  };
+  const auto posted = m_executor.Post(std::move(lookup));
+
+
+  AdmissionVerdict verdict{};
+  if (not posted) {
+    // Stopping: nothing will look the player up, and without a budget the
+    // wait below would never end.
+    verdict = Fallback(playerUuid);
+  } else {
+    std::unique_lock lock(pending->Mutex);
+
+    const auto done = [&pending] { return pending->Done; };
+    if (stalled) {
+      // Take the answer only if it is already there.
+    } else if (m_options.budget.count() > 0) {
+      pending->Cond.wait_for(lock, m_options.budget, done);
+    } else {
+      pending->Cond.wait(lock, done);
+    }
+
+    if (pending->Done and not pending->Failed) {
+      const auto& info = pending->Info;
+
+      verdict.Admit = not info.Empty() and info.PlayerStatus == Whitelist;
+      verdict.From  = AdmissionVerdict::Database;
+      verdict.Info  = info;
+    } else {
+      if (not pending->Done) {
+        m_overruns++;
+      }
+
+      verdict = Fallback(playerUuid);
+
+      if (not pending->Done) {
+        pending->Abandoned = true;
+        pending->Given     = verdict;
+        m_stalled++;
+      }
+    }
+  }
+
+
+  // Newcomers stay out, as PlayerDB keeps them out.
+  if (verdict.From == AdmissionVerdict::Database and not verdict.Info.Empty()
+      and verdict.Info.Flags != AutoRecorded) {
+    m_cache.Put(
+        playerUuid,
+        {static_cast<uint8_t>(verdict.Info.PlayerStatus),
+         verdict.Info.LastTime.Time}
+    );
+  }
+
+  const auto elapsed =
+      duration_cast<microseconds>(steady_clock::now() - startTime).count();
+
+  auto maxMicros = m_maxMicros.load();
+  while (elapsed > maxMicros
+         and not m_maxMicros.compare_exchange_weak(maxMicros, elapsed)) {}
+
+  return verdict;
+}
+
+
+// Whoever queues into an empty queue posts the write; the write empties the
+// queue before it starts, so nothing queued is left without one.
+void BedrockWhiteList::Utils::AdmissionController::RecordNewcomer(
+    PlayerInfo newcomer
+) {
+  bool first{false};
+  {
+    std::lock_guard lock(m_newcomerMutex);
+    first = m_newcomers.empty();
+    m_newcomers.push_back(std::move(newcomer));
+  }
+
+  // Stopping: written here, no worker will.
+  if (first and not m_recorder.Post([this]() { WriteNewcomers(); })) {
+    WriteNewcomers();
+  }
+}
+
+
+void BedrockWhiteList::Utils::AdmissionController::WriteNewcomers() {
+  vector<PlayerInfo> queued{};
+  {
+    std::lock_guard lock(m_newcomerMutex);
+    queued.swap(m_newcomers);
+  }
+
+  // A player queued twice is written once, and one a command listed since
+  // its lookup not at all: a newcomer row must not replace a real one.
+  vector<PlayerInfo>         newcomers{};
+  std::unordered_set<string> seen{};
+  for (auto& newcomer : queued) {
+    if (not seen.insert(newcomer.PlayerUuid).second) {
+      continue;
+    }
+
+    try {
+      if (m_playerDB.GetPlayerInfoAsUUID(newcomer.PlayerUuid).Empty()) {
+        newcomers.push_back(std::move(newcomer));
+      }
+    } catch (...) {
+      m_errors++;
+    }
+  }
+
+  try {
+    const vector<PlayerInfo> oldInfos(newcomers.size());
+    m_playerDB.SetPlayerInfoBatch(newcomers, "auto", &oldInfos);
+  } catch (...) {
+    m_errors++;
+  }
+}
+
+
+AdmissionVerdict
+BedrockWhiteList::Utils::AdmissionController::Fallback(const string& playerUuid) {
+  AdmissionVerdict verdict{};
+  verdict.Info.PlayerUuid = playerUuid;
+
+  Verdict known{};
+  if (m_cache.Get(playerUuid, known)) {
+    m_cacheFallbacks++;
+
+    verdict.From              = AdmissionVerdict::Cache;
+    verdict.Admit             = known.Status == Whitelist;
+    verdict.Info.PlayerStatus = known.Status == Whitelist ? Whitelist : Blacklist;
+    verdict.Info.LastTime     = known.LastTime;
+    return verdict;
+  }
+
+  m_policyFallbacks++;
+
+  verdict.From  = AdmissionVerdict::Policy;
+  verdict.Admit = m_options.fallback == FailOpen;
+  return verdict;
+}
+
+
+BedrockWhiteList::Utils::AdmissionController::Statistics
+BedrockWhiteList::Utils::AdmissionController::GetStatistics() const {
+  return {
+      m_decisions,
+      m_overruns,
+      m_cacheFallbacks,
+      m_policyFallbacks,
+      m_rechecks,
+      m_errors,
+      m_maxMicros
+  };
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "plugin/PlayerDB.h"
+#include "plugin/VerdictCache.h"
+#include "plugin/Warmup.h"
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+struct AdmissionVerdict {
+  // Where the answer came from; anything but Database means the lookup ran
+  // over its budget.
+  typedef enum __tagSource { Database, Cache, Policy } Source;
+
+  bool       Admit;
+  Source     From;
+  PlayerInfo Info;
+};
+
+
+/*
+ * The join decision of the connect listener, bounded in time.
+ *
+ * The lookup runs on a worker thread and the caller waits at most the
+ * budget. Past it, the last known verdict from the cache answers, or the
+ * fallback policy for a player the cache does not know. The lookup keeps
+ * going and, once it has the real row, hands it to the re-check callback
+ * together with the verdict that was given in its place.
+ *
+ * Unknown players are queued as newcomers after the answer was handed back
+ * and written by a second worker, all that queued up meanwhile in one batch:
+ * a flood of joins commits once per shard per batch, not once per player,
+ * and lookups do not wait behind the writes.
+ */
+class AdmissionController {
+  public:
+  struct Options {
+    std::chrono::milliseconds budget{50};
+    WarmupPolicy              fallback{FailClosed};
+  };
+
+  struct Statistics {
+    uint64_t Decisions;
+    uint64_t Overruns;
+    uint64_t CacheFallbacks;
+    uint64_t PolicyFallbacks;
+    uint64_t Rechecks;
+    uint64_t Errors;
+    int64_t  MaxMicros;
+  };
+
+  // Called on the worker thread.
+  typedef std::function<
+      void(const PlayerInfo& actual, const AdmissionVerdict& given)>
+      RecheckCallback;
+
+  AdmissionController(PlayerDB& playerDB, VerdictCache& cache, Options options);
+  ~AdmissionController();
+
+  public:
+  AdmissionVerdict
+  Decide(const std::string& playerUuid, const std::string& playerName);
+
+  void       SetRecheckCallback(RecheckCallback callback);
+  Statistics GetStatistics() const;
+
+  // Waits for queued lookups and newcomer writes. Decide() answers with the
+  // fallback from then on.
+  void Stop();
+
+  private:
+  AdmissionVerdict Fallback(const std::string& playerUuid);
+
+  void RecordNewcomer(PlayerInfo newcomer);
+  void WriteNewcomers();
+
+  private:
+  PlayerDB&       m_playerDB;
+  VerdictCache&   m_cache;
+  Options         m_options;
+  RecheckCallback m_onRecheck{};
+  SerialExecutor  m_executor{};
+
+  // Queued by lookups, taken whole by the next write.
+  std::mutex              m_newcomerMutex;
+  std::vector<PlayerInfo> m_newcomers{};
+  SerialExecutor          m_recorder{};
+
+  std::atomic<uint64_t> m_decisions{0};
+  std::atomic<uint64_t> m_overruns{0};
+  std::atomic<uint64_t> m_cacheFallbacks{0};
+  std::atomic<uint64_t> m_policyFallbacks{0};
+  std::atomic<uint64_t> m_rechecks{0};
+  std::atomic<uint64_t> m_errors{0};
+  std::atomic<int64_t>  m_maxMicros{0};
+
+  // Abandoned lookups that have not finished yet.
+  std::atomic<int> m_stalled{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
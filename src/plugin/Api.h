@@ -0,0 +1,78 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*
+ * What BedrockWhitelist.dll exports to other plugins, with a C interface so
+ * any compiler and LeviLamina version can call it. Include this header and
+ * link against the import library, or look the functions up with
+ * GetProcAddress.
+ */
+
+
+#ifdef BEDROCK_WHITELIST_EXPORTS
+#define BEDROCK_WHITELIST_API extern "C" __declspec(dllexport)
+#else
+#define BEDROCK_WHITELIST_API extern "C" __declspec(dllimport)
+#endif
+
+
+// The list counters, as /_whitelist counters shows them. Set Size to
+// sizeof(BedrockWhitelistCounters) before the call; fields past it are left
+// alone, so a caller built against an older header keeps working when
+// fields are added at the end.
+struct BedrockWhitelistCounters {
+  uint32_t Size;
+  int64_t  Whitelisted;
+  int64_t  Blacklisted;  // not counting the auto-recorded newcomers
+  int64_t  TimedBans;    // of Blacklisted, not yet expired
+  int64_t  AutoRecorded;
+  int64_t  NewcomersLastHour;
+  int64_t  NewcomersLastDay;
+  int64_t  RejectsLastMinute; // the last whole minute
+  int64_t  RejectsLastHour;
+};
+
+
+// Constant time, from any thread. False before the database is open and
+// when counters is null or its Size is too small for Size itself.
+BEDROCK_WHITELIST_API bool
+BedrockWhitelist_GetCounters(BedrockWhitelistCounters* counters);
+
+
+// For a group permission plugin. The rules of config.yaml may name groups;
+// the whitelist knows a player's groups only from these calls, it does not
+// look for itself. Players are named by their UUID, groups by the names the
+// rules use. All of them may be called from any thread, from the time the
+// DLL is loaded.
+
+// Call whenever the groups of a player change, online or not. False when
+// playerUuid is null.
+BEDROCK_WHITELIST_API bool BedrockWhitelist_SetPlayerGroups(
+    const char*        playerUuid,
+    const char* const* groups,
+    size_t             count
+);
+
+// Forgets the groups of a player, or of every player when playerUuid is
+// null; they are asked from the resolver again when needed.
+BEDROCK_WHITELIST_API void
+BedrockWhitelist_InvalidatePlayerGroups(const char* playerUuid);
+
+// A resolver calls add once per group of the player, passing context on.
+typedef void (*BedrockWhitelistAddGroup)(void* context, const char* group);
+typedef void (*BedrockWhitelistGroupResolver)(
+    const char*              playerUuid,
+    BedrockWhitelistAddGroup add,
+    void*                    context
+);
+
+// Asked for a player the whitelist has not been told about, on the thread
+// deciding the connect, once until the player is invalidated or is no
+// longer among the last 16384 asked about. Setting one forgets every
+// player; set null before unloading the plugin it lives in.
+BEDROCK_WHITELIST_API void
+BedrockWhitelist_SetGroupResolver(BedrockWhitelistGroupResolver resolver);
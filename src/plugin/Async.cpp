@@ -0,0 +1,44 @@
+#include "plugin/Async.h"
+
+using BedrockWhiteList::Utils::AsyncTask;
+
+
+static AsyncTask::ErrorHandler g_onError{};
+
+
+AsyncTask BedrockWhiteList::Utils::AsyncTask::promise_type::get_return_object(
+) noexcept {
+  return {};
+}
+
+
+std::suspend_never
+BedrockWhiteList::Utils::AsyncTask::promise_type::initial_suspend() noexcept {
+  return {};
+}
+
+
+std::suspend_never
+BedrockWhiteList::Utils::AsyncTask::promise_type::final_suspend() noexcept {
+  return {};
+}
+
+
+void BedrockWhiteList::Utils::AsyncTask::promise_type::return_void() noexcept {}
+
+
+void BedrockWhiteList::Utils::AsyncTask::promise_type::unhandled_exception(
+) noexcept {
+  try {
+    std::rethrow_exception(std::current_exception());
+  } catch (std::exception& e) {
+    if (g_onError) {
+      g_onError(e);
+    }
+  } catch (...) {}
+}
+
+
+void BedrockWhiteList::Utils::AsyncTask::SetErrorHandler(ErrorHandler handler) {
+  g_onError = std::move(handler);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * A coroutine nobody waits for, started by a command. The body runs on the
+ * caller's thread up to its first co_await and on the executor each
+ * ResumeOn names after that:
+ *
+ *   co_await ResumeOn(workers);    // storage work, off the game thread
+ *   co_await ResumeOn(mainThread); // back on it for the reply
+ *
+ * The frame frees itself when the body returns. An exception escaping the
+ * body goes to the handler of SetErrorHandler().
+ */
+class AsyncTask {
+  public:
+  typedef std::function<void(const std::exception&)> ErrorHandler;
+
+  struct promise_type {
+    AsyncTask          get_return_object() noexcept;
+    std::suspend_never initial_suspend() noexcept;
+    std::suspend_never final_suspend() noexcept;
+    void               return_void() noexcept;
+    void               unhandled_exception() noexcept;
+  };
+
+  public:
+  // Set once before the first task starts.
+  static void SetErrorHandler(ErrorHandler handler);
+};
+
+
+/*
+ * Suspends the coroutine and posts its resumption to executor, anything with
+ * Post(std::function<void()>): a WorkerPool, a SerialExecutor or the
+ * MainThreadQueue. An executor that drops the job, as a stopped one does,
+ * leaves the coroutine suspended and its frame allocated.
+ */
+template <typename Executor>
+class ResumeOn {
+  public:
+  explicit ResumeOn(Executor& executor) : m_executor(executor) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) const {
+    m_executor.Post([handle]() { handle.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+
+  private:
+  Executor& m_executor;
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,324 @@
+#include "plugin/Backup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <fstream>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <sqlite3.h>
+#include <zlib.h>
+
+#include "plugin/Shards.h"
+
+using namespace std::chrono;
+
+using std::string, std::vector;
+
+namespace filesystem = std::filesystem;
+
+
+constexpr auto BACKUP_PREFIX = "backup-";
+constexpr auto BACKUP_SUFFIX = ".sqlite3.db";
+
+
+inline static bool IsBackupFile(const filesystem::path& path) {
+  const auto name = path.filename().string();
+
+  return name.starts_with(BACKUP_PREFIX)
+     and (name.ends_with(BACKUP_SUFFIX)
+          or name.ends_with(string(BACKUP_SUFFIX) + ".gz"));
+}
+
+
+BedrockWhiteList::Utils::OnlineBackup::OnlineBackup(Options options)
+: m_options(std::move(options)) {}
+
+
+BedrockWhiteList::Utils::OnlineBackup::~OnlineBackup() { Stop(); }
+
+
+void BedrockWhiteList::Utils::OnlineBackup::Start() {
+  if (m_task != nullptr) {
+    return;
+  }
+
+  // An interval of 0 means on demand only.
+  const milliseconds interval =
+      m_options.interval > 0 ? seconds(m_options.interval) : hours(24 * 365);
+
+  m_task = std::make_unique<PeriodicTask>(interval, [this](PeriodicTask& task) {
+    Run(task);
+  });
+  m_task->SetErrorHandler(m_onError);
+  m_task->Start();
+}
+
+
+// Stops at the next step boundary, an unfinished copy is discarded.
+void BedrockWhiteList::Utils::OnlineBackup::Stop() {
+  if (m_task == nullptr) {
+    return;
+  }
+
+  m_task->Stop();
+  m_task.reset();
+}
+
+
+bool BedrockWhiteList::Utils::OnlineBackup::Trigger() {
+  if (m_task == nullptr or m_running) {
+    return false;
+  }
+
+  m_task->Trigger();
+  return true;
+}
+
+
+BedrockWhiteList::Utils::OnlineBackup::Progress
+BedrockWhiteList::Utils::OnlineBackup::GetProgress() const {
+  return {m_running, m_totalPages, m_remainingPages, m_restarts, m_completed, m_lastDuration};
+}
+
+
+void BedrockWhiteList::Utils::OnlineBackup::SetReportCallback(
+    ReportCallback callback
+) {
+  m_onReport = std::move(callback);
+}
+
+
+void BedrockWhiteList::Utils::OnlineBackup::SetErrorCallback(
+    ErrorCallback callback
+) {
+  m_onError = std::move(callback);
+}
+
+
+void BedrockWhiteList::Utils::OnlineBackup::Run(PeriodicTask& task) {
+  const auto startTime = steady_clock::now();
+  const auto directory = filesystem::path(m_options.directory);
+
+  m_running        = true;
+  m_totalPages     = 0;
+  m_remainingPages = 0;
+  m_restarts       = 0;
+
+  filesystem::create_directories(directory);
+
+  // Left behind by a copy interrupted by a crash.
+  for (auto& entry : filesystem::directory_iterator(directory)) {
+    if (entry.path().extension() == ".tmp") {
+      std::error_code ec;
+      filesystem::remove(entry.path(), ec);
+    }
+  }
+
+
+  const auto name = fmt::format(
+      "{0}{1:%Y%m%d-%H%M%S}{2}",
+      BACKUP_PREFIX,
+      fmt::localtime(std::time(nullptr)),
+      BACKUP_SUFFIX
+  );
+  const auto temporary = directory / (name + ".tmp");
+
+  Report report{};
+
+  try {
+
+    if (not Copy(task, temporary, report)) {
+      filesystem::remove(temporary);
+      m_running = false;
+      return;
+    }
+
+    if (1 < m_options.shards) {
+      SQLite::Database copy(temporary.string(), SQLite::OPEN_READWRITE);
+
+      for (auto& path : RowDatabasePaths(m_options.databasePath, m_options.shards)) {
+        CopyShardRows(copy, path, 0, 1);
+      }
+      StoreShardCount(copy, 1);
+    }
+
+    if (m_options.compress) {
+      const auto target = directory / (name + ".gz");
+
+      report.Bytes = Compress(temporary, target);
+      report.File  = target.string();
+      filesystem::remove(temporary);
+    } else {
+      const auto target = directory / name;
+
+      filesystem::rename(temporary, target);
+      report.Bytes = filesystem::file_size(target);
+      report.File  = target.string();
+    }
+
+    Rotate();
+
+  } catch (...) {
+    std::error_code ec;
+    filesystem::remove(temporary, ec);
+
+    m_running = false;
+    throw;
+  }
+
+
+  report.DurationMillis =
+      duration_cast<milliseconds>(steady_clock::now() - startTime).count();
+
+  m_completed++;
+  m_lastDuration = report.DurationMillis;
+  m_running      = false;
+
+  if (m_onReport) {
+    m_onReport(report);
+  }
+}
+
+
+// Returns false when the task was stopped before the copy finished.
+bool BedrockWhiteList::Utils::OnlineBackup::Copy(
+    PeriodicTask&                task,
+    const filesystem::path&      target,
+    Report&                      report
+) {
+  SQLite::Database source(m_options.databasePath, SQLite::OPEN_READONLY, 1000);
+  SQLite::Database destination(
+      target.string(),
+      SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+  );
+
+  auto backup = sqlite3_backup_init(
+      destination.getHandle(),
+      "main",
+      source.getHandle(),
+      "main"
+  );
+  if (backup == nullptr) {
+    throw std::runtime_error(sqlite3_errmsg(destination.getHandle()));
+  }
+
+
+  auto pagesPerStep = m_options.pagesPerStep;
+  int  remaining{-1};
+  int  result{SQLITE_OK};
+
+  while (true) {
+    result = sqlite3_backup_step(backup, pagesPerStep);
+    report.Steps++;
+
+    if (result == SQLITE_DONE) {
+      break;
+    }
+
+    if (result != SQLITE_OK and result != SQLITE_BUSY
+        and result != SQLITE_LOCKED) {
+      sqlite3_backup_finish(backup);
+      throw std::runtime_error(sqlite3_errstr(result));
+    }
+
+
+    // A write through another connection makes the copy start over, seen
+    // as the remaining page count going up.
+    const auto nowRemaining = sqlite3_backup_remaining(backup);
+    if (remaining != -1 and nowRemaining > remaining) {
+      report.Restarts++;
+      m_restarts++;
+
+      if (report.Restarts >= m_options.maxRestarts) {
+        pagesPerStep = -1;
+      }
+    }
+
+    remaining        = nowRemaining;
+    m_totalPages     = sqlite3_backup_pagecount(backup);
+    m_remainingPages = remaining;
+
+    if (not task.Sleep(milliseconds(m_options.stepPauseMillis))) {
+      sqlite3_backup_finish(backup);
+      return false;
+    }
+  }
+
+
+  report.Pages     = sqlite3_backup_pagecount(backup);
+  m_totalPages     = report.Pages;
+  m_remainingPages = 0;
+
+  result = sqlite3_backup_finish(backup);
+  if (result != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errstr(result));
+  }
+
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::OnlineBackup::Rotate() const {
+  vector<filesystem::path> backups{};
+
+  for (auto& entry : filesystem::directory_iterator(m_options.directory)) {
+    if (entry.is_regular_file() and IsBackupFile(entry.path())) {
+      backups.push_back(entry.path());
+    }
+  }
+
+  if (backups.size() <= static_cast<size_t>(std::max(m_options.keep, 1))) {
+    return;
+  }
+
+  // The timestamp in the name sorts oldest first.
+  std::sort(backups.begin(), backups.end());
+  backups.resize(backups.size() - std::max(m_options.keep, 1));
+
+  for (auto& path : backups) {
+    filesystem::remove(path);
+  }
+}
+
+
+uint64_t BedrockWhiteList::Utils::OnlineBackup::Compress(
+    const filesystem::path& source,
+    const filesystem::path& target
+) {
+  std::ifstream input(source, std::ios::binary);
+  if (not input) {
+    throw std::runtime_error("Cannot read " + source.string());
+  }
+
+#ifdef _WIN32
+  auto output = gzopen_w(target.c_str(), "wb6");
+#else
+  auto output = gzopen(target.c_str(), "wb6");
+#endif
+  if (output == nullptr) {
+    throw std::runtime_error("Cannot create " + target.string());
+  }
+
+
+  vector<char> buffer(64 * 1024);
+
+  while (input) {
+    input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    const auto length = static_cast<unsigned>(input.gcount());
+    if (length != 0 and gzwrite(output, buffer.data(), length) == 0) {
+      gzclose(output);
+      throw std::runtime_error("Cannot write " + target.string());
+    }
+  }
+
+  if (gzclose(output) != Z_OK) {
+    throw std::runtime_error("Cannot write " + target.string());
+  }
+
+  return filesystem::file_size(target);
+}
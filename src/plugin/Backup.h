@@ -0,0 +1,112 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * Copies the live database with the SQLite online backup API.
+ *
+ * The copy runs on a connection of its own, pagesPerStep pages at a time
+ * with a pause in between, so it never holds a lock long enough to be
+ * noticed by the connect listener. A write made by another connection
+ * restarts the copy; after maxRestarts the rest is copied in one step,
+ * which in WAL mode still blocks no reader or writer. The result is
+ * gzip-compressed to "<prefix>-<time>.sqlite3.db.gz" and only the newest
+ * keep backups are retained.
+ *
+ * With the player rows sharded, the rows of every shard file are merged into
+ * the copy, which then holds them as one shard: a backup is a single file
+ * whatever database.shards is, and is spread out again on start.
+ */
+class OnlineBackup {
+  public:
+  struct Options {
+    std::string databasePath{};
+    size_t      shards{1}; // of the player rows
+    std::string directory{};
+    int64_t     interval{24 * 3600};
+    int         keep{7};
+    int         pagesPerStep{64};
+    int         stepPauseMillis{10};
+    int         maxRestarts{3};
+    bool        compress{true};
+  };
+
+  struct Progress {
+    bool     Running;
+    int      TotalPages;
+    int      RemainingPages;
+    int      Restarts;
+    uint64_t Completed;
+    int64_t  LastDurationMillis;
+  };
+
+  struct Report {
+    std::string File;
+    int         Pages;
+    int         Steps;
+    int         Restarts;
+    uint64_t    Bytes;
+    int64_t     DurationMillis;
+  };
+
+  typedef std::function<void(const Report&)> ReportCallback;
+  typedef PeriodicTask::ErrorHandler         ErrorCallback;
+
+  explicit OnlineBackup(Options options);
+  ~OnlineBackup();
+
+  public:
+  void Start();
+  void Stop();
+
+  // Starts a backup now, false when one is already running.
+  bool Trigger();
+
+  Progress GetProgress() const;
+
+  void SetReportCallback(ReportCallback callback);
+  void SetErrorCallback(ErrorCallback callback);
+
+  private:
+  void Run(PeriodicTask& task);
+  bool Copy(PeriodicTask& task, const std::filesystem::path& target, Report& report);
+  void Rotate() const;
+
+  static uint64_t
+  Compress(const std::filesystem::path& source, const std::filesystem::path& target);
+
+  private:
+  Options                       m_options;
+  ReportCallback                m_onReport{};
+  ErrorCallback                 m_onError{};
+  std::unique_ptr<PeriodicTask> m_task{};
+
+  std::atomic<bool>     m_running{false};
+  std::atomic<int>      m_totalPages{0};
+  std::atomic<int>      m_remainingPages{0};
+  std::atomic<int>      m_restarts{0};
+  std::atomic<uint64_t> m_completed{0};
+  std::atomic<int64_t>  m_lastDuration{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
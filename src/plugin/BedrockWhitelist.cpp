@@ -1,5 +1,11 @@
 ﻿#include "plugin/BedrockWhitelist.h"
 
+#include "plugin/Api.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
 using namespace ll;
 using namespace BedrockWhiteList;
 
@@ -8,6 +14,26 @@ namespace filesystem = std::filesystem;
 static string g_pluginInfo{};
 static auto   g_config = new PluginConfig;
 
+static Utils::ReadinessGate g_warmupGate{};
+static std::thread          g_warmupThread{};
+static std::atomic<bool>    g_shutdown{false};
+
+// Work handed back to the game thread by background threads.
+static Utils::MainThreadQueue          g_mainThread{};
+static ll::schedule::GameTickScheduler g_scheduler{};
+static std::thread::id                 g_gameThread{};
+
+// Players on the server, for the enforcement sweep.
+static Utils::OnlineRoster g_online{};
+
+// Kick and log messages of the connect path, compiled per locale.
+static Utils::MessageCatalog g_messages{};
+
+// Permission groups of the players, for the rules that name groups. Other
+// plugins fill it through Api.h as soon as the DLL is loaded, before the
+// database is open.
+static Utils::GroupCache g_groups{};
+
 
 inline static bool CheckOriginAs(
     const CommandOrigin&                     origin,
@@ -24,250 +50,477 @@ inline static bool CheckOriginAs(
 }
 
 
-// - - - - - - - - - - - - - - - - - Utils - - - - - - - - - - - - - - - - -
+// Operator players, the console and (when enabled) command blocks.
+inline static bool CheckAdminOrigin(const CommandOrigin& origin) {
+  if (origin.getOriginType() == CommandOriginType::CommandBlock) {
+    return g_config->permission.enableCommandblock;
+  }
 
+  const auto entity = origin.getEntity();
+  if (entity == nullptr) {
+    return true;
+  }
 
-BedrockWhiteList::Utils::PlayerInfo::PlayerInfo() {
-  *this = PlayerInfo(Utils::Whitelist, "", "", 0);
-}
+  if (entity->isType(ActorType::MinecartCommandBlock)) {
+    return false;
+  }
 
+  if (entity->isType(ActorType::Player)) {
+    return static_cast<Player*>(entity)->getPlayerPermissionLevel()
+        == PlayerPermissionLevel::Operator;
+  }
 
-BedrockWhiteList::Utils::PlayerInfo::PlayerInfo(
-    Utils::PlayerStatus playerStatus,
-    string              playerName,
-    string              playerUuid,
-    TimeUnix            lastTime
-) {
-  PlayerStatus = playerStatus;
-  PlayerUuid   = playerUuid;
-  PlayerName   = playerName;
-  LastTime     = lastTime;
+  return true;
 }
 
 
-bool BedrockWhiteList::Utils::PlayerInfo::Empty() const {
-  return PlayerName.empty() or PlayerUuid.empty() or LastTime.Empty();
+inline static bool CheckReady(CommandOutput& output) {
+  if (g_warmupGate.IsReady()) {
+    return true;
+  }
+
+  output.error("The plugin is still starting, please retry later. "_tr());
+  return false;
 }
 
 
-void BedrockWhiteList::Utils::PlayerInfo::operator=(PlayerInfo info) {
-  this->PlayerStatus = info.PlayerStatus;
-  this->PlayerUuid   = info.PlayerUuid;
-  this->PlayerName   = info.PlayerName;
-  this->LastTime     = info.LastTime;
+inline static bool CheckLists(CommandOutput& output) {
+  if (not CheckReady(output)) {
+    return false;
+  }
+
+  if (g_config->GetLists() == nullptr) {
+    output.error("Named lists need the sqlite backend. "_tr());
+    return false;
+  }
+
+  return true;
 }
 
 
-BedrockWhiteList::Utils::TimeUnix::TimeUnix() { Time = -1; }
+// Milliseconds since a start time, for the log lines that time startup and
+// commands.
+inline static long long ElapsedMillis(std::chrono::steady_clock::time_point since
+) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - since
+  )
+      .count();
+}
 
 
-BedrockWhiteList::Utils::TimeUnix::TimeUnix(time_t time) { Time = time; }
+// Loads the lang files and compiles the connect path messages of every
+// locale among them.
+inline static size_t LoadMessages(const filesystem::path& langDir) {
+  i18n::load(langDir.string());
+
+  std::vector<string> locales{};
+  for (auto& entry : filesystem::directory_iterator(langDir)) {
+    if (entry.path().extension() == ".json") {
+      locales.push_back(entry.path().stem().string());
+    }
+  }
 
+  g_messages.Compile(locales, [](std::string_view key, std::string_view locale) {
+    const auto& instance = i18n::getInstance();
+    return instance != nullptr ? string(instance->get(key, locale)) : string(key);
+  });
 
-bool BedrockWhiteList::Utils::TimeUnix::Empty() const {
-  return this->Time == NULL;
+  return locales.size();
 }
 
 
-string BedrockWhiteList::Utils::TimeUnix::ToString() { return string(); }
+// Why a player is turned away, in their locale. Unknown players got
+// recorded as newcomers, players whose ban has run out are on no list.
+inline static string
+RejectMessage(const Utils::AdmissionVerdict& verdict, std::string_view locale) {
+  if (verdict.From == Utils::AdmissionVerdict::Policy) {
+    return g_messages.Render(Utils::KickServerBusy, locale);
+  }
 
+  if ((verdict.Info.Empty()
+       and verdict.From == Utils::AdmissionVerdict::Database)
+      or verdict.Info.Expired(std::time(nullptr))) {
+    return g_messages.Render(Utils::KickNotWhitelisted, locale);
+  }
 
-bool BedrockWhiteList::Utils::TimeUnix::operator==(long long cmpTime) {
-  return Time == cmpTime;
+  auto lastTime = verdict.Info.LastTime;
+  return lastTime == -1
+           ? g_messages.Render(Utils::KickBlacklistedForever, locale)
+           : g_messages.Render(
+                 Utils::KickBlacklistedUntil,
+                 locale,
+                 {lastTime.ToString()}
+             );
 }
 
 
-long long BedrockWhiteList::Utils::TimeUnix::operator=(long long llTime) {
-  return Time = llTime;
+// The message of a deny rule, written in config.yaml.
+inline static string RuleMessage(int rule, std::string_view locale) {
+  const auto rules   = g_config->GetRules();
+  auto       message = rules != nullptr ? rules->Message(rule) : string{};
+
+  return message.empty() ? g_messages.Render(Utils::KickRuleDenied, locale)
+                         : message;
 }
 
 
-// - - - - - - Player Database - - - - - -
+inline static string
+RejectMessage(const Utils::ConnectOutcome& outcome, std::string_view locale) {
+  if (outcome.What == Utils::ConnectOutcome::WarmupRejected) {
+    return g_messages.Render(Utils::KickStarting, locale);
+  }
+
+  if (outcome.What == Utils::ConnectOutcome::ListRejected) {
+    return g_messages.Render(Utils::KickNotOnList, locale);
+  }
+
+  if (outcome.What == Utils::ConnectOutcome::RuleRejected) {
+    return RuleMessage(outcome.Rule, locale);
+  }
+
+  return RejectMessage(outcome.Verdict, locale);
+}
 
 
-BedrockWhiteList::Utils::PlayerDB::PlayerDB() { m_tempSession = nullptr; }
+// The uuid the lists know an online player by: the one first seen with the
+// xuid, as the connect decision uses it, or the uuid of the session for a
+// player without a known xuid.
+inline static string ListUuid(const Player& player) {
+  const auto identities = g_config ? g_config->GetIdentities() : nullptr;
+  const auto xuid       = Utils::IdentityIndex::ParseXuid(player.getXuid());
 
+  Utils::PlayerIdentity identity{};
+  if (identities != nullptr and xuid != 0 and identities->Resolve(xuid, identity)) {
+    return identity.PlayerUuid;
+  }
 
-BedrockWhiteList::Utils::PlayerDB::PlayerDB(SQLite::Database* session) {
-  assert(session);
+  return player.getUuid().asString();
+}
 
 
-  m_tempSession = session;
-  m_tempSession->exec("CREATE TABLE IF NOT EXISTS whitelist("
-                      "player_uuid TINYTEXT NOT NULL UNIQUE,"
-                      "player_name TINYTEXT NOT NULL,"
-                      "player_last_time BIGINT NOT NULL,"
-                      "PRIMARY KEY(player_uuid));");
+// The online player the lists know by playerUuid, null when not online.
+inline static Player* OnlinePlayer(const string& playerUuid) {
+  const auto level       = ll::service::getLevel();
+  const auto sessionUuid = g_online.SessionUuid(playerUuid);
+  if (not level or sessionUuid.empty()) {
+    return nullptr;
+  }
 
-  m_tempSession->exec("CREATE TABLE IF NOT EXISTS blacklist("
-                      "player_uuid TINYTEXT NOT NULL UNIQUE,"
-                      "player_name TINYTEXT NOT NULL,"
-                      "player_last_time BIGINT NOT NULL,"
-                      "PRIMARY KEY(player_uuid));");
+  return level->getPlayer(mce::UUID::fromString(sessionUuid));
 }
 
 
-BedrockWhiteList::Utils::PlayerDB::~PlayerDB() {
-  // Do not close it.
-  m_tempSession = nullptr;
+// Disconnects the online players a sweep turned away.
+inline static void DisconnectRejected(const Utils::EnforcementReport& report) {
+  const auto level = ll::service::getLevel();
+  if (not level or report.Rejected.empty()) {
+    return;
+  }
+
+  Logger logger("BEWhitelist.Enforcement");
+  for (auto& [playerUuid, outcome] : report.Rejected) {
+    const auto player = OnlinePlayer(playerUuid);
+    if (player == nullptr) {
+      continue;
+    }
+
+    player->disconnect(RejectMessage(outcome, player->getLocaleName()));
+    logger.info(g_messages.Render(Utils::LogNoLongerLetIn, "", {player->getName()})
+    );
+  }
+
+  logger.info("Swept {0} change(s), {1} online, {2} disconnected in {3} us. "_tr(
+      report.Changed,
+      report.Online,
+      report.Rejected.size(),
+      report.Micros
+  ));
 }
 
 
-bool BedrockWhiteList::Utils::PlayerDB::__GetPlayerInfo(
-    SQLite::Statement& result,
-    Utils::PlayerInfo& info
+// Sweeps that read the rows of the players again run on a command worker,
+// where a lookup may wait for a write; only the disconnects come back to
+// the game thread.
+inline static void SweepOffThread(
+    std::function<Utils::EnforcementReport(const Utils::EnforcementSweep&)> sweep
 ) {
-  if (result.executeStep()) {
-    info.PlayerUuid = result.getColumn(0).getString();
-    info.PlayerName = result.getColumn(1).getString();
-    info.LastTime   = result.getColumn(0).getInt64();
-    return true;
+  const auto enforcement = g_config ? g_config->GetEnforcement() : nullptr;
+  const auto pool        = g_config ? g_config->GetCommandPool() : nullptr;
+  if (enforcement == nullptr or pool == nullptr) {
+    return;
   }
 
-  return false;
+  pool->Post([enforcement, sweep = std::move(sweep)]() {
+    try {
+      auto report = sweep(*enforcement);
+      g_mainThread.Post([report = std::move(report)]() {
+        DisconnectRejected(report);
+      });
+    } catch (std::exception& e) {
+      Logger logger("BEWhitelist.Enforcement");
+      logger.error("The sweep failed: {0}"_tr(e.what()));
+    }
+  });
 }
 
 
-void BedrockWhiteList::Utils::PlayerDB::SetPlayerInfo(PlayerInfo playerInfo) {
-  assert(m_tempSession);
+// Players whose named lists changed.
+inline static void EnforceOnline(const vector<string>& playerUuids) {
+  SweepOffThread([playerUuids](const auto& enforcement) {
+    return enforcement.Sweep(playerUuids);
+  });
+}
+
 
+// Applies rows just written to the players online, in the tick of the
+// change when it ran on the game thread and in the next one otherwise.
+template <typename Changed>
+inline static void EnforceOnline(const Changed& changed) {
+  if (std::this_thread::get_id() != g_gameThread) {
+    g_mainThread.Post([changed]() { EnforceOnline(changed); });
+    return;
+  }
 
-  const char* table = playerInfo.PlayerStatus == PlayerStatus::Whitelist
-                        ? "whitelist"
-                        : "blacklist";
+  const auto enforcement = g_config ? g_config->GetEnforcement() : nullptr;
+  if (enforcement != nullptr) {
+    DisconnectRejected(enforcement->Sweep(changed));
+  }
+}
 
 
-  m_tempSession->exec(fmt::format(
-      FMT_COMPILE("INSERT INTO {0}(player_uuid, player_name, player_last_time) "
-                  "VALUES(\"{1}\", \"{2}\", {3}) ON CONFLICT(player_uuid) "
-                  "DO UPDATE SET player_uuid = \"{1}\", player_name = \"{2}\", "
-                  "player_last_time = {3}; "),
-      table,
-      playerInfo.PlayerUuid.c_str(),
-      playerInfo.PlayerName.c_str(),
-      playerInfo.LastTime.Time
-  ));
+// After the rules or the admission expression changed.
+inline static void EnforceOnlineAll() {
+  SweepOffThread([](const auto& enforcement) { return enforcement.SweepAll(); });
 }
 
 
-Utils::PlayerInfo
-BedrockWhiteList::Utils::PlayerDB::GetPlayerInfo(string playerName) {
-  assert(m_tempSession);
+// The uuid the lists know player by. A xuid, a uuid or any name the player
+// joined with goes through the identities, a name shared by several players
+// to the one who has it now; without a match a uuid stands for itself and a
+// name is looked up in the rows. Empty when unknown.
+inline static string ResolvePlayerUuid(const string& player) {
+  const auto identities = g_config->GetIdentities();
+  if (identities != nullptr) {
+    const auto found = identities->Find(player, 0);
 
-  PlayerInfo info{};
-  char*      errMsg{};
+    for (auto& identity : found) {
+      if (identity.PlayerName == player) {
+        return identity.PlayerUuid;
+      }
+    }
 
-  SQLite::Statement query(
-      *m_tempSession,
-      fmt::format(
-          FMT_COMPILE("SELECT * FROM whitelist WHERE player_name = \"{0}\""),
-          playerName.c_str()
-      )
-  );
-  __GetPlayerInfo(query, info);
+    if (not found.empty()) {
+      return found.front().PlayerUuid;
+    }
+  }
+
+  if (mce::UUID::canParse(player)) {
+    return player;
+  }
+
+  return g_config->GetSeesion()->GetPlayerInfo(player).PlayerUuid;
+}
 
 
-  if (not info.Empty()) {
-    info.PlayerStatus = Utils::Whitelist;
-    return info;
+inline static Utils::PlayerInfo FindPlayer(const string& player) {
+  const auto playerUuid = ResolvePlayerUuid(player);
+  if (playerUuid.empty()) {
+    return {};
   }
 
+  return g_config->GetSeesion()->GetPlayerInfoAsUUID(playerUuid);
+}
+
 
-  query = SQLite::Statement(
-      *m_tempSession,
-      fmt::format(
-          FMT_COMPILE("SELECT * FROM blacklist WHERE player_name = \"{0}\""),
-          playerName.c_str()
-      )
-  );
-  __GetPlayerInfo(query, info);
+inline static string FormatUnixTime(long long time) {
+  if (time == -1) {
+    return "forever"_tr();
+  }
 
-  if (not info.Empty()) {
-    info.PlayerStatus = Utils::Blacklist;
+  if (time <= 0) {
+    return fmt::format("{:%Y-%m-%d %H:%M:%S}", fmt::localtime(time));
   }
-  return info;
+
+  return Utils::TimeUnix(time).ToString();
 }
 
 
-Utils::PlayerInfo
-BedrockWhiteList::Utils::PlayerDB::GetPlayerInfoAsUUID(string playerUuid) {
-  assert(m_tempSession);
+// - - - - - - Async commands - - - - - -
 
-  PlayerInfo info{};
 
+BedrockWhiteList::CommandReply::CommandReply(const CommandOrigin& origin) {
+  const auto entity = origin.getEntity();
+  if (entity != nullptr and entity->isType(ActorType::Player)) {
+    m_playerUuid = static_cast<Player*>(entity)->getUuid().asString();
+  }
+}
+
+
+void BedrockWhiteList::CommandReply::Success(string message) {
+  m_lines.emplace_back(true, std::move(message));
+}
+
+
+void BedrockWhiteList::CommandReply::Error(string message) {
+  m_lines.emplace_back(false, std::move(message));
+}
 
-  SQLite::Statement query(
-      *m_tempSession,
-      fmt::format(
-          FMT_COMPILE("SELECT * FROM whitelist WHERE player_uuid = \"{0}\""),
-          playerUuid.c_str()
-      )
-  );
-  __GetPlayerInfo(query, info);
-
-  Logger("debug").info(
-      "info,{3},{0},{1},{2}",
-      info.PlayerName,
-      info.PlayerUuid,
-      (int)info.LastTime.Time,
-      (int)info.PlayerStatus
-  );
 
-  if (not info.Empty()) {
-    info.PlayerStatus = Utils::Whitelist;
-    return info;
+void BedrockWhiteList::CommandReply::Send() const {
+  const auto level  = ll::service::getLevel();
+  const auto player = level and not m_playerUuid.empty()
+                        ? level->getPlayer(mce::UUID::fromString(m_playerUuid))
+                        : nullptr;
+
+  Logger logger("BEWhitelist.Command");
+  for (auto& [success, message] : m_lines) {
+    if (player != nullptr) {
+      player->sendMessage(success ? message : "§c" + message);
+    } else if (success) {
+      logger.info(message);
+    } else {
+      logger.error(message);
+    }
   }
+}
 
 
-  query = SQLite::Statement(
-      *m_tempSession,
-      fmt::format(
-          FMT_COMPILE("SELECT * FROM blacklist WHERE player_uuid = \"{0}\""),
-          playerUuid.c_str()
-      )
-  );
-  __GetPlayerInfo(query, info);
+typedef std::function<void(CommandReply&)> CommandWork;
 
-  if (not info.Empty()) {
-    info.PlayerStatus = Utils::Blacklist;
+
+// Suspends onto the command workers for work and comes back to the game
+// thread to reply, where after runs too.
+inline static Utils::AsyncTask
+RunCommand(CommandReply reply, CommandWork work, std::function<void()> after) {
+  const auto pool = g_config->GetCommandPool();
+  if (pool == nullptr) {
+    reply.Error("The database is not open yet. "_tr());
+    reply.Send();
+    co_return;
   }
 
-   Logger("debug").info(
-      "info,{3},{0},{1},{2}",
-      info.PlayerName,
-      info.PlayerUuid,
-      (int)info.LastTime.Time,
-      (int)info.PlayerStatus
-  );
+  co_await Utils::ResumeOn(*pool);
+
+  try {
+    work(reply);
+  } catch (std::exception& e) {
+    reply.Error("The command failed: {0}"_tr(e.what()));
+  }
 
+  co_await Utils::ResumeOn(g_mainThread);
 
-  return info;
+  reply.Send();
+  if (after) {
+    after();
+  }
 }
 
 
-vector<Utils::PlayerInfo>
-BedrockWhiteList::Utils::PlayerDB::GetPlayerListAsStatus(PlayerStatus status) {
-  assert(m_tempSession);
+// Commands that touch storage cost the tick only this: the result reaches
+// the player, or the log, a few ticks later.
+inline static void DispatchCommand(
+    const CommandOrigin&  origin,
+    CommandOutput&        output,
+    CommandWork           work,
+    std::function<void()> after = nullptr
+) {
+  output.success("Working on it, the result follows. "_tr());
+  RunCommand(CommandReply(origin), std::move(work), std::move(after));
+}
 
-  PlayerInfo         info{};
-  vector<PlayerInfo> infoList{};
-  char*              errMsg{};
 
+inline static void ChangeListMembers(
+    CommandOrigin const&                        origin,
+    CommandOutput&                              output,
+    BedrockWhiteList::ListMemberArgument const& args,
+    bool                                        add
+) {
+  if (not CheckAdminOrigin(origin) or not CheckLists(output)) {
+    return;
+  }
 
-  SQLite::Statement query(
-      *m_tempSession,
-      fmt::format(
-          FMT_COMPILE("SELECT * FROM {0}"),
-          status == PlayerStatus::Whitelist ? "whitlist" : "blacklist"
-      )
+  if (not g_config->GetLists()->Exists(args.name)) {
+    output.error("List {0} does not exist. "_tr(args.name));
+    return;
+  }
+
+  vector<string> playerUuids{};
+  for (auto player : args.targetPlayer.results(origin)) {
+    playerUuids.push_back(ListUuid(*player));
+  }
+
+  if (playerUuids.empty()) {
+    output.error("No player matches the selector. "_tr());
+    return;
+  }
+
+  DispatchCommand(
+      origin,
+      output,
+      [name = args.name, playerUuids, add](CommandReply& reply) {
+        const auto lists = g_config->GetLists();
+        const auto count = add ? lists->Add(name, playerUuids)
+                               : lists->Remove(name, playerUuids);
+
+        reply.Success(
+            add ? "Added {0} player(s) to {1}. "_tr(count, name)
+                : "Removed {0} player(s) from {1}. "_tr(count, name)
+        );
+      },
+      [playerUuids]() { EnforceOnline(playerUuids); }
   );
+}
+
 
-  while (__GetPlayerInfo(query, info)) {
-    info.PlayerStatus = status;
-    infoList.push_back(info);
+// Shared by the find overloads.
+inline static void FindPlayers(
+    CommandOrigin const& origin,
+    CommandOutput&       output,
+    Utils::PlayerQuery   query,
+    int                  limit
+) {
+  if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+    return;
   }
 
-  return infoList;
+  DispatchCommand(
+      origin,
+      output,
+      [query = std::move(query), limit](CommandReply& reply) {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        std::vector<Utils::PlayerInfo> players{};
+        const auto count = g_config->GetSeesion()->FindPlayers(
+            query,
+            static_cast<size_t>(0 < limit ? limit : 10),
+            players
+        );
+
+        reply.Success("Found {0} player(s) in {1} us{2}. "_tr(
+            count,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - startTime
+            )
+                .count(),
+            g_config->GetColumns() != nullptr ? ""
+                                              : ", without the query columns"_tr()
+        ));
+
+        for (auto& info : players) {
+          reply.Success(fmt::format(
+              "{0} ({1}): {2} until {3}{4}",
+              info.PlayerName,
+              info.PlayerUuid,
+              info.PlayerStatus == Utils::Whitelist ? "whitelist" : "blacklist",
+              FormatUnixTime(info.LastTime.Time),
+              info.Flags == Utils::AutoRecorded
+                  ? ", recorded " + FormatUnixTime(info.RecordedTime)
+                  : ""
+          ));
+        }
+      }
+  );
 }
 
 
@@ -277,10 +530,82 @@ BedrockWhiteList::Utils::PlayerDB::GetPlayerListAsStatus(PlayerStatus status) {
 // - - - - - - Plugin Config - - - - - -
 
 
+// days and groups may be one name or a sequence of them; a rule without
+// name is called after its position.
+inline static std::vector<Utils::RuleSource> ParseRules(const YAML::Node& rulesConf) {
+  std::vector<Utils::RuleSource> rules{};
+  if (not rulesConf.IsSequence()) {
+    return rules;
+  }
+
+  for (const auto& ruleConf : rulesConf) {
+    Utils::RuleSource rule{};
+    rule.Name = ruleConf["name"].as<string>(fmt::format("rule {}", rules.size() + 1));
+
+    const auto names = [](const YAML::Node& node, std::vector<string>& into) {
+      if (node.IsSequence()) {
+        for (const auto& name : node) {
+          into.push_back(name.as<string>());
+        }
+      } else if (node.IsScalar()) {
+        into.push_back(node.as<string>());
+      }
+    };
+
+    names(ruleConf["days"], rule.Days);
+    names(ruleConf["groups"], rule.Groups);
+
+    rule.Hours = ruleConf["hours"].as<string>("");
+    if (ruleConf["newcomer"].IsDefined()) {
+      rule.Newcomer = ruleConf["newcomer"].as<bool>() ? 1 : 0;
+    }
+    rule.Lists        = ruleConf["lists"].as<string>("");
+    rule.LimitPerHour = ruleConf["limitPerHour"].as<int>(0);
+    rule.Action       = ruleConf["action"].as<string>("allow");
+    rule.Message      = ruleConf["message"].as<string>("");
+
+    rules.push_back(std::move(rule));
+  }
+
+  return rules;
+}
+
+
 BedrockWhiteList::PluginConfig::PluginConfig() {
   database.path                 = "";
   database.useEncrypt           = false;
+  database.backend              = Utils::SQLiteStorage;
+  database.keyValuePath         = "";
+  database.shards               = 1;
   permission.enableCommandblock = false;
+  journal.enable                = true;
+  journal.path                  = "";
+  journal.maxSegmentSize        = 4 * 1024 * 1024;
+  journal.maxSegments           = 16;
+  journal.compactInterval       = 3600;
+  journal.retentionDays         = 90;
+  startup.warmupPolicy          = Utils::Hold;
+  startup.holdTimeout           = 3000;
+  connect.budgetMillis          = 50;
+  connect.fallbackPolicy        = Utils::FailClosed;
+  retention.enable              = true;
+  retention.newcomerTtl         = 7 * 24 * 3600;
+  retention.interval            = 600;
+  retention.batchSize           = 500;
+  retention.sliceMillis         = 5;
+  retention.vacuumPages         = 128;
+  lastSeen.enable               = true;
+  lastSeen.flushInterval        = 60;
+  backup.enable                 = true;
+  backup.path                   = "";
+  backup.interval               = 24 * 3600;
+  backup.keep                   = 7;
+  backup.pagesPerStep           = 64;
+  backup.stepPauseMillis        = 10;
+  backup.compress               = true;
+  lists.admission               = "whitelist";
+  commands.workers              = 2;
+  queries.columnar              = false;
 }
 
 
@@ -293,6 +618,19 @@ BedrockWhiteList::PluginConfig::PluginConfig(string configFile) {
   auto dbConf         = m_configObject["database"];
   database.useEncrypt = dbConf["useEncrypt"].as<bool>();
   database.path       = dbConf["path"].as<string>();
+  database.backend =
+      Utils::ParseStorageKind(dbConf["backend"].as<string>("sqlite"));
+  database.keyValuePath = dbConf["keyValuePath"].as<string>("");
+  database.shards       = std::clamp(
+      dbConf["shards"].as<int>(1),
+      1,
+      static_cast<int>(Utils::MAX_SHARDS)
+  );
+
+  if (database.keyValuePath.empty()) {
+    database.keyValuePath =
+        (filesystem::path(database.path).parent_path() / "players").string();
+  }
 
 
   auto permissionConf = m_configObject["permission"];
@@ -300,263 +638,2041 @@ BedrockWhiteList::PluginConfig::PluginConfig(string configFile) {
       permissionConf["enableCommandblock"].as<bool>();
 
 
-  m_pDatabase = new SQLite::Database(
-      database.path,
-      SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
-  );
-  m_pPlayerDB = new Utils::PlayerDB(m_pDatabase);
-}
+  // Sections added after the first release fall back to their defaults, so
+  // older config files keep loading.
+  auto journalConf        = m_configObject["journal"];
+  journal.enable          = journalConf["enable"].as<bool>(true);
+  journal.path            = journalConf["path"].as<string>("");
+  journal.maxSegmentSize  = journalConf["maxSegmentSize"].as<long long>(4194304);
+  journal.maxSegments     = journalConf["maxSegments"].as<int>(16);
+  journal.compactInterval = journalConf["compactInterval"].as<long long>(3600);
+  journal.retentionDays   = journalConf["retentionDays"].as<int>(90);
 
+  if (journal.path.empty()) {
+    journal.path =
+        (filesystem::path(database.path).parent_path() / "journal").string();
+  }
 
-BedrockWhiteList::PluginConfig::~PluginConfig() {
 
-  if (m_pDatabase != nullptr) {
+  auto startupConf     = m_configObject["startup"];
+  startup.warmupPolicy = Utils::ParseWarmupPolicy(
+      startupConf["warmupPolicy"].as<string>("hold")
+  );
+  startup.holdTimeout = startupConf["holdTimeout"].as<int>(3000);
 
-    if (m_pPlayerDB != nullptr) {
-      delete m_pPlayerDB;
-      m_pPlayerDB = nullptr;
-    }
 
-    delete m_pDatabase;
-    m_pDatabase = nullptr;
-  }
+  auto connectConf       = m_configObject["connect"];
+  connect.budgetMillis   = connectConf["budgetMillis"].as<int>(50);
+  connect.fallbackPolicy = Utils::ParseWarmupPolicy(
+      connectConf["fallbackPolicy"].as<string>("fail-closed")
+  );
 
+  m_pConnect = new Utils::ConnectHandler(
+      g_warmupGate,
+      {startup.warmupPolicy, std::chrono::milliseconds(startup.holdTimeout)}
+  );
 
-  if (m_configFile.empty()) {
-    return;
-  }
 
+  auto retentionConf    = m_configObject["retention"];
+  retention.enable      = retentionConf["enable"].as<bool>(true);
+  retention.newcomerTtl = retentionConf["newcomerTtl"].as<long long>(604800);
+  retention.interval    = retentionConf["interval"].as<long long>(600);
+  retention.batchSize   = retentionConf["batchSize"].as<int>(500);
+  retention.sliceMillis = retentionConf["sliceMillis"].as<int>(5);
+  retention.vacuumPages = retentionConf["vacuumPages"].as<int>(128);
 
-  std::ofstream outFile(m_configFile);
 
+  auto lastSeenConf      = m_configObject["lastSeen"];
+  lastSeen.enable        = lastSeenConf["enable"].as<bool>(true);
+  lastSeen.flushInterval = lastSeenConf["flushInterval"].as<long long>(60);
 
-  if (not outFile) {
-    return;
+
+  auto backupConf        = m_configObject["backup"];
+  backup.enable          = backupConf["enable"].as<bool>(true);
+  backup.path            = backupConf["path"].as<string>("");
+  backup.interval        = backupConf["interval"].as<long long>(86400);
+  backup.keep            = backupConf["keep"].as<int>(7);
+  backup.pagesPerStep    = backupConf["pagesPerStep"].as<int>(64);
+  backup.stepPauseMillis = backupConf["stepPauseMillis"].as<int>(10);
+  backup.compress        = backupConf["compress"].as<bool>(true);
+
+  if (backup.path.empty()) {
+    backup.path =
+        (filesystem::path(database.path).parent_path() / "backup").string();
   }
 
 
-  auto dbConf          = m_configObject["database"];
-  dbConf["path"]       = database.path;
-  dbConf["useEncrypt"] = database.useEncrypt;
+  auto listsConf  = m_configObject["lists"];
+  lists.admission = listsConf["admission"].as<string>("whitelist");
 
 
-  auto permissionConf                  = m_configObject["permission"];
-  permissionConf["enableCommandblock"] = permission.enableCommandblock;
+  rules = ParseRules(m_configObject["rules"]);
 
 
-  outFile << m_configObject << std::endl;
-  outFile.close();
-};
+  auto commandsConf = m_configObject["commands"];
+  commands.workers  = std::max(commandsConf["workers"].as<int>(2), 1);
 
 
-Utils::PlayerDB* BedrockWhiteList::PluginConfig::GetSeesion() {
-  return m_pPlayerDB;
+  auto queriesConf = m_configObject["queries"];
+  queries.columnar = queriesConf["columnar"].as<bool>(false);
 }
 
 
-// - - - - - - White List Core - - - - - -
-
+// Runs on the warm-up thread, the connect listener and commands wait on the
+// readiness gate before touching anything created here.
+void BedrockWhiteList::PluginConfig::OpenDatabase() {
+  if (database.path.empty()) {
+    throw std::runtime_error("Database path is not configured. ");
+  }
 
-bool BedrockWhiteList::WhiteList::load() {
 
-  const auto& manifest = getSelf().getManifest();
+  if (database.backend == Utils::SQLiteStorage) {
+    m_pDatabase = new SQLite::Database(
+        database.path,
+        SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+    );
+
+    // auto_vacuum only takes effect on a database without tables, that is a
+    // new one. WAL keeps readers going while the online migrations and other
+    // background writers hold the write lock.
+    m_pDatabase->exec("PRAGMA auto_vacuum = INCREMENTAL;");
+    m_pDatabase->exec("PRAGMA journal_mode = WAL;");
+    m_pDatabase->setBusyTimeout(250);
+
+    Utils::Migrator(*m_pDatabase, Utils::PlayerSchemaMigrations())
+        .Run(Utils::PLAYER_SCHEMA_BASELINE);
+
+    // The player rows move when database.shards changed since the last
+    // start, before anything reads them.
+    const auto stored = Utils::StoredShardCount(*m_pDatabase);
+    if (stored != static_cast<size_t>(database.shards)) {
+      Logger("BEWhitelist.Storage")
+          .info("Moving the player rows from {0} to {1} shard(s)... "_tr(
+              stored,
+              database.shards
+          ));
+    }
 
-  g_pluginInfo = fmt::format(
-      FMT_COMPILE(
-          "Plugin Information: \n"
-          "§a{0} §rv{1} {2}\n"
-          "§rRepository: §bhttps://github.com/Kamen-akio/BedrockWhitelist\n"
-          "§rDeveloper: {3}"
-      ),
-      manifest.name,
-      manifest.version->to_string(),
-      manifest.entry,
-      *manifest.author
-  );
+    const auto rebalance =
+        Utils::RebalanceShards(*m_pDatabase, database.path, database.shards);
+    if (rebalance.From != rebalance.To) {
+      Logger("BEWhitelist.Storage")
+          .info("Moved {0} player(s) into {1} shard(s) in {2} ms. "_tr(
+              rebalance.Rows,
+              rebalance.To,
+              rebalance.DurationMillis
+          ));
+    }
 
+    if (1 < database.shards) {
+      m_pStorage = new Utils::ShardedBackend(database.path, database.shards);
+    } else {
+      m_pStorage = new Utils::SQLiteBackend(*m_pDatabase);
+    }
+  } else {
+    m_pStorage = new Utils::KeyValueBackend(database.keyValuePath);
+  }
 
-  const auto& print    = getSelf().getLogger();
-  const int   maxWidth = 80;
-  string      welcomeTitle =
+  m_pPlayerDB = new Utils::PlayerDB(m_pStorage);
+  m_pPlayerDB->SetCache(&m_verdictCache);
 
-      "\n"
-      "\n"
-      "██     ██ ██   ██ ██ ████████ ██████ ██     ██ ██████ ████████\n"
-      "██     ██ ██   ██ ██    ██    ██     ██     ██ ██        ██   \n"
-      "██  █  ██ ███████ ██    ██    █████  ██     ██ ██████    ██   \n"
-      "██ ███ ██ ██   ██ ██    ██    ██     ██     ██     ██    ██   \n"
-      " ███ ███  ██   ██ ██    ██    ██████ ██████ ██ ██████    ██   \n"
-      "\n"
-      + fmt::format("{0:-^62}", "   Whitelist plugin for LeviLamina server   ")
-      + "\n"
-        "\n"
-        "\n";
 
-  istringstream iss(welcomeTitle);
-  string        output{};
-  while (std::getline(iss, output, '\n')) {
-    print.info("{0:^{1}}", output, maxWidth);
+  // Stored next to the lists and written at the pace of the last-seen
+  // times; counted from the rows when they were not stored by a clean
+  // shutdown, and on every start with the leveldb backend.
+  m_pCounters = new Utils::ListCounters(
+      m_pDatabase != nullptr ? database.path : string(),
+      lastSeen.flushInterval
+  );
+  m_pCounters->SetShards(database.shards);
+  m_pCounters->SetErrorCallback([](const std::exception& e) {
+    Logger("BEWhitelist.Counters")
+        .error("Counter flush failed: {0}"_tr(e.what()));
+  });
+  m_pPlayerDB->SetCounters(m_pCounters);
+
+  if (not m_pCounters->Load(std::time(nullptr))) {
+    const auto startTime = std::chrono::steady_clock::now();
+    m_pPlayerDB->RecountCounters();
+
+    Logger("BEWhitelist.Counters")
+        .info("Counted the lists in {0} ms. "_tr(ElapsedMillis(startTime)));
   }
 
 
-  // Internationalization
-  const string localePath{getSelf().getLangDir().string()};
+  // Off by default, it holds every row in memory for /_whitelist find.
+  if (queries.columnar) {
+    const auto startTime = std::chrono::steady_clock::now();
 
-  if (filesystem::exists(localePath)) {
-    i18n::load(localePath);
-    return true;
+    m_pColumns = new Utils::PlayerColumns();
+    m_pPlayerDB->SetColumns(m_pColumns);
+    const auto rows = m_pPlayerDB->LoadColumns();
+
+    Logger("BEWhitelist.Queries")
+        .info("Loaded {0} player(s) into the query columns in {1} ms. "_tr(
+            rows,
+            ElapsedMillis(startTime)
+        ));
   }
 
-  print.warn("Failed to find lang path! please reinstall the plugin. ");
 
-  return true;
-}
+  Utils::AdmissionController::Options admissionOptions{};
+  admissionOptions.budget   = std::chrono::milliseconds(connect.budgetMillis);
+  admissionOptions.fallback = connect.fallbackPolicy;
 
+  m_pAdmission = new Utils::AdmissionController(
+      *m_pPlayerDB,
+      m_verdictCache,
+      admissionOptions
+  );
 
-bool BedrockWhiteList::WhiteList::enable() {
+  // A verdict given without the database is checked again once the lookup
+  // finishes; an admitted player who should not have been is disconnected.
+  m_pAdmission->SetRecheckCallback([this](const auto& actual, const auto& given) {
+    const Utils::AdmissionVerdict verdict{
+        not actual.Empty() and actual.PlayerStatus == Utils::Whitelist,
+        Utils::AdmissionVerdict::Database,
+        actual
+    };
+
+    // Both through the rules and the list admission expression, as the
+    // listener saw them.
+    const auto& playerUuid = given.Info.PlayerUuid;
+    int         rule{-1};
+    const auto  admit =
+        m_pConnect->Admits(playerUuid, verdict, Utils::RuleEngine::Peek, &rule);
+    if (admit == m_pConnect->Admits(playerUuid, given)) {
+      return;
+    }
 
-  LoadConfig();
-  RegisterPlayerEvent();
-  RegisterCommand();
+    g_mainThread.Post([verdict, given, admit, rule]() {
+      Logger     logger("BEWhitelist.PlayerConnect");
+      const auto player = OnlinePlayer(given.Info.PlayerUuid);
+
+      if (player == nullptr) {
+        return;
+      }
+
+      if (admit) {
+        logger.info(
+            "{0} was turned away while the database was slow but is "
+            "whitelisted, they can reconnect now. "_tr(player->getName())
+        );
+        return;
+      }
+
+      const auto locale = player->getLocaleName();
+      player->disconnect(
+          0 <= rule       ? RuleMessage(rule, locale)
+          : verdict.Admit ? g_messages.Render(Utils::KickNotOnList, locale)
+                          : RejectMessage(verdict, locale)
+      );
+      logger.info(
+          "Re-check: {0} is not whitelisted and is disconnected. "_tr(
+              player->getName()
+          )
+      );
+    });
+  });
 
-  return true;
-}
 
+  if (journal.enable) {
+    Utils::AuditJournal::Options options{};
+    options.directory       = journal.path;
+    options.maxSegmentSize  = static_cast<uint64_t>(journal.maxSegmentSize);
+    options.maxSegments     = static_cast<uint32_t>(journal.maxSegments);
+    options.compactInterval = journal.compactInterval;
+    options.retention       = journal.retentionDays * 24ll * 3600;
 
-bool BedrockWhiteList::WhiteList::disable() {
-  delete g_config;
-  g_config = nullptr;
+    m_pJournal = new Utils::AuditJournal(options);
+    m_pJournal->Start();
+    m_pPlayerDB->SetJournal(m_pJournal);
+  }
 
-  return true;
-}
 
+  // The sweeper, the last-seen tracker, backups and named lists work on the
+  // SQLite file.
+  if (m_pDatabase == nullptr) {
+    Logger("BEWhitelist.Storage")
+        .warn(
+            "Retention, last-seen tracking, backups and named lists need the "
+            "sqlite backend and are off. "_tr()
+        );
+  }
 
-void BedrockWhiteList::WhiteList::LoadConfig() {
 
+  if (m_pDatabase != nullptr) {
+    m_pLists = new Utils::NamedLists(database.path);
+    m_pLists->Load();
+
+    string error{};
+    if (not m_pLists->SetAdmission(lists.admission, error)) {
+      Logger("BEWhitelist.Lists")
+          .error("lists.admission \"{0}\" is invalid ({1}), only the whitelist "
+                 "is let in. "_tr(lists.admission, error));
+    }
+  }
 
-  filesystem::path dataDir{getSelf().getDataDir()};
-  filesystem::path configDir{getSelf().getConfigDir()};
-  string           configPath{("." / configDir / "config.yaml").string()};
-  string           databasePath{(dataDir / "whitelist.sqlite3.db").string()};
 
+  // Without lists only rules that do not name any compile.
+  m_pRules = new Utils::RuleEngine();
+  if (string error{}; not m_pRules->Compile(rules, m_pLists, &g_groups, error)) {
+    Logger("BEWhitelist.Rules")
+        .error("The rules section is invalid ({0}), no rule applies. "_tr(error));
+  }
 
-  if (not(filesystem::exists(dataDir) and filesystem::exists(configDir))) {
-    filesystem::create_directory(dataDir);
-    filesystem::create_directory(configDir);
+
+  if (retention.enable and m_pDatabase != nullptr) {
+    Utils::RetentionSweeper::Options options{};
+    options.databasePath = database.path;
+    options.shards       = database.shards;
+    options.newcomerTtl  = retention.newcomerTtl;
+    options.interval     = retention.interval;
+    options.batchSize    = retention.batchSize;
+    options.sliceMillis  = retention.sliceMillis;
+    options.vacuumPages  = retention.vacuumPages;
+
+    m_pSweeper = new Utils::RetentionSweeper(options);
+
+    m_pSweeper->SetDeleteCallback([this](const auto& players) {
+      vector<string> playerUuids{};
+      playerUuids.reserve(players.size());
+
+      for (auto& player : players) {
+        playerUuids.push_back(player.PlayerUuid);
+
+        if (m_pJournal != nullptr) {
+          Utils::JournalRecord record{};
+          record.Actor       = "retention";
+          record.PlayerUuid  = player.PlayerUuid;
+          record.PlayerName  = player.PlayerName;
+          record.OldStatus   = Utils::Blacklist;
+          record.OldLastTime = player.LastTime;
+          m_pJournal->Append(std::move(record));
+        }
+      }
+
+      m_pPlayerDB->ForgetSwept(playerUuids);
+    });
+
+    m_pSweeper->SetReportCallback([](const auto& report) {
+      if (report.Deleted == 0 and report.VacuumedPages == 0) {
+        return;
+      }
+
+      Logger("BEWhitelist.Retention")
+          .info(
+              "Removed {0} expired newcomers in {1} ms ({2} slices, longest "
+              "{3} us), {4} pages released. "_tr(
+                  report.Deleted,
+                  report.DurationMillis,
+                  report.Slices,
+                  report.LongestSliceMicros,
+                  report.VacuumedPages
+              )
+          );
+    });
+
+    m_pSweeper->SetErrorCallback([](const std::exception& e) {
+      Logger("BEWhitelist.Retention")
+          .error("Retention sweep failed: {0}"_tr(e.what()));
+    });
   }
 
 
-  if (not filesystem::exists(configPath)) {
+  if (lastSeen.enable and m_pDatabase != nullptr) {
+    m_pLastSeen =
+        new Utils::LastSeenTracker(database.path, lastSeen.flushInterval);
+    m_pLastSeen->SetShards(database.shards);
 
-    // Just like open config with the openmode "w+".
-    fstream ss(configPath, std::ios::in | std::ios::out | std::ios::trunc);
+    m_pLastSeen->SetErrorCallback([](const std::exception& e) {
+      Logger("BEWhitelist.LastSeen")
+          .error("Last-seen flush failed: {0}"_tr(e.what()));
+    });
+  }
 
 
-    if (not ss.is_open()) {
-      throw std::runtime_error("Cannot create config file. "_tr());
-    }
+  // Written at the pace of the last-seen times, whether those are on or not.
+  if (m_pDatabase != nullptr) {
+    m_pIdentities =
+        new Utils::IdentityIndex(database.path, lastSeen.flushInterval);
+
+    m_pIdentities->SetErrorCallback([](const std::exception& e) {
+      Logger("BEWhitelist.Identity")
+          .error("Identity flush failed: {0}"_tr(e.what()));
+    });
+    m_pIdentities->Load();
+  }
 
 
-    YAML::Node config;
+  if (backup.enable and m_pDatabase != nullptr) {
+    Utils::OnlineBackup::Options options{};
+    options.databasePath    = database.path;
+    options.shards          = database.shards;
+    options.directory       = backup.path;
+    options.interval        = backup.interval;
+    options.keep            = backup.keep;
+    options.pagesPerStep    = backup.pagesPerStep;
+    options.stepPauseMillis = backup.stepPauseMillis;
+    options.compress        = backup.compress;
+
+    m_pBackup = new Utils::OnlineBackup(options);
+
+    m_pBackup->SetReportCallback([](const auto& report) {
+      Logger("BEWhitelist.Backup")
+          .info(
+              "Backed up {0} pages to {1} ({2} bytes) in {3} ms, {4} steps, "
+              "{5} restarts. "_tr(
+                  report.Pages,
+                  report.File,
+                  report.Bytes,
+                  report.DurationMillis,
+                  report.Steps,
+                  report.Restarts
+              )
+          );
+    });
+
+    m_pBackup->SetErrorCallback([](const std::exception& e) {
+      Logger("BEWhitelist.Backup").error("Backup failed: {0}"_tr(e.what()));
+    });
+  }
 
-    // Database config.
-    YAML::Node database;
-    database["path"]       = databasePath;
-    database["useEncrypt"] = false;
+
+  // Storage work of the commands, the game thread only dispatches it.
+  m_pCommandPool = new Utils::WorkerPool(static_cast<size_t>(commands.workers));
+
+
+  if (m_pConnect != nullptr) {
+    m_pConnect->Attach(
+        m_pAdmission,
+        m_pLastSeen,
+        m_pLists,
+        m_pRules,
+        m_pIdentities,
+        m_pCounters
+    );
+
+    // Changes made from here on reach the players already online.
+    m_pEnforcement =
+        new Utils::EnforcementSweep(g_online, *m_pConnect, *m_pPlayerDB);
+    m_pPlayerDB->SetChangeCallback([](const auto& changed) {
+      EnforceOnline(changed);
+    });
+  }
+}
+
+
+// Background work that needs the full schema, started by the warm-up thread
+// after the readiness gate opened.
+void BedrockWhiteList::PluginConfig::StartBackgroundTasks() {
+  if (m_pSweeper != nullptr) {
+    m_pSweeper->Start();
+  }
+
+  if (m_pLastSeen != nullptr) {
+    m_pLastSeen->Start();
+  }
+
+  if (m_pIdentities != nullptr) {
+    m_pIdentities->Start();
+  }
+
+  if (m_pCounters != nullptr) {
+    m_pCounters->Start();
+  }
+
+  if (m_pBackup != nullptr) {
+    m_pBackup->Start();
+  }
+}
+
+
+// Also writes the pending last-seen times, so nothing is lost on disable.
+void BedrockWhiteList::PluginConfig::StopBackgroundTasks() {
+  if (m_pSweeper != nullptr) {
+    m_pSweeper->Stop();
+  }
+
+  if (m_pLastSeen != nullptr) {
+    m_pLastSeen->Stop();
+  }
+
+  if (m_pIdentities != nullptr) {
+    m_pIdentities->Stop();
+  }
+
+  if (m_pBackup != nullptr) {
+    m_pBackup->Stop();
+  }
+}
+
+
+BedrockWhiteList::PluginConfig::~PluginConfig() {
+
+  StopBackgroundTasks();
+
+  // Finishes the running commands, which may still write through the rest.
+  if (m_pCommandPool != nullptr) {
+    delete m_pCommandPool;
+    m_pCommandPool = nullptr;
+  }
+
+  if (m_pEnforcement != nullptr) {
+    m_pPlayerDB->SetChangeCallback(nullptr);
+
+    delete m_pEnforcement;
+    m_pEnforcement = nullptr;
+  }
+
+  if (m_pConnect != nullptr) {
+    delete m_pConnect;
+    m_pConnect = nullptr;
+  }
+
+  // Finishes queued newcomer writes, which still need the journal.
+  if (m_pAdmission != nullptr) {
+    delete m_pAdmission;
+    m_pAdmission = nullptr;
+  }
+
+  // Stored complete only after the last write to the lists.
+  if (m_pCounters != nullptr) {
+    m_pPlayerDB->SetCounters(nullptr);
+
+    delete m_pCounters;
+    m_pCounters = nullptr;
+  }
+
+  if (m_pSweeper != nullptr) {
+    delete m_pSweeper;
+    m_pSweeper = nullptr;
+  }
+
+  // After the sweeper, which erases from them.
+  if (m_pColumns != nullptr) {
+    m_pPlayerDB->SetColumns(nullptr);
+
+    delete m_pColumns;
+    m_pColumns = nullptr;
+  }
+
+  if (m_pRules != nullptr) {
+    delete m_pRules;
+    m_pRules = nullptr;
+  }
+
+  if (m_pLists != nullptr) {
+    delete m_pLists;
+    m_pLists = nullptr;
+  }
+
+  if (m_pLastSeen != nullptr) {
+    delete m_pLastSeen;
+    m_pLastSeen = nullptr;
+  }
+
+  if (m_pIdentities != nullptr) {
+    delete m_pIdentities;
+    m_pIdentities = nullptr;
+  }
+
+  if (m_pBackup != nullptr) {
+    delete m_pBackup;
+    m_pBackup = nullptr;
+  }
+
+
+  // Drains the queued records before the database goes away.
+  if (m_pJournal != nullptr) {
+    delete m_pJournal;
+    m_pJournal = nullptr;
+  }
+
+
+  if (m_pPlayerDB != nullptr) {
+    delete m_pPlayerDB;
+    m_pPlayerDB = nullptr;
+  }
+
+  if (m_pStorage != nullptr) {
+    delete m_pStorage;
+    m_pStorage = nullptr;
+  }
+
+  if (m_pDatabase != nullptr) {
+    delete m_pDatabase;
+    m_pDatabase = nullptr;
+  }
+
+
+  if (m_configFile.empty()) {
+    return;
+  }
+
+
+  std::ofstream outFile(m_configFile);
+
+
+  if (not outFile) {
+    return;
+  }
+
+
+  auto dbConf            = m_configObject["database"];
+  dbConf["path"]         = database.path;
+  dbConf["useEncrypt"]   = database.useEncrypt;
+  dbConf["backend"]      = Utils::StorageKindName(database.backend);
+  dbConf["keyValuePath"] = database.keyValuePath;
+  dbConf["shards"]       = database.shards;
+
+
+  auto permissionConf                  = m_configObject["permission"];
+  permissionConf["enableCommandblock"] = permission.enableCommandblock;
+
+
+  auto journalConf               = m_configObject["journal"];
+  journalConf["enable"]          = journal.enable;
+  journalConf["path"]            = journal.path;
+  journalConf["maxSegmentSize"]  = journal.maxSegmentSize;
+  journalConf["maxSegments"]     = journal.maxSegments;
+  journalConf["compactInterval"] = journal.compactInterval;
+  journalConf["retentionDays"]   = journal.retentionDays;
+
+
+  auto startupConf            = m_configObject["startup"];
+  startupConf["warmupPolicy"] = Utils::WarmupPolicyName(startup.warmupPolicy);
+  startupConf["holdTimeout"]  = startup.holdTimeout;
+
+
+  auto connectConf              = m_configObject["connect"];
+  connectConf["budgetMillis"]   = connect.budgetMillis;
+  connectConf["fallbackPolicy"] = Utils::WarmupPolicyName(connect.fallbackPolicy);
+
+
+  auto retentionConf           = m_configObject["retention"];
+  retentionConf["enable"]      = retention.enable;
+  retentionConf["newcomerTtl"] = retention.newcomerTtl;
+  retentionConf["interval"]    = retention.interval;
+  retentionConf["batchSize"]   = retention.batchSize;
+  retentionConf["sliceMillis"] = retention.sliceMillis;
+  retentionConf["vacuumPages"] = retention.vacuumPages;
+
+
+  auto lastSeenConf             = m_configObject["lastSeen"];
+  lastSeenConf["enable"]        = lastSeen.enable;
+  lastSeenConf["flushInterval"] = lastSeen.flushInterval;
+
+
+  auto backupConf               = m_configObject["backup"];
+  backupConf["enable"]          = backup.enable;
+  backupConf["path"]            = backup.path;
+  backupConf["interval"]        = backup.interval;
+  backupConf["keep"]            = backup.keep;
+  backupConf["pagesPerStep"]    = backup.pagesPerStep;
+  backupConf["stepPauseMillis"] = backup.stepPauseMillis;
+  backupConf["compress"]        = backup.compress;
+
+
+  auto listsConf         = m_configObject["lists"];
+  listsConf["admission"] = lists.admission;
+
+
+  auto commandsConf       = m_configObject["commands"];
+  commandsConf["workers"] = commands.workers;
+
+
+  auto queriesConf        = m_configObject["queries"];
+  queriesConf["columnar"] = queries.columnar;
+
+
+  outFile << m_configObject << std::endl;
+  outFile.close();
+};
+
+
+// Applies the migrations after the baseline on a connection of its own,
+// while the plugin already serves reads through the main one.
+bool BedrockWhiteList::PluginConfig::MigrateOnline(
+    const std::atomic<bool>&     stop,
+    Utils::Migrator::LogCallback log
+) {
+  if (database.backend != Utils::SQLiteStorage) {
+    return true;
+  }
+
+  // The shard files hold the player rows, the main one everything else.
+  auto paths = vector<string>{database.path};
+  if (1 < database.shards) {
+    const auto shards = Utils::RowDatabasePaths(database.path, database.shards);
+    paths.insert(paths.end(), shards.begin(), shards.end());
+  }
+
+  for (auto& path : paths) {
+    SQLite::Database session(path, SQLite::OPEN_READWRITE, 5000);
+
+    Utils::Migrator migrator(session, Utils::PlayerSchemaMigrations());
+    migrator.SetLogCallback(log);
+
+    if (not migrator.Run(-1, &stop)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+Utils::PlayerDB* BedrockWhiteList::PluginConfig::GetSeesion() {
+  return m_pPlayerDB;
+}
+
+
+Utils::AuditJournal* BedrockWhiteList::PluginConfig::GetJournal() {
+  return m_pJournal;
+}
+
+
+Utils::VerdictCache* BedrockWhiteList::PluginConfig::GetCache() {
+  return &m_verdictCache;
+}
+
+
+Utils::LastSeenTracker* BedrockWhiteList::PluginConfig::GetLastSeen() {
+  return m_pLastSeen;
+}
+
+
+Utils::OnlineBackup* BedrockWhiteList::PluginConfig::GetBackup() {
+  return m_pBackup;
+}
+
+
+Utils::AdmissionController* BedrockWhiteList::PluginConfig::GetAdmission() {
+  return m_pAdmission;
+}
+
+
+Utils::ConnectHandler* BedrockWhiteList::PluginConfig::GetConnect() {
+  return m_pConnect;
+}
+
+
+Utils::NamedLists* BedrockWhiteList::PluginConfig::GetLists() {
+  return m_pLists;
+}
+
+
+Utils::RuleEngine* BedrockWhiteList::PluginConfig::GetRules() {
+  return m_pRules;
+}
+
+
+Utils::EnforcementSweep* BedrockWhiteList::PluginConfig::GetEnforcement() {
+  return m_pEnforcement;
+}
+
+
+Utils::IdentityIndex* BedrockWhiteList::PluginConfig::GetIdentities() {
+  return m_pIdentities;
+}
+
+
+Utils::ListCounters* BedrockWhiteList::PluginConfig::GetCounters() {
+  return m_pCounters;
+}
+
+
+// Null unless queries.columnar is on.
+Utils::PlayerColumns* BedrockWhiteList::PluginConfig::GetColumns() {
+  return m_pColumns;
+}
+
+
+// Null unless the rows are spread over several files.
+Utils::ShardedBackend* BedrockWhiteList::PluginConfig::GetShards() {
+  if (m_pDatabase == nullptr or database.shards <= 1) {
+    return nullptr;
+  }
+
+  return static_cast<Utils::ShardedBackend*>(m_pStorage);
+}
+
+
+Utils::WorkerPool* BedrockWhiteList::PluginConfig::GetCommandPool() {
+  return m_pCommandPool;
+}
+
+
+bool BedrockWhiteList::PluginConfig::ReloadRules(string& error) {
+  if (m_pRules == nullptr) {
+    error = "the database is not open yet";
+    return false;
+  }
+
+  YAML::Node                     configObject{};
+  std::vector<Utils::RuleSource> reloaded{};
+  string                         admission{};
+
+  try {
+    configObject = YAML::LoadFile(m_configFile);
+    reloaded     = ParseRules(configObject["rules"]);
+    admission    = configObject["lists"]["admission"].as<string>("whitelist");
+  } catch (const YAML::Exception& e) {
+    error = e.what();
+    return false;
+  }
+
+  // Neither is applied unless both compile: the admission is only checked
+  // before the rules go in. Lists are created and dropped by commands on
+  // this thread too, so setting it afterwards fails no more than the check.
+  if (m_pLists != nullptr and not m_pLists->CheckAdmission(admission, error)) {
+    error = "lists.admission: " + error;
+    return false;
+  }
+
+  if (not m_pRules->Compile(reloaded, m_pLists, &g_groups, error)) {
+    return false;
+  }
+
+  if (m_pLists != nullptr and not m_pLists->SetAdmission(admission, error)) {
+    error = "lists.admission: " + error;
+    return false;
+  }
+
+
+  // Written back as read, the destructor saves m_configObject.
+  rules                                = std::move(reloaded);
+  lists.admission                      = admission;
+  m_configObject["rules"]              = configObject["rules"];
+  m_configObject["lists"]["admission"] = admission;
+  return true;
+}
+
+
+std::unique_ptr<Utils::StorageBackend>
+BedrockWhiteList::PluginConfig::OpenStorage(Utils::StorageKind kind) {
+  if (kind == Utils::KeyValueStorage) {
+    return std::make_unique<Utils::KeyValueBackend>(database.keyValuePath);
+  }
+
+  if (1 < database.shards) {
+    return std::make_unique<Utils::ShardedBackend>(database.path, database.shards);
+  }
+
+  auto session = std::make_unique<SQLite::Database>(
+      database.path,
+      SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE,
+      5000
+  );
+  Utils::Migrator(*session, Utils::PlayerSchemaMigrations())
+      .Run(Utils::PLAYER_SCHEMA_BASELINE);
+
+  return std::make_unique<Utils::SQLiteBackend>(std::move(session));
+}
+
+
+// - - - - - - White List Core - - - - - -
+
+
+bool BedrockWhiteList::WhiteList::load() {
+
+  const auto& manifest = getSelf().getManifest();
+
+  g_pluginInfo = fmt::format(
+      FMT_COMPILE(
+          "Plugin Information: \n"
+          "§a{0} §rv{1} {2}\n"
+          "§rRepository: §bhttps://github.com/Kamen-akio/BedrockWhitelist\n"
+          "§rDeveloper: {3}"
+      ),
+      manifest.name,
+      manifest.version->to_string(),
+      manifest.entry,
+      *manifest.author
+  );
+
+
+  const auto& print    = getSelf().getLogger();
+  const int   maxWidth = 80;
+  string      welcomeTitle =
+
+      "\n"
+      "\n"
+      "██     ██ ██   ██ ██ ████████ ██████ ██     ██ ██████ ████████\n"
+      "██     ██ ██   ██ ██    ██    ██     ██     ██ ██        ██   \n"
+      "██  █  ██ ███████ ██    ██    █████  ██     ██ ██████    ██   \n"
+      "██ ███ ██ ██   ██ ██    ██    ██     ██     ██     ██    ██   \n"
+      " ███ ███  ██   ██ ██    ██    ██████ ██████ ██ ██████    ██   \n"
+      "\n"
+      + fmt::format("{0:-^62}", "   Whitelist plugin for LeviLamina server   ")
+      + "\n"
+        "\n"
+        "\n";
+
+  istringstream iss(welcomeTitle);
+  string        output{};
+  while (std::getline(iss, output, '\n')) {
+    print.info("{0:^{1}}", output, maxWidth);
+  }
+
+
+  // Internationalization
+  const string localePath{getSelf().getLangDir().string()};
+
+  if (filesystem::exists(localePath)) {
+    LoadMessages(localePath);
+    return true;
+  }
+
+  print.warn("Failed to find lang path! please reinstall the plugin. ");
+
+  return true;
+}
+
+
+bool BedrockWhiteList::WhiteList::enable() {
+  const auto startTime = std::chrono::steady_clock::now();
+  g_gameThread         = std::this_thread::get_id();
+
+  Utils::AsyncTask::SetErrorHandler([](const std::exception& e) {
+    Logger("BEWhitelist.Command").error("A command failed: {0}"_tr(e.what()));
+  });
+
+  LoadConfig();
+  RegisterPlayerEvent();
+  RegisterCommand();
+  StartWarmup();
+
+  g_scheduler.add<ll::schedule::RepeatTask>(ll::chrono::ticks(1), []() {
+    g_mainThread.Drain();
+  });
+
+  getSelf().getLogger().info(
+      "Plugin enabled in {0} ms, the database warms up in background. "_tr(
+          ElapsedMillis(startTime)
+      )
+  );
+
+  return true;
+}
+
+
+bool BedrockWhiteList::WhiteList::disable() {
+  g_shutdown = true;
+
+  if (g_warmupThread.joinable()) {
+    g_warmupThread.join();
+  }
+
+  delete g_config;
+  g_config = nullptr;
+
+  g_scheduler.clear();
+
+  return true;
+}
+
+
+void BedrockWhiteList::WhiteList::LoadConfig() {
+
+
+  filesystem::path dataDir{getSelf().getDataDir()};
+  filesystem::path configDir{getSelf().getConfigDir()};
+  string           configPath{("." / configDir / "config.yaml").string()};
+  string           databasePath{(dataDir / "whitelist.sqlite3.db").string()};
+
+
+  if (not(filesystem::exists(dataDir) and filesystem::exists(configDir))) {
+    filesystem::create_directory(dataDir);
+    filesystem::create_directory(configDir);
+  }
+
+
+  if (not filesystem::exists(configPath)) {
+
+    // Just like open config with the openmode "w+".
+    fstream ss(configPath, std::ios::in | std::ios::out | std::ios::trunc);
+
+
+    if (not ss.is_open()) {
+      throw std::runtime_error("Cannot create config file. "_tr());
+    }
+
+
+    YAML::Node config;
+
+    // Database config.
+    YAML::Node database;
+    database["path"]         = databasePath;
+    database["useEncrypt"]   = false;
+    database["backend"]      = "sqlite";
+    database["keyValuePath"] = (dataDir / "players").string();
+    database["shards"]       = 1;
 
     config["database"] = database;
 
 
-    YAML::Node permission;
-    permission["enableCommandblock"] = false;
+    YAML::Node permission;
+    permission["enableCommandblock"] = false;
+
+    config["permission"] = permission;
+
+
+    YAML::Node startup;
+    startup["warmupPolicy"] = "hold";
+    startup["holdTimeout"]  = 3000;
+
+    config["startup"] = startup;
+
+
+    YAML::Node connect;
+    connect["budgetMillis"]   = 50;
+    connect["fallbackPolicy"] = "fail-closed";
+
+    config["connect"] = connect;
+
+
+    YAML::Node retention;
+    retention["enable"]      = true;
+    retention["newcomerTtl"] = 604800;
+    retention["interval"]    = 600;
+    retention["batchSize"]   = 500;
+    retention["sliceMillis"] = 5;
+    retention["vacuumPages"] = 128;
+
+    config["retention"] = retention;
+
+
+    YAML::Node lastSeen;
+    lastSeen["enable"]        = true;
+    lastSeen["flushInterval"] = 60;
+
+    config["lastSeen"] = lastSeen;
+
+
+    YAML::Node backup;
+    backup["enable"]          = true;
+    backup["path"]            = (dataDir / "backup").string();
+    backup["interval"]        = 86400;
+    backup["keep"]            = 7;
+    backup["pagesPerStep"]    = 64;
+    backup["stepPauseMillis"] = 10;
+    backup["compress"]        = true;
+
+    config["backup"] = backup;
+
+
+    YAML::Node lists;
+    lists["admission"] = "whitelist";
+
+    config["lists"] = lists;
+
+
+    config["rules"] = YAML::Node(YAML::NodeType::Sequence);
+
+
+    YAML::Node commands;
+    commands["workers"] = 2;
+
+    config["commands"] = commands;
+
+
+    YAML::Node queries;
+    queries["columnar"] = false;
+
+    config["queries"] = queries;
+
+
+    YAML::Node journal;
+    journal["enable"]          = true;
+    journal["path"]            = (dataDir / "journal").string();
+    journal["maxSegmentSize"]  = 4194304;
+    journal["maxSegments"]     = 16;
+    journal["compactInterval"] = 3600;
+    journal["retentionDays"]   = 90;
+
+    config["journal"] = journal;
+
+
+    ss << config << std::endl;
+    ss.close();
+  }
+
+
+  try {
+
+    auto config = new PluginConfig(configPath);
+    delete g_config;
+    g_config = config;
+
+  } catch (std::exception) {
+    getSelf().getLogger().warn("Incorrect config file. "_tr());
+  }
+}
+
+
+void BedrockWhiteList::WhiteList::StartWarmup() {
+  g_warmupThread = std::thread([this]() {
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto& logger   = getSelf().getLogger();
+
+    try {
+
+      g_config->OpenDatabase();
+      const auto count =
+          g_config->GetSeesion()->Preload(*g_config->GetCache());
+
+      g_warmupGate.Open();
+      g_config->StartBackgroundTasks();
+
+      logger.info(
+          "Database warm-up finished in {0} ms, {1} verdicts preloaded. "_tr(
+              ElapsedMillis(startTime),
+              count
+          )
+      );
+
+    } catch (std::exception& e) {
+      g_warmupGate.Fail();
+      logger.error("Database warm-up failed: {0}"_tr(e.what()));
+      return;
+    }
+
+
+    try {
+
+      const auto migrationTime = std::chrono::steady_clock::now();
+      const auto finished      = g_config->MigrateOnline(
+          g_shutdown,
+          [&logger](const string& message) { logger.info(message); }
+      );
+
+      if (finished) {
+        logger.debug(
+            "Online schema migrations finished in {0} ms. "_tr(
+                ElapsedMillis(migrationTime)
+            )
+        );
+      } else {
+        logger.info(
+            "Online schema migration paused, it resumes on the next start. "_tr()
+        );
+      }
+
+    } catch (std::exception& e) {
+      logger.error("Online schema migration failed: {0}"_tr(e.what()));
+    }
+  });
+}
+
+
+void BedrockWhiteList::WhiteList::RegisterCommand() {
+  const auto commandRegistry = service::getCommandRegistry();
+  if (!commandRegistry) {
+    throw std::runtime_error("Failed to get command registry. "_tr());
+  }
+
+
+  auto& commandBridge = command::CommandRegistrar::getInstance();
+  auto& command       = commandBridge.getOrCreateCommand(
+      PLUGIN_NAME,
+      PLUGIN_DESCRIPTION,
+      CommandPermissionLevel::Any
+  );
+  command.alias(PLUGIN_ALIAS);
+
+
+  /* overload: 2
+   * mode: info(optional)
+   * permission: Any
+   */
+  auto helpCmdCallback = [&](CommandOrigin const& origin,
+                             CommandOutput&       output) {
+    if (CheckOriginAs(origin, {CommandOriginType::Player})) {
+      const auto& entity = origin.getEntity();
+      static_cast<Player*>(entity)->sendMessage(g_pluginInfo);
+      static_cast<Player*>(entity)->sendMessage(fmt::format(
+          "Debug:\n"
+          "System ID: {0}",
+          Utils::Windows::GetDeviceToken()
+      ));
+    }
+  };
+  command.overload().execute<helpCmdCallback>();
+  command.overload().text("info").execute<helpCmdCallback>();
+
+
+  /* overload: 1
+   * mode: set
+   * arguments:
+   *         1: Player -- targetPlayer
+   *         2: Enum   -- whitelist / blacklist
+   *         3: Int    -- minutes until the ban expires, blacklist only (optional)
+   *         4: String -- reason, kept with the player's history (optional)
+   * permission: Operator
+   */
+  command.overload<BedrockWhiteList::WhitelistArgument>()
+      .text("set")
+      .required("targetPlayer")
+      .required("list")
+      .optional("time")
+      .optional("reason")
+      .execute<[&](CommandOrigin const&     origin,
+                   CommandOutput&           output,
+                   WhitelistArgument const& args) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto status    = args.list == WhitelistListType::whitelist
+                                 ? Utils::Whitelist
+                                 : Utils::Blacklist;
+
+        // Only a ban runs out; nothing reads the time of a whitelist row.
+        if (status == Utils::Whitelist and 0 < args.time) {
+          output.error("Only a blacklist entry can have a time. "_tr());
+          return;
+        }
+
+        const auto lastTime =
+            0 < args.time ? std::time(nullptr) + args.time * 60ll : -1;
+
+
+        vector<Utils::PlayerInfo> batch{};
+        for (auto player : args.targetPlayer.results(origin)) {
+          batch.emplace_back(
+              status,
+              player->getRealName(),
+              ListUuid(*player),
+              lastTime
+          );
+        }
+
+        if (batch.empty()) {
+          output.error("No player matches the selector. "_tr());
+          return;
+        }
+
+
+        DispatchCommand(
+            origin,
+            output,
+            [batch,
+             actor  = origin.getName(),
+             reason = args.reason,
+             status,
+             startTime](CommandReply& reply) {
+              const auto count = g_config->GetSeesion()->SetPlayerInfoBatch(
+                  batch,
+                  actor,
+                  nullptr,
+                  reason
+              );
+
+              reply.Success("Set {0} player(s) to the {1} in {2} ms. "_tr(
+                  count,
+                  status == Utils::Whitelist ? "whitelist" : "blacklist",
+                  ElapsedMillis(startTime)
+              ));
+            }
+        );
+      }>();
+
+
+  /* overload: 1
+   * mode: get
+   * arguments:
+   *         1: String -- player name or uuid
+   *         2: Int    -- max history records (optional)
+   * permission: Operator
+   */
+  command.overload<BedrockWhiteList::PlayerArgument>()
+      .text("get")
+      .required("player")
+      .optional("limit")
+      .execute<[&](CommandOrigin const&  origin,
+                   CommandOutput&        output,
+                   PlayerArgument const& args) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+        DispatchCommand(origin, output, [args](CommandReply& reply) {
+          const auto info = FindPlayer(args.player);
+          if (info.Empty()) {
+            reply.Error("Player {0} is not found. "_tr(args.player));
+            return;
+          }
+
+          reply.Success("{0} ({1}): {2} until {3}. "_tr(
+              info.PlayerName,
+              info.PlayerUuid,
+              info.PlayerStatus == Utils::Whitelist ? "whitelist" : "blacklist",
+              FormatUnixTime(info.LastTime.Time)
+          ));
+
+
+          // The only place the cold metadata is read.
+          Utils::PlayerMeta meta{};
+          if (not g_config->GetSeesion()->GetPlayerMeta(
+                  info.PlayerUuid,
+                  meta,
+                  0 < args.limit ? args.limit : 5
+              )) {
+            return;
+          }
+
+          if (not meta.Issuer.empty()) {
+            reply.Success("Reason: {0}, by {1}. "_tr(
+                meta.Reason.empty() ? "-" : meta.Reason,
+                meta.Issuer
+            ));
+          }
+
+          if (not meta.Notes.empty()) {
+            reply.Success("Notes: {0}"_tr(meta.Notes));
+          }
+
+          for (auto& record : meta.History) {
+            reply.Success(fmt::format(
+                "[{0}] {1}: {2} {3} {4}",
+                FormatUnixTime(record.Time),
+                record.Actor,
+                record.Status == Utils::Whitelist ? "whitelist" : "blacklist",
+                FormatUnixTime(record.LastTime),
+                record.Reason
+            ));
+          }
+        });
+      }>();
+
+
+  /* overload: 1
+   * mode: note
+   * arguments:
+   *         1: String -- player name or uuid
+   *         2: String -- notes, replacing the previous ones
+   * permission: Operator
+   */
+  command.overload<BedrockWhiteList::NoteArgument>()
+      .text("note")
+      .required("player")
+      .required("notes")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   NoteArgument const&  args) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+        DispatchCommand(origin, output, [args](CommandReply& reply) {
+          const auto info = FindPlayer(args.player);
+          if (info.Empty()) {
+            reply.Error("Player {0} is not found. "_tr(args.player));
+            return;
+          }
+
+          g_config->GetSeesion()->SetPlayerNotes(info.PlayerUuid, args.notes);
+          reply.Success("Notes of {0} are saved. "_tr(info.PlayerName));
+        });
+      }>();
+
+
+  /* overload: 1
+   * mode: whois
+   * arguments:
+   *         1: String -- xuid, uuid, or a current or former name
+   *         2: Int    -- max names shown (optional)
+   * permission: Operator
+   */
+  command.overload<BedrockWhiteList::PlayerArgument>()
+      .text("whois")
+      .required("player")
+      .optional("limit")
+      .execute<[&](CommandOrigin const&  origin,
+                   CommandOutput&        output,
+                   PlayerArgument const& args) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+        if (g_config->GetIdentities() == nullptr) {
+          output.error("Identities need the sqlite backend. "_tr());
+          return;
+        }
+
+        DispatchCommand(origin, output, [args](CommandReply& reply) {
+          const auto found = g_config->GetIdentities()->Find(
+              args.player,
+              static_cast<size_t>(0 < args.limit ? args.limit : 5)
+          );
 
-    config["permission"] = permission;
+          if (found.empty()) {
+            reply.Error("Player {0} is not found. "_tr(args.player));
+            return;
+          }
 
+          for (auto& identity : found) {
+            reply.Success("{0}: xuid {1}, uuid {2}, first seen {3}. "_tr(
+                identity.PlayerName,
+                identity.Xuid,
+                identity.PlayerUuid,
+                FormatUnixTime(identity.FirstSeen)
+            ));
+
+            for (auto& name : identity.Names) {
+              reply.Success(
+                  "  {0} (since {1})"_tr(name.Name, FormatUnixTime(name.Since))
+              );
+            }
+          }
+        });
+      }>();
 
-    ss << config << std::endl;
-    ss.close();
-  }
 
+  /* overload: 5
+   * mode: list [create | delete | add | remove]
+   * arguments:
+   *         1: String -- list name
+   *         2: Player -- targetPlayer, for add and remove
+   * permission: Operator
+   */
+  command.overload()
+      .text("list")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin) or not CheckLists(output)) {
+          return;
+        }
 
-  try {
+        const auto summary = g_config->GetLists()->Summary();
+        output.success("{0} list(s), admission: {1}"_tr(
+            summary.size(),
+            g_config->lists.admission
+        ));
 
-    g_config = new PluginConfig(configPath);
+        for (auto& [name, count] : summary) {
+          output.success(fmt::format("{0}: {1}", name, count));
+        }
+      }>();
 
-  } catch (std::exception) {
-    getSelf().getLogger().warn("Incorrect config file. "_tr());
-  }
-}
+  command.overload<BedrockWhiteList::ListArgument>()
+      .text("list")
+      .text("create")
+      .required("name")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   ListArgument const&  args) {
+        if (not CheckAdminOrigin(origin) or not CheckLists(output)) {
+          return;
+        }
 
+        if (not Utils::NamedLists::IsValidName(args.name)) {
+          output.error("{0} is not a valid list name. "_tr(args.name));
+          return;
+        }
 
-void BedrockWhiteList::WhiteList::RegisterCommand() {
-  const auto commandRegistry = service::getCommandRegistry();
-  if (!commandRegistry) {
-    throw std::runtime_error("Failed to get command registry. "_tr());
-  }
+        DispatchCommand(origin, output, [args](CommandReply& reply) {
+          if (not g_config->GetLists()->Create(args.name)) {
+            reply.Error("List {0} already exists. "_tr(args.name));
+            return;
+          }
 
+          reply.Success("List {0} is created. "_tr(args.name));
+        });
+      }>();
 
-  auto& commandBridge = command::CommandRegistrar::getInstance();
-  auto& command       = commandBridge.getOrCreateCommand(
-      PLUGIN_NAME,
-      PLUGIN_DESCRIPTION,
-      CommandPermissionLevel::Any
-  );
-  command.alias(PLUGIN_ALIAS);
+  command.overload<BedrockWhiteList::ListArgument>()
+      .text("list")
+      .text("delete")
+      .required("name")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   ListArgument const&  args) {
+        if (not CheckAdminOrigin(origin) or not CheckLists(output)) {
+          return;
+        }
+
+        DispatchCommand(
+            origin,
+            output,
+            [args](CommandReply& reply) {
+              if (not g_config->GetLists()->Drop(args.name)) {
+                reply.Error("List {0} does not exist. "_tr(args.name));
+                return;
+              }
+
+              reply.Success("List {0} is deleted. "_tr(args.name));
+            },
+            EnforceOnlineAll
+        );
+      }>();
+
+  command.overload<BedrockWhiteList::ListMemberArgument>()
+      .text("list")
+      .text("add")
+      .required("name")
+      .required("targetPlayer")
+      .execute<[&](CommandOrigin const&      origin,
+                   CommandOutput&            output,
+                   ListMemberArgument const& args) {
+        ChangeListMembers(origin, output, args, true);
+      }>();
+
+  command.overload<BedrockWhiteList::ListMemberArgument>()
+      .text("list")
+      .text("remove")
+      .required("name")
+      .required("targetPlayer")
+      .execute<[&](CommandOrigin const&      origin,
+                   CommandOutput&            output,
+                   ListMemberArgument const& args) {
+        ChangeListMembers(origin, output, args, false);
+      }>();
 
 
   /* overload: 2
-   * mode: info(optional)
-   * permission: Any
+   * mode: rules [reload]
+   * arguments: none
+   * permission: Operator
    */
-  auto helpCmdCallback = [&](CommandOrigin const& origin,
-                             CommandOutput&       output) {
-    if (CheckOriginAs(origin, {CommandOriginType::Player})) {
-      const auto& entity = origin.getEntity();
-      static_cast<Player*>(entity)->sendMessage(g_pluginInfo);
-      static_cast<Player*>(entity)->sendMessage(fmt::format(
-          "Debug:\n"
-          "System ID: {0}",
-          Utils::Windows::GetDeviceToken()
-      ));
-    }
-  };
-  command.overload().execute<helpCmdCallback>();
-  command.overload().text("info").execute<helpCmdCallback>();
+  command.overload()
+      .text("rules")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin)) {
+          return;
+        }
+
+        const auto rules = g_config->GetRules();
+        if (rules == nullptr) {
+          output.error("The database is not open yet. "_tr());
+          return;
+        }
 
+        const auto summary = rules->Describe();
+        output.success("{0} rule(s), first match decides, then lists.admission. "_tr(
+            summary.size()
+        ));
+
+        for (size_t i = 0; i < summary.size(); i++) {
+          output.success(fmt::format(
+              "{0}. {1}: {2} ({3})",
+              i + 1,
+              summary[i].Name,
+              summary[i].Description,
+              "{0} hit(s), {1} slot(s) taken this hour"_tr(
+                  summary[i].Hits,
+                  summary[i].SlotsTaken
+              )
+          ));
+        }
+      }>();
 
-  /* overload: 2
-   * mode: set
+  command.overload()
+      .text("rules")
+      .text("reload")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin)) {
+          return;
+        }
+
+        string error{};
+        if (not g_config->ReloadRules(error)) {
+          output.error("Rules are not reloaded: {0}"_tr(error));
+          return;
+        }
+
+        output.success("{0} rule(s) are compiled and apply from now on. "_tr(
+            g_config->GetRules()->Size()
+        ));
+        EnforceOnlineAll();
+      }>();
+
+
+  /* overload: 1
+   * mode: journal
    * arguments:
-   *         1: Player -- targetPlayer
+   *         1: String -- player name or uuid
+   *         2: Int    -- max records (optional)
    * permission: Operator
    */
-  command.overload<BedrockWhiteList::WhitelistArgument>()
-      .text("set")
-      .required("targetPlayer")
-      .execute<[&](CommandOrigin const&     origin,
-                   CommandOutput&           output,
-                   WhitelistArgument const& args) {
-        const auto entity = origin.getEntity();
-        if (entity->isType(ActorType::MinecartCommandBlock)) {
+  command.overload<BedrockWhiteList::JournalArgument>()
+      .text("journal")
+      .required("player")
+      .optional("limit")
+      .execute<[&](CommandOrigin const&   origin,
+                   CommandOutput&         output,
+                   JournalArgument const& args) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+        const auto journal = g_config->GetJournal();
+        if (journal == nullptr) {
+          output.error("The audit journal is disabled. "_tr());
           return;
         }
 
-        if (not g_config->permission.enableCommandblock) {
-          if (origin.getOriginType() == CommandOriginType::CommandBlock) {
+
+        DispatchCommand(origin, output, [journal, args](CommandReply& reply) {
+          // The journal is keyed by uuid.
+          const auto playerUuid = ResolvePlayerUuid(args.player);
+
+          if (playerUuid.empty()) {
+            reply.Error("Player {0} is not found. "_tr(args.player));
             return;
           }
+
+
+          const auto statusName = [](uint8_t status) -> string {
+            switch (status) {
+            case Utils::Whitelist:
+              return "whitelist";
+            case Utils::Blacklist:
+              return "blacklist";
+            default:
+              return "-";
+            }
+          };
+
+          const auto records =
+              journal->Query(playerUuid, 0 < args.limit ? args.limit : 10);
+
+          reply.Success(
+              "{0} journal record(s) of {1}: "_tr(records.size(), playerUuid)
+          );
+
+          // A side without a row has no time either, not the epoch.
+          const auto lastTime = [](uint8_t status, int64_t time) -> string {
+            return status == Utils::JournalNoStatus ? "-" : FormatUnixTime(time);
+          };
+
+          for (auto& record : records) {
+            reply.Success(fmt::format(
+                "[{0}] {1}: {2} {3} -> {4} {5} ({6})",
+                FormatUnixTime(record.Timestamp),
+                record.Actor,
+                statusName(record.OldStatus),
+                lastTime(record.OldStatus, record.OldLastTime),
+                statusName(record.NewStatus),
+                lastTime(record.NewStatus, record.NewLastTime),
+                record.PlayerName
+            ));
+          }
+        });
+      }>();
+
+
+  /* overload: 1
+   * mode: stats
+   * permission: Operator
+   */
+  command.overload()
+      .text("stats")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
         }
 
-        const auto isRequestPlayer = entity->isType(ActorType::Player);
+        const auto lastSeen = g_config->GetLastSeen();
+        if (lastSeen == nullptr) {
+          output.success("Last-seen tracking is disabled. "_tr());
+        } else {
+          const auto stats = lastSeen->GetStatistics();
+          output.success(
+              "Last seen: {0} flush(es), {1} row(s) written, {2} pending, "
+              "last flush {3} us, slowest {4} us. "_tr(
+                  stats.Flushes,
+                  stats.RowsWritten,
+                  stats.Pending,
+                  stats.LastFlushMicros,
+                  stats.MaxFlushMicros
+              )
+          );
+        }
 
-        if (isRequestPlayer) {
-          auto requestor = static_cast<Player*>(entity);
+        if (const auto shards = g_config->GetShards(); shards != nullptr) {
+          const auto stats = shards->GetStatistics();
+          const auto total =
+              std::accumulate(stats.RowsWritten.begin(), stats.RowsWritten.end(), 0ull);
+          const auto busiest =
+              *std::max_element(stats.RowsWritten.begin(), stats.RowsWritten.end());
+
+          output.success(
+              "Shards: {0} file(s), {1} row(s) written, {2} by the busiest "
+              "shard, {3} fan-out(s). "_tr(stats.Shards, total, busiest, stats.FanOuts)
+          );
+        }
 
-          if (requestor->getPlayerPermissionLevel()
-              != PlayerPermissionLevel::Operator) {
-            return;
+        if (const auto columns = g_config->GetColumns(); columns != nullptr) {
+          const auto stats = columns->GetStatistics();
+          output.success(
+              "Query columns: {0} row(s) in {1} KiB, {2} KiB of names, {3} "
+              "write(s) applied, {4} query(s). "_tr(
+                  stats.Rows,
+                  stats.Bytes / 1024,
+                  stats.ArenaBytes / 1024,
+                  stats.Applied,
+                  stats.Queries
+              )
+          );
+        }
+
+        const auto connect = g_config->GetAdmission()->GetStatistics();
+        output.success(
+            "Connect: {0} decision(s), {1} over budget, {2} from cache, {3} by "
+            "policy, {4} re-checked, {5} error(s), slowest {6} us. "_tr(
+                connect.Decisions,
+                connect.Overruns,
+                connect.CacheFallbacks,
+                connect.PolicyFallbacks,
+                connect.Rechecks,
+                connect.Errors,
+                connect.MaxMicros
+            )
+        );
+
+        const auto backup = g_config->GetBackup();
+        if (backup != nullptr) {
+          const auto progress = backup->GetProgress();
+          output.success(
+              progress.Running
+                  ? "Backup: running, {0}/{1} pages left, {2} restart(s). "_tr(
+                      progress.RemainingPages,
+                      progress.TotalPages,
+                      progress.Restarts
+                  )
+                  : "Backup: {0} completed, last one took {1} ms. "_tr(
+                      progress.Completed,
+                      progress.LastDurationMillis
+                  )
+          );
+        }
+
+        const auto enforcement = g_config->GetEnforcement();
+        if (enforcement != nullptr) {
+          const auto stats = enforcement->GetStatistics();
+          output.success(
+              "Enforcement: {0} sweep(s), {1} online player(s) checked, {2} "
+              "disconnected, last sweep {3} us, slowest {4} us. "_tr(
+                  stats.Sweeps,
+                  stats.Online,
+                  stats.Rejected,
+                  stats.LastMicros,
+                  stats.MaxMicros
+              )
+          );
+        }
+
+        const auto journal = g_config->GetJournal();
+        if (journal != nullptr) {
+          const auto stats = journal->GetStatistics();
+          output.success(
+              "Journal: {0} appended, {1} written, {2} dropped, {3} compaction(s). "_tr(
+                  stats.appended,
+                  stats.written,
+                  stats.dropped,
+                  stats.compactions
+              )
+          );
+        }
+
+        const auto identities = g_config->GetIdentities();
+        if (identities != nullptr) {
+          const auto stats = identities->GetStatistics();
+          output.success(
+              "Identities: {0} player(s) by xuid, {1} join(s) resolved, {2} "
+              "written, {3} rename(s). "_tr(
+                  stats.Identities,
+                  stats.Resolved,
+                  stats.Recorded,
+                  stats.Renamed
+              )
+          );
+        }
+
+        const auto commandPool = g_config->GetCommandPool();
+        if (commandPool != nullptr) {
+          output.success("Commands: {0} worker(s), {1} queued. "_tr(
+              commandPool->Threads(),
+              commandPool->Pending()
+          ));
+        }
+      }>();
+
+
+  /* overload: 3
+   * mode: find [expiring | newcomers | name]
+   * arguments:
+   *         1: Int    -- minutes from now, for expiring and newcomers
+   *         1: String -- part of the name, for name
+   *         2: Int    -- max players listed (optional)
+   * permission: Operator
+   */
+  command.overload<BedrockWhiteList::FindArgument>()
+      .text("find")
+      .text("expiring")
+      .required("minutes")
+      .optional("limit")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   FindArgument const&  args) {
+        // Timed bans ending within the next minutes.
+        const auto now = static_cast<int64_t>(std::time(nullptr));
+        FindPlayers(
+            origin,
+            output,
+            {Utils::ExpiringBefore, now + args.minutes * 60ll, now},
+            args.limit
+        );
+      }>();
+
+  command.overload<BedrockWhiteList::FindArgument>()
+      .text("find")
+      .text("newcomers")
+      .required("minutes")
+      .optional("limit")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   FindArgument const&  args) {
+        // Recorded within the last minutes.
+        const auto now = static_cast<int64_t>(std::time(nullptr));
+        FindPlayers(
+            origin,
+            output,
+            {Utils::RecordedSince, now - args.minutes * 60ll, now},
+            args.limit
+        );
+      }>();
+
+  command.overload<BedrockWhiteList::FindArgument>()
+      .text("find")
+      .text("name")
+      .required("text")
+      .optional("limit")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   FindArgument const&  args) {
+        FindPlayers(
+            origin,
+            output,
+            {Utils::NameContains, 0, std::time(nullptr), args.text},
+            args.limit
+        );
+      }>();
+
+
+  /* overload: 1
+   * mode: counters
+   * permission: Operator
+   */
+  command.overload()
+      .text("counters")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+        // Kept up to date by the writers, nothing is counted here.
+        const auto stats =
+            g_config->GetCounters()->GetStatistics(std::time(nullptr));
+        output.success(
+            "Lists: {0} whitelisted, {1} blacklisted of which {2} timed, {3} "
+            "auto-recorded newcomer(s). "_tr(
+                stats.Whitelisted,
+                stats.Blacklisted,
+                stats.TimedBans,
+                stats.AutoRecorded
+            )
+        );
+        output.success("Newcomers: {0} in the last hour, {1} in the last day. "_tr(
+            stats.NewcomersLastHour,
+            stats.NewcomersLastDay
+        ));
+        output.success(
+            "Rejected joins: {0} in the last minute, {1} in the last hour. "_tr(
+                stats.RejectsLastMinute,
+                stats.RejectsLastHour
+            )
+        );
+      }>();
+
+
+  /* overload: 1
+   * mode: groups
+   * permission: Operator
+   */
+  command.overload()
+      .text("groups")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin)) {
+          return;
+        }
+
+        const auto stats = g_groups.GetStatistics();
+        output.success(
+            "Groups: {0} named by rules, {1} player(s) cached, {2} hit(s), {3} "
+            "resolved, {4} notification(s). "_tr(
+                stats.Groups,
+                stats.Players,
+                stats.Hits,
+                stats.Misses,
+                stats.Notifications
+            )
+        );
+
+        if (not stats.HasResolver) {
+          output.success(
+              "No group plugin resolves players, only the groups it sets are "
+              "known. "_tr()
+          );
+        }
+      }>();
+
+
+  /* overload: 1
+   * mode: backup
+   * permission: Operator
+   */
+  command.overload()
+      .text("backup")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+        const auto backup = g_config->GetBackup();
+        if (backup == nullptr) {
+          output.error("Backups are disabled. "_tr());
+          return;
+        }
+
+        if (not backup->Trigger()) {
+          const auto progress = backup->GetProgress();
+          output.error("A backup is already running, {0}/{1} pages left. "_tr(
+              progress.RemainingPages,
+              progress.TotalPages
+          ));
+          return;
+        }
+
+        output.success(
+            "Backup started in background, see /_whitelist stats for progress. "_tr()
+        );
+      }>();
+
+
+  /* overload: 1
+   * mode: convert
+   * permission: Operator
+   */
+  command.overload()
+      .text("convert")
+      .execute<[&](CommandOrigin const& origin, CommandOutput& output) {
+        if (not CheckAdminOrigin(origin) or not CheckReady(output)) {
+          return;
+        }
+
+
+        DispatchCommand(origin, output, [](CommandReply& reply) {
+          // Copies from the backend that is not selected into the selected
+          // one.
+          const auto startTime = std::chrono::steady_clock::now();
+          const auto target    = g_config->database.backend;
+          const auto source    = target == Utils::SQLiteStorage
+                                   ? Utils::KeyValueStorage
+                                   : Utils::SQLiteStorage;
+
+          try {
+
+            auto       storage = g_config->OpenStorage(source);
+            const auto count   = g_config->GetSeesion()->Import(*storage);
+
+            reply.Success("Converted {0} player(s) from {1} to {2} in {3} ms. "_tr(
+                count,
+                Utils::StorageKindName(source),
+                Utils::StorageKindName(target),
+                ElapsedMillis(startTime)
+            ));
+
+          } catch (std::exception& e) {
+            reply.Error("Conversion failed: {0}"_tr(e.what()));
           }
+        });
+      }>();
+
+
+  /* overload: 1
+   * mode: bench
+   * arguments:
+   *         1: Int -- players written to each backend (optional)
+   * permission: Operator
+   */
+  command.overload<BedrockWhiteList::BenchArgument>()
+      .text("bench")
+      .optional("rows")
+      .execute<[&](CommandOrigin const& origin,
+                   CommandOutput&       output,
+                   BenchArgument const& args) {
+        if (not CheckAdminOrigin(origin)) {
+          return;
         }
+
+
+        DispatchCommand(origin, output, [args](CommandReply& reply) {
+          // Runs on scratch stores next to the database, so the numbers match
+          // the disk the plugin uses; on a command worker, so the server keeps
+          // ticking meanwhile.
+          const auto rows =
+              static_cast<size_t>(0 < args.rows ? args.rows : 10000);
+          const auto scratch =
+              filesystem::path(g_config->database.path).parent_path() / "bench";
+
+          for (auto kind : {Utils::SQLiteStorage, Utils::KeyValueStorage}) {
+            try {
+
+              filesystem::remove_all(scratch);
+              filesystem::create_directories(scratch);
+
+              Utils::StorageBenchmark result{};
+
+              if (kind == Utils::SQLiteStorage) {
+                SQLite::Database session(
+                    (scratch / "bench.sqlite3.db").string(),
+                    SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+                );
+                session.exec("PRAGMA journal_mode = WAL;");
+                Utils::Migrator(session, Utils::PlayerSchemaMigrations()).Run();
+
+                Utils::SQLiteBackend backend(session);
+                result = Utils::BenchmarkStorage(backend, rows, 500);
+              } else {
+                Utils::KeyValueBackend backend(scratch / "players");
+                result = Utils::BenchmarkStorage(backend, rows, 500);
+              }
+
+              reply.Success(
+                  "{0}: {1} rows, write {2} ms, hit lookup {3} ns, miss lookup "
+                  "{4} ns, scan {5} ms. "_tr(
+                      Utils::StorageKindName(kind),
+                      result.Rows,
+                      result.WriteMicros / 1000,
+                      result.LookupMicros * 1000 / static_cast<int64_t>(result.Rows),
+                      result.MissMicros * 1000 / static_cast<int64_t>(result.Rows),
+                      result.ScanMicros / 1000
+                  )
+              );
+
+            } catch (std::exception& e) {
+              reply.Error("Benchmark failed: {0}"_tr(e.what()));
+            }
+          }
+
+          std::error_code ec;
+          filesystem::remove_all(scratch, ec);
+        });
       }>();
 }
 
@@ -567,65 +2683,217 @@ void BedrockWhiteList::WhiteList::RegisterPlayerEvent() {
   auto playerJoinEvent =
       ll::event::Listener<ll::event::PlayerConnectEvent>::create(
           [&](ll::event::player::PlayerConnectEvent& ev) {
-            Utils::PlayerDB* playerDB = g_config->GetSeesion();
-            Player&          player   = ev.self();
-            Logger           logger   = Logger("BEWhitelist.PlayerConnect");
-
-
-            auto playerInfo =
-                playerDB->GetPlayerInfoAsUUID(player.getUuid().asString());
-            logger.info("Player Connected! {0}, 踹飞！", playerInfo.PlayerName);
+            Player& player = ev.self();
+            Logger  logger = Logger("BEWhitelist.PlayerConnect");
+
+            // In the player's locale, from the compiled templates.
+            const auto outcome = g_config->GetConnect()->Handle(
+                ev,
+                [&player](const Utils::ConnectOutcome& rejected) {
+                  return RejectMessage(rejected, player.getLocaleName());
+                }
+            );
+
+            if (outcome.Admit()) {
+              g_online.Join(ListUuid(player), player.getUuid().asString());
+            }
 
-            if (playerInfo.Empty()) {
+            const auto& verdict = outcome.Verdict;
 
+            switch (outcome.What) {
+            case Utils::ConnectOutcome::WarmupAdmitted:
+              logger.info(g_messages.Render(
+                  Utils::LogWarmupAdmitted,
+                  "",
+                  {player.getName()}
+              ));
+              return;
 
-              playerDB->SetPlayerInfo(Utils::PlayerInfo(
-                  Utils::Blacklist,
-                  player.getName(),
-                  player.getUuid().asString(),
-                  -1
+            case Utils::ConnectOutcome::WarmupRejected:
+              logger.info(g_messages.Render(
+                  Utils::LogWarmupRejected,
+                  "",
+                  {player.getName()}
               ));
+              return;
 
+            default:
+              break;
+            }
 
-              player.disconnect(
-                  "You are disconnected because you are not whitelisted. "_tr()
-              );
 
+            if (verdict.From != Utils::AdmissionVerdict::Database) {
+              logger.warn(g_messages.Render(
+                  Utils::LogNoDatabaseAnswer,
+                  "",
+                  {player.getName(),
+                   std::to_string(g_config->connect.budgetMillis),
+                   g_messages.Render(
+                       verdict.From == Utils::AdmissionVerdict::Cache
+                           ? Utils::LogLastVerdict
+                           : Utils::LogFallbackPolicy,
+                       ""
+                   )}
+              ));
+            }
 
+            switch (outcome.What) {
+            case Utils::ConnectOutcome::PolicyRejected:
               logger.info(
-                  "{0} is a newcomer without whitelist, and is disconnected. "_tr(
-                      player.getName()
-                  )
+                  g_messages.Render(Utils::LogPolicyRejected, "", {player.getName()})
               );
-            }
+              break;
 
-            logger.info("time {0}", playerInfo.LastTime.Time);
-            if (playerInfo.PlayerStatus == Utils::Blacklist) {
-              player.disconnect(
-                  playerInfo.LastTime == -1
-                      ? "You are on the blacklist forever. "_tr()
-                      : "You are on the blacklist until {0}. "_tr(
-                          playerInfo.LastTime.ToString()
-                      )
-              );
+            case Utils::ConnectOutcome::NewcomerRejected:
+              logger.info(g_messages.Render(
+                  Utils::LogNewcomerRejected,
+                  "",
+                  {player.getName()}
+              ));
+              break;
 
+            case Utils::ConnectOutcome::BlacklistRejected:
+              logger.info(g_messages.Render(
+                  Utils::LogBlacklistRejected,
+                  "",
+                  {player.getName()}
+              ));
+              break;
 
+            case Utils::ConnectOutcome::ListRejected:
               logger.info(
-                  "{0} is on the blacklist and is auto disconnected. "_tr(
-                      player.getName()
-                  )
+                  g_messages.Render(Utils::LogListRejected, "", {player.getName()})
               );
+              break;
+
+            case Utils::ConnectOutcome::RuleRejected:
+              logger.info(g_messages.Render(
+                  Utils::LogRuleRejected,
+                  "",
+                  {player.getName(), g_config->GetRules()->Name(outcome.Rule)}
+              ));
+              break;
+
+            case Utils::ConnectOutcome::Admitted:
+              if (0 <= outcome.Rule) {
+                logger.info(g_messages.Render(
+                    Utils::LogRuleAdmitted,
+                    "",
+                    {player.getName(), g_config->GetRules()->Name(outcome.Rule)}
+                ));
+              }
+              break;
+
+            default:
+              break;
             }
           },
           ll::event::EventPriority::High
       );
 
   eventBus.addListener(playerJoinEvent);
+
+
+  auto playerLeaveEvent =
+      ll::event::Listener<ll::event::PlayerDisconnectEvent>::create(
+          [](ll::event::player::PlayerDisconnectEvent& ev) {
+            g_online.Leave(ListUuid(ev.self()));
+          }
+      );
+
+  eventBus.addListener(playerLeaveEvent);
 }
 
 
 LL_REGISTER_PLUGIN(BedrockWhiteList::WhiteList, BedrockWhiteList::instance);
 
+
+// - - - - - - Exports, see Api.h - - - - - -
+
+
+bool BedrockWhitelist_GetCounters(BedrockWhitelistCounters* counters) {
+  if (counters == nullptr or counters->Size < sizeof(counters->Size)
+      or not g_warmupGate.IsReady() or g_config->GetCounters() == nullptr) {
+    return false;
+  }
+
+  const auto stats = g_config->GetCounters()->GetStatistics(std::time(nullptr));
+
+  BedrockWhitelistCounters all{};
+  all.Size              = static_cast<uint32_t>(sizeof(all));
+  all.Whitelisted       = stats.Whitelisted;
+  all.Blacklisted       = stats.Blacklisted;
+  all.TimedBans         = stats.TimedBans;
+  all.AutoRecorded      = stats.AutoRecorded;
+  all.NewcomersLastHour = stats.NewcomersLastHour;
+  all.NewcomersLastDay  = stats.NewcomersLastDay;
+  all.RejectsLastMinute = stats.RejectsLastMinute;
+  all.RejectsLastHour   = stats.RejectsLastHour;
+
+  // The caller's Size stays as it was.
+  const auto size = std::min<size_t>(counters->Size, sizeof(all));
+  std::memcpy(
+      reinterpret_cast<char*>(counters) + sizeof(all.Size),
+      reinterpret_cast<const char*>(&all) + sizeof(all.Size),
+      size - sizeof(all.Size)
+  );
+
+  return true;
+}
+
+
+bool BedrockWhitelist_SetPlayerGroups(
+    const char*        playerUuid,
+    const char* const* groups,
+    size_t             count
+) {
+  if (playerUuid == nullptr) {
+    return false;
+  }
+
+  std::vector<string> names{};
+  for (size_t i = 0; groups != nullptr and i < count; i++) {
+    if (groups[i] != nullptr) {
+      names.emplace_back(groups[i]);
+    }
+  }
+
+  g_groups.Set(playerUuid, std::move(names));
+  return true;
+}
+
+
+void BedrockWhitelist_InvalidatePlayerGroups(const char* playerUuid) {
+  if (playerUuid == nullptr) {
+    g_groups.InvalidateAll();
+  } else {
+    g_groups.Invalidate(playerUuid);
+  }
+}
+
+
+void BedrockWhitelist_SetGroupResolver(BedrockWhitelistGroupResolver resolver) {
+  if (resolver == nullptr) {
+    g_groups.SetResolver(nullptr);
+    return;
+  }
+
+  g_groups.SetResolver([resolver](const string& playerUuid) {
+    std::vector<string> names{};
+    resolver(
+        playerUuid.c_str(),
+        [](void* context, const char* group) {
+          if (group != nullptr) {
+            static_cast<std::vector<string>*>(context)->emplace_back(group);
+          }
+        },
+        &names
+    );
+    return names;
+  });
+}
+
+
 string BedrockWhiteList::Utils::Windows::GetDeviceToken() {
 
   auto hash = Utils::Crypt::SHA256(
@@ -6,11 +6,14 @@
 #include <Windows.h>
 
 #include <array>
+#include <chrono>
 #include <intrin.h>
 #include <memory>
 #include <string.h>
+#include <thread>
 
 #pragma warning(disable : 4702)
+#include <fmt/chrono.h>
 #include <fmt/compile.h>
 #include <fmt/core.h>
 
@@ -20,7 +23,32 @@
 
 #include <cryptopp/sha.h>
 
+#include "plugin/Admission.h"
+#include "plugin/Async.h"
+#include "plugin/Backup.h"
+#include "plugin/Columns.h"
+#include "plugin/Connect.h"
+#include "plugin/Counters.h"
+#include "plugin/Enforcement.h"
+#include "plugin/Groups.h"
+#include "plugin/Identity.h"
+#include "plugin/Journal.h"
+#include "plugin/KeyValueStorage.h"
+#include "plugin/LastSeen.h"
+#include "plugin/Messages.h"
+#include "plugin/Migration.h"
+#include "plugin/NamedLists.h"
+#include "plugin/PlayerDB.h"
+#include "plugin/Rules.h"
+#include "plugin/Shards.h"
+#include "plugin/Storage.h"
+#include "plugin/Sweeper.h"
+#include "plugin/VerdictCache.h"
+#include "plugin/Warmup.h"
+#include "plugin/Worker.h"
+
 #include <ll/api/Config.h>
+#include <ll/api/chrono/GameChrono.h>
 #include <ll/api/command/Command.h>
 #include <ll/api/command/CommandHandle.h>
 #include <ll/api/command/CommandRegistrar.h>
@@ -28,6 +56,7 @@
 #include <ll/api/event/EventBus.h>
 #include <ll/api/event/ListenerBase.h>
 #include <ll/api/event/player/PlayerConnectEvent.h>
+#include <ll/api/event/player/PlayerDisconnectEvent.h>
 #include <ll/api/event/player/PlayerJoinEvent.h>
 #include <ll/api/form/ModalForm.h>
 #include <ll/api/i18n/I18n.h>
@@ -35,10 +64,13 @@
 #include <ll/api/plugin/NativePlugin.h>
 #include <ll/api/plugin/PluginManagerRegistry.h>
 #include <ll/api/plugin/RegisterHelper.h>
+#include <ll/api/schedule/Scheduler.h>
+#include <ll/api/schedule/Task.h>
 #include <ll/api/service/Bedrock.h>
 #include <mc/deps/core/common/bedrock/typeid_t.h>
 #include <mc/deps/json/Value.h>
 #include <mc/entity/utilities/ActorType.h>
+#include <mc/platform/UUID.h>
 #include <mc/server/ServerPlayer.h>
 #include <mc/server/commands/CommandOrigin.h>
 #include <mc/server/commands/CommandOriginType.h>
@@ -50,6 +82,7 @@
 #include <mc/world/actor/Actor.h>
 #include <mc/world/actor/player/Player.h>
 #include <mc/world/item/registry/ItemStack.h>
+#include <mc/world/level/Level.h>
 
 
 #define PLUGIN_NAME        "_whitelist"
@@ -69,65 +102,6 @@ namespace BedrockWhiteList {
 namespace Utils {
 
 
-// Users
-
-
-struct TimeUnix {
-  TimeUnix();
-  TimeUnix(time_t);
-
-  time_t Time;
-
-  bool   Empty() const;
-  string ToString();
-
-  bool      operator==(long long cmpTime);
-  long long operator=(long long llTime);
-};
-
-
-typedef enum __tagPlayerStatus { Whitelist, Blacklist } PlayerStatus;
-
-
-struct PlayerInfo {
-  PlayerInfo();
-  PlayerInfo(
-      PlayerStatus playerStatus,
-      string       playerName,
-      string       playerUuid,
-      TimeUnix     lastTime
-  );
-
-  PlayerStatus PlayerStatus;
-  string       PlayerName;
-  string       PlayerUuid;
-  TimeUnix     LastTime;
-
-  bool Empty() const;
-
-  void operator=(PlayerInfo info);
-};
-
-
-class PlayerDB {
-  public:
-  PlayerDB();
-  PlayerDB(SQLite::Database*);
-  ~PlayerDB();
-
-  public:
-  bool __GetPlayerInfo(SQLite::Statement& result, Utils::PlayerInfo& info);
-
-  void                    SetPlayerInfo(PlayerInfo playerInfo);
-  PlayerInfo              GetPlayerInfo(string playerName);
-  PlayerInfo              GetPlayerInfoAsUUID(string playerUuid);
-  std::vector<PlayerInfo> GetPlayerListAsStatus(PlayerStatus status);
-
-  private:
-  SQLite::Database* m_tempSession;
-};
-
-
 namespace Crypt {
 string SHA256(string data);
 };
@@ -265,30 +239,134 @@ struct PluginConfig {
   PluginConfig(string configFile);
   ~PluginConfig();
 
-  Utils::PlayerDB* GetSeesion();
+  void OpenDatabase();
+  void StartBackgroundTasks();
+  void StopBackgroundTasks();
+  bool MigrateOnline(
+      const std::atomic<bool>&     stop,
+      Utils::Migrator::LogCallback log
+  );
+
+  Utils::PlayerDB*            GetSeesion();
+  Utils::AuditJournal*        GetJournal();
+  Utils::VerdictCache*        GetCache();
+  Utils::LastSeenTracker*     GetLastSeen();
+  Utils::OnlineBackup*        GetBackup();
+  Utils::AdmissionController* GetAdmission();
+  Utils::ConnectHandler*      GetConnect();
+  Utils::NamedLists*          GetLists();
+  Utils::RuleEngine*          GetRules();
+  Utils::EnforcementSweep*    GetEnforcement();
+  Utils::IdentityIndex*       GetIdentities();
+  Utils::ListCounters*        GetCounters();
+  Utils::ShardedBackend*      GetShards();
+  Utils::PlayerColumns*       GetColumns();
+  Utils::WorkerPool*          GetCommandPool();
+
+  // Reads lists.admission and rules from the config file again and
+  // recompiles them; either stays as it ran when it does not compile.
+  bool ReloadRules(string& error);
+
+  // A backend of its own on the configured location of kind, used to
+  // convert from the backend that is not selected.
+  std::unique_ptr<Utils::StorageBackend> OpenStorage(Utils::StorageKind kind);
 
   struct {
-    string path;
-    bool   useEncrypt;
+    string             path;
+    bool               useEncrypt;
+    Utils::StorageKind backend;
+    string             keyValuePath;
+    int                shards;
   } database{};
   struct {
     bool enableCommandblock;
   } permission{};
+  struct {
+    bool      enable;
+    string    path;
+    long long maxSegmentSize;
+    int       maxSegments;
+    long long compactInterval;
+    int       retentionDays;
+  } journal{};
+  struct {
+    Utils::WarmupPolicy warmupPolicy;
+    int                 holdTimeout;
+  } startup{};
+  struct {
+    int                 budgetMillis;
+    Utils::WarmupPolicy fallbackPolicy;
+  } connect{};
+  struct {
+    bool      enable;
+    long long newcomerTtl;
+    long long interval;
+    int       batchSize;
+    int       sliceMillis;
+    int       vacuumPages;
+  } retention{};
+  struct {
+    bool      enable;
+    long long flushInterval;
+  } lastSeen{};
+  struct {
+    bool      enable;
+    string    path;
+    long long interval;
+    int       keep;
+    int       pagesPerStep;
+    int       stepPauseMillis;
+    bool      compress;
+  } backup{};
+  struct {
+    string admission;
+  } lists{};
+  struct {
+    int workers;
+  } commands{};
+  struct {
+    bool columnar;
+  } queries{};
+  std::vector<Utils::RuleSource> rules{};
 
   private:
   string     m_configFile{};
   YAML::Node m_configObject{};
 
-  SQLite::Database* m_pDatabase{nullptr};
-  Utils::PlayerDB*  m_pPlayerDB{nullptr};
+  SQLite::Database*      m_pDatabase{nullptr};
+  Utils::StorageBackend* m_pStorage{nullptr};
+  Utils::PlayerDB*       m_pPlayerDB{nullptr};
+  Utils::AuditJournal* m_pJournal{nullptr};
+  Utils::VerdictCache  m_verdictCache{};
+
+  Utils::RetentionSweeper* m_pSweeper{nullptr};
+  Utils::LastSeenTracker*  m_pLastSeen{nullptr};
+  Utils::OnlineBackup*     m_pBackup{nullptr};
+
+  Utils::AdmissionController* m_pAdmission{nullptr};
+  Utils::ConnectHandler*      m_pConnect{nullptr};
+  Utils::NamedLists*          m_pLists{nullptr};
+  Utils::RuleEngine*          m_pRules{nullptr};
+  Utils::EnforcementSweep*    m_pEnforcement{nullptr};
+  Utils::IdentityIndex*       m_pIdentities{nullptr};
+  Utils::ListCounters*        m_pCounters{nullptr};
+  Utils::PlayerColumns*       m_pColumns{nullptr};
+
+  Utils::WorkerPool* m_pCommandPool{nullptr};
 };
 
 
 // - - - - - - - - - - - - - - - - - - - - - -
 
 
+enum class WhitelistListType { whitelist, blacklist };
+
+
 typedef struct __tagWhitelistArgument {
   CommandSelector<Player> targetPlayer;
+  WhitelistListType       list;
+  int                     time;
+  string                  reason;
 } WhitelistArgument, wlArg;
 
 
@@ -298,6 +376,72 @@ typedef struct __tagWhitelistArgumentEx1 {
 } WhitelistArgumentEx1, wlArgEx1;
 
 
+typedef struct __tagJournalArgument {
+  string player;
+  int    limit;
+} JournalArgument;
+
+
+typedef struct __tagPlayerArgument {
+  string player;
+  int    limit;
+} PlayerArgument;
+
+
+typedef struct __tagListArgument {
+  string name;
+} ListArgument;
+
+
+typedef struct __tagListMemberArgument {
+  string                  name;
+  CommandSelector<Player> targetPlayer;
+} ListMemberArgument;
+
+
+typedef struct __tagNoteArgument {
+  string player;
+  string notes;
+} NoteArgument;
+
+
+typedef struct __tagBenchArgument {
+  int rows;
+} BenchArgument;
+
+
+typedef struct __tagFindArgument {
+  string text;
+  int    minutes;
+  int    limit;
+} FindArgument;
+
+
+// - - - - - - - - - - - - - - - - - - - - - -
+
+
+/*
+ * What an asynchronous command has to say once it is done. Lines are
+ * gathered wherever the command runs and sent from the game thread, to the
+ * player who ran it when they are still online, to the log otherwise.
+ */
+class CommandReply {
+  public:
+  explicit CommandReply(const CommandOrigin& origin);
+
+  public:
+  void Success(string message);
+  void Error(string message);
+
+  // Game thread only.
+  void Send() const;
+
+  private:
+  string                          m_playerUuid{};
+  vector<std::pair<bool, string>> m_lines{};
+};
+
+
 // - - - - - - - - - - - - - - - - - - - - - -
 
 
@@ -317,6 +461,7 @@ class WhiteList {
 
 
   void LoadConfig();
+  void StartWarmup();
   void RegisterPlayerEvent();
   void RegisterCommand();
 
@@ -0,0 +1,252 @@
+#include "plugin/Bitmap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+using std::string, std::string_view, std::vector;
+
+
+constexpr size_t BITMAP_WORDS = 65536 / 64;
+
+// First byte of a saved container.
+constexpr char CONTAINER_ARRAY  = 0;
+constexpr char CONTAINER_BITMAP = 1;
+
+
+// - - - - - - Container - - - - - -
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Container::IsBitmap() const {
+  return not Bits.empty();
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Container::Contains(uint16_t low
+) const {
+  if (IsBitmap()) {
+    return (Bits[low >> 6] >> (low & 63)) & 1;
+  }
+
+  return std::binary_search(Array.begin(), Array.end(), low);
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Container::Add(uint16_t low) {
+  if (IsBitmap()) {
+    auto&      word = Bits[low >> 6];
+    const auto bit  = uint64_t{1} << (low & 63);
+
+    if (word & bit) {
+      return false;
+    }
+
+    word |= bit;
+    Count++;
+    return true;
+  }
+
+
+  const auto it = std::lower_bound(Array.begin(), Array.end(), low);
+  if (it != Array.end() and *it == low) {
+    return false;
+  }
+
+  Array.insert(it, low);
+  Count++;
+
+  // Past the limit the bitmap (8 KiB) is smaller than the array.
+  if (Array.size() > ARRAY_LIMIT) {
+    Bits.assign(BITMAP_WORDS, 0);
+    for (auto value : Array) {
+      Bits[value >> 6] |= uint64_t{1} << (value & 63);
+    }
+
+    Array.clear();
+    Array.shrink_to_fit();
+  }
+
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Container::Remove(uint16_t low) {
+  if (IsBitmap()) {
+    auto&      word = Bits[low >> 6];
+    const auto bit  = uint64_t{1} << (low & 63);
+
+    if (not(word & bit)) {
+      return false;
+    }
+
+    word &= ~bit;
+    Count--;
+
+    if (Count <= ARRAY_LIMIT) {
+      Array.reserve(Count);
+
+      for (size_t i = 0; i < BITMAP_WORDS; i++) {
+        for (auto rest = Bits[i]; rest != 0; rest &= rest - 1) {
+          Array.push_back(static_cast<uint16_t>(i * 64 + std::countr_zero(rest)));
+        }
+      }
+
+      Bits.clear();
+      Bits.shrink_to_fit();
+    }
+
+    return true;
+  }
+
+
+  const auto it = std::lower_bound(Array.begin(), Array.end(), low);
+  if (it == Array.end() or *it != low) {
+    return false;
+  }
+
+  Array.erase(it);
+  Count--;
+  return true;
+}
+
+
+// - - - - - - Bitmap - - - - - -
+
+
+size_t BedrockWhiteList::Utils::RoaringBitmap::Find(uint16_t key) const {
+  return static_cast<size_t>(
+      std::lower_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin()
+  );
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Add(uint32_t value) {
+  const auto key   = static_cast<uint16_t>(value >> 16);
+  const auto index = Find(key);
+
+  if (index == m_keys.size() or m_keys[index] != key) {
+    m_keys.insert(m_keys.begin() + index, key);
+    m_containers.insert(m_containers.begin() + index, Container{});
+  }
+
+  if (not m_containers[index].Add(static_cast<uint16_t>(value))) {
+    return false;
+  }
+
+  m_dirty.insert(key);
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Remove(uint32_t value) {
+  const auto key   = static_cast<uint16_t>(value >> 16);
+  const auto index = Find(key);
+
+  if (index == m_keys.size() or m_keys[index] != key) {
+    return false;
+  }
+
+  if (not m_containers[index].Remove(static_cast<uint16_t>(value))) {
+    return false;
+  }
+
+  if (m_containers[index].Count == 0) {
+    m_keys.erase(m_keys.begin() + index);
+    m_containers.erase(m_containers.begin() + index);
+  }
+
+  m_dirty.insert(key);
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Contains(uint32_t value) const {
+  const auto key   = static_cast<uint16_t>(value >> 16);
+  const auto index = Find(key);
+
+  return index != m_keys.size() and m_keys[index] == key
+     and m_containers[index].Contains(static_cast<uint16_t>(value));
+}
+
+
+uint64_t BedrockWhiteList::Utils::RoaringBitmap::Cardinality() const {
+  uint64_t count{0};
+  for (auto& container : m_containers) {
+    count += container.Count;
+  }
+
+  return count;
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::Empty() const {
+  return m_keys.empty();
+}
+
+
+vector<uint16_t> BedrockWhiteList::Utils::RoaringBitmap::TakeDirty() {
+  vector<uint16_t> dirty(m_dirty.begin(), m_dirty.end());
+  m_dirty.clear();
+
+  return dirty;
+}
+
+
+string BedrockWhiteList::Utils::RoaringBitmap::SaveContainer(uint16_t key) const {
+  const auto index = Find(key);
+  if (index == m_keys.size() or m_keys[index] != key) {
+    return {};
+  }
+
+  const auto& container = m_containers[index];
+  string      data{};
+
+  if (container.IsBitmap()) {
+    data.resize(1 + BITMAP_WORDS * 8);
+    data[0] = CONTAINER_BITMAP;
+    std::memcpy(data.data() + 1, container.Bits.data(), BITMAP_WORDS * 8);
+  } else {
+    data.resize(1 + container.Array.size() * 2);
+    data[0] = CONTAINER_ARRAY;
+    std::memcpy(data.data() + 1, container.Array.data(), container.Array.size() * 2);
+  }
+
+  return data;
+}
+
+
+bool BedrockWhiteList::Utils::RoaringBitmap::LoadContainer(
+    uint16_t         key,
+    string_view      data
+) {
+  Container container{};
+
+  if (data.size() == 1 + BITMAP_WORDS * 8 and data[0] == CONTAINER_BITMAP) {
+    container.Bits.resize(BITMAP_WORDS);
+    std::memcpy(container.Bits.data(), data.data() + 1, BITMAP_WORDS * 8);
+
+    for (auto word : container.Bits) {
+      container.Count += static_cast<uint32_t>(std::popcount(word));
+    }
+  } else if (not data.empty() and data.size() % 2 == 1 and data[0] == CONTAINER_ARRAY) {
+    container.Array.resize((data.size() - 1) / 2);
+    std::memcpy(container.Array.data(), data.data() + 1, data.size() - 1);
+    container.Count = static_cast<uint32_t>(container.Array.size());
+  } else {
+    return false;
+  }
+
+  if (container.Count == 0) {
+    return true;
+  }
+
+  const auto index = Find(key);
+  if (index != m_keys.size() and m_keys[index] == key) {
+    m_containers[index] = std::move(container);
+  } else {
+    m_keys.insert(m_keys.begin() + index, key);
+    m_containers.insert(m_containers.begin() + index, std::move(container));
+  }
+
+  return true;
+}
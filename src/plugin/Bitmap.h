@@ -0,0 +1,72 @@
+#pragma once
+
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * A set of 32-bit ids in the layout of a roaring bitmap.
+ *
+ * The high 16 bits select a container, kept in a sorted key array. A
+ * container holds the low 16 bits either as a sorted array, while it has
+ * at most ARRAY_LIMIT of them, or as a 65536-bit bitmap past that. A probe
+ * is a binary search over the keys plus one array search or bit test.
+ *
+ * Containers changed since the last TakeDirty() are remembered, so the
+ * owner persists only those instead of the whole set.
+ */
+class RoaringBitmap {
+  public:
+  static constexpr size_t ARRAY_LIMIT = 4096;
+
+  public:
+  bool Add(uint32_t value);
+  bool Remove(uint32_t value);
+  bool Contains(uint32_t value) const;
+
+  uint64_t Cardinality() const;
+  bool     Empty() const;
+
+  // Container keys changed since the last call, in order.
+  std::vector<uint16_t> TakeDirty();
+
+  // Empty when the container no longer exists.
+  std::string SaveContainer(uint16_t key) const;
+  bool        LoadContainer(uint16_t key, std::string_view data);
+
+  private:
+  struct Container {
+    std::vector<uint16_t> Array{};
+    std::vector<uint64_t> Bits{};
+    uint32_t              Count{0};
+
+    bool IsBitmap() const;
+    bool Contains(uint16_t low) const;
+    bool Add(uint16_t low);
+    bool Remove(uint16_t low);
+  };
+
+  // Index of key in m_keys, or of where it would be inserted.
+  size_t Find(uint16_t key) const;
+
+  private:
+  std::vector<uint16_t>  m_keys{};
+  std::vector<Container> m_containers{};
+  std::set<uint16_t>     m_dirty{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
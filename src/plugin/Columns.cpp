@@ -0,0 +1,756 @@
+#include "plugin/Columns.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+// x64 always has SSE2; AVX2 only when the build targets it (/arch:AVX2,
+// -mavx2).
+#if defined(__AVX2__)
+#define COLUMNS_AVX2
+#endif
+
+#if defined(__SSE2__) or defined(_M_X64) or defined(_M_AMD64)
+#define COLUMNS_SSE2
+#endif
+
+#if defined(COLUMNS_AVX2)
+#include <immintrin.h>
+#elif defined(COLUMNS_SSE2)
+#include <emmintrin.h>
+#endif
+
+using std::string, std::string_view, std::vector;
+
+using BedrockWhiteList::Utils::PlayerColumns;
+using BedrockWhiteList::Utils::PlayerInfo;
+
+
+constexpr uint8_t ROW_LIVE        = 1;
+constexpr uint8_t ROW_BLACKLISTED = 2;
+constexpr uint8_t ROW_AUTO        = 4;
+constexpr uint8_t ROW_TEXT_UUID   = 8;
+
+constexpr uint32_t NO_ROW       = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t DELETED_SLOT = NO_ROW - 1;
+constexpr size_t   BLOCK        = 64;
+
+
+inline static uint32_t Clamp(int64_t time) {
+  return time <= 0 ? 0
+       : std::numeric_limits<uint32_t>::max() <= time
+           ? std::numeric_limits<uint32_t>::max()
+           : static_cast<uint32_t>(time);
+}
+
+
+inline static char Fold(char c) {
+  return 'A' <= c and c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+
+inline static bool Contains(string_view name, string_view text) {
+  if (text.size() > name.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i + text.size() <= name.size(); i++) {
+    size_t k = 0;
+    while (k < text.size() and Fold(name[i + k]) == Fold(text[k])) {
+      k++;
+    }
+
+    if (k == text.size()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+inline static int Nibble(char c) {
+  return '0' <= c and c <= '9' ? c - '0' : 'a' <= c and c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+
+// Lower case 8-4-4-4-12 hex only, so formatting it gives the same text back.
+inline static bool ParseUuid(string_view text, std::array<uint8_t, 16>& uuid) {
+  if (text.size() != 36) {
+    return false;
+  }
+
+  size_t byte = 0;
+  for (size_t i = 0; i < text.size();) {
+    if (i == 8 or i == 13 or i == 18 or i == 23) {
+      if (text[i] != '-') {
+        return false;
+      }
+      i++;
+      continue;
+    }
+
+    const auto high = Nibble(text[i]);
+    const auto low  = Nibble(text[i + 1]);
+    if (high < 0 or low < 0) {
+      return false;
+    }
+
+    uuid[byte++]  = static_cast<uint8_t>(high << 4 | low);
+    i            += 2;
+  }
+
+  return true;
+}
+
+
+inline static string FormatUuid(const std::array<uint8_t, 16>& uuid) {
+  constexpr auto digits = "0123456789abcdef";
+
+  string text{};
+  text.reserve(36);
+  for (size_t i = 0; i < uuid.size(); i++) {
+    if (i == 4 or i == 6 or i == 8 or i == 10) {
+      text.push_back('-');
+    }
+    text.push_back(digits[uuid[i] >> 4]);
+    text.push_back(digits[uuid[i] & 0xF]);
+  }
+
+  return text;
+}
+
+
+// Uuids are random already, the multiply spreads the low bits for the mask.
+inline static size_t HashUuid(const std::array<uint8_t, 16>& uuid) {
+  uint64_t high{0}, low{0};
+  std::memcpy(&high, uuid.data(), 8);
+  std::memcpy(&low, uuid.data() + 8, 8);
+
+  return static_cast<size_t>((high ^ low) * 0x9E3779B97F4A7C15ull >> 17);
+}
+
+
+// - - - - - - - - - - - - - - - - Kernels - - - - - - - - - - - - - - - -
+
+
+// Bit i is set when row i of the block has (status & mask) == want and
+// low <= column <= low + span.
+inline static uint64_t MatchBlock(
+    const uint8_t*  status,
+    const uint32_t* column,
+    uint8_t         mask,
+    uint8_t         want,
+    uint32_t        low,
+    uint32_t        span
+) {
+  uint64_t bits{0};
+
+#if defined(COLUMNS_AVX2)
+  const auto masks = _mm256_set1_epi8(static_cast<char>(mask));
+  const auto wants = _mm256_set1_epi8(static_cast<char>(want));
+  for (size_t i = 0; i < BLOCK; i += 32) {
+    const auto rows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(status + i));
+    const auto hits = _mm256_cmpeq_epi8(_mm256_and_si256(rows, masks), wants);
+    bits |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hits))) << i;
+  }
+#elif defined(COLUMNS_SSE2)
+  const auto masks = _mm_set1_epi8(static_cast<char>(mask));
+  const auto wants = _mm_set1_epi8(static_cast<char>(want));
+  for (size_t i = 0; i < BLOCK; i += 16) {
+    const auto rows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(status + i));
+    const auto hits = _mm_cmpeq_epi8(_mm_and_si128(rows, masks), wants);
+    bits |= static_cast<uint64_t>(_mm_movemask_epi8(hits) & 0xFFFF) << i;
+  }
+#else
+  for (size_t i = 0; i < BLOCK; i++) {
+    bits |= static_cast<uint64_t>((status[i] & mask) == want) << i;
+  }
+#endif
+
+  // Most blocks hold no row of the status asked for, their times are not
+  // read at all.
+  if (bits == 0) {
+    return 0;
+  }
+
+  // Unsigned column - low <= span, as a signed compare with the sign bits
+  // flipped; SSE2 has no unsigned one.
+  uint64_t outside{0};
+
+#if defined(COLUMNS_AVX2)
+  const auto lows  = _mm256_set1_epi32(static_cast<int>(low));
+  const auto signs = _mm256_set1_epi32(std::numeric_limits<int>::min());
+  const auto spans = _mm256_set1_epi32(static_cast<int>(span ^ 0x80000000u));
+  for (size_t i = 0; i < BLOCK; i += 8) {
+    const auto times = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+    const auto above = _mm256_cmpgt_epi32(
+        _mm256_xor_si256(_mm256_sub_epi32(times, lows), signs),
+        spans
+    );
+    outside |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(above))) << i;
+  }
+#elif defined(COLUMNS_SSE2)
+  const auto lows  = _mm_set1_epi32(static_cast<int>(low));
+  const auto signs = _mm_set1_epi32(std::numeric_limits<int>::min());
+  const auto spans = _mm_set1_epi32(static_cast<int>(span ^ 0x80000000u));
+  for (size_t i = 0; i < BLOCK; i += 4) {
+    const auto times = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+    const auto above =
+        _mm_cmpgt_epi32(_mm_xor_si128(_mm_sub_epi32(times, lows), signs), spans);
+    outside |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(above))) << i;
+  }
+#else
+  for (size_t i = 0; i < BLOCK; i++) {
+    outside |= static_cast<uint64_t>(span < column[i] - low) << i;
+  }
+#endif
+
+  return bits & ~outside;
+}
+
+
+// Calls hit(position) for every position of text in arena, comparing ASCII
+// letters in any case; text is folded already. The first and the last byte
+// of text are compared at 16 positions at once, only positions where both
+// match are compared in full.
+template <typename Hit>
+inline static void FindAll(string_view arena, string_view text, Hit&& hit) {
+  const auto size = text.size();
+  if (size == 0 or arena.size() < size) {
+    return;
+  }
+
+  const auto verify = [&](size_t at) {
+    for (size_t k = 1; k + 1 < size; k++) {
+      if (Fold(arena[at + k]) != text[k]) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  size_t at{0};
+
+#if defined(COLUMNS_SSE2) or defined(COLUMNS_AVX2)
+  // A letter matches both cases with the 0x20 bit set; no other byte turns
+  // into a lower case letter that way.
+  const auto letter = [](char c) { return 'a' <= c and c <= 'z'; };
+  const auto first  = _mm_set1_epi8(text.front());
+  const auto last   = _mm_set1_epi8(text.back());
+  const auto fold1  = _mm_set1_epi8(letter(text.front()) ? 0x20 : 0);
+  const auto fold2  = _mm_set1_epi8(letter(text.back()) ? 0x20 : 0);
+
+  for (; at + size - 1 + 16 <= arena.size(); at += 16) {
+    const auto head =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(arena.data() + at));
+    const auto tail =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(arena.data() + at + size - 1));
+
+    auto candidates = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(_mm_or_si128(head, fold1), first),
+        _mm_cmpeq_epi8(_mm_or_si128(tail, fold2), last)
+    )));
+
+    while (candidates != 0) {
+      const auto position = at + std::countr_zero(candidates);
+      if (verify(position)) {
+        hit(position);
+      }
+      candidates &= candidates - 1;
+    }
+  }
+#endif
+
+  for (; at + size <= arena.size(); at++) {
+    if (Fold(arena[at]) == text.front() and Fold(arena[at + size - 1]) == text.back()
+        and verify(at)) {
+      hit(at);
+    }
+  }
+}
+
+
+// - - - - - - - - - - - - - - - - Query - - - - - - - - - - - - - - - -
+
+
+bool BedrockWhiteList::Utils::PlayerQuery::Matches(const PlayerInfo& info) const {
+  const bool newcomer =
+      info.PlayerStatus == Blacklist and info.Flags == AutoRecorded;
+
+  switch (Kind) {
+  case ExpiringBefore:
+    return info.PlayerStatus == Blacklist and not newcomer
+       and Now < info.LastTime.Time and info.LastTime.Time < Time;
+  case RecordedSince:
+    return newcomer and Time <= info.RecordedTime;
+  default:
+    return Contains(info.PlayerName, Text);
+  }
+}
+
+
+bool BedrockWhiteList::Utils::PlayerQuery::Precedes(
+    const PlayerInfo& left,
+    const PlayerInfo& right
+) const {
+  switch (Kind) {
+  case ExpiringBefore:
+    if (left.LastTime.Time != right.LastTime.Time) {
+      return left.LastTime.Time < right.LastTime.Time;
+    }
+    break;
+  case RecordedSince:
+    if (left.RecordedTime != right.RecordedTime) {
+      return left.RecordedTime > right.RecordedTime;
+    }
+    break;
+  default:
+    break;
+  }
+
+  return left.PlayerName < right.PlayerName;
+}
+
+
+// - - - - - - - - - - - - - - - - Columns - - - - - - - - - - - - - - - -
+
+
+size_t BedrockWhiteList::Utils::PlayerColumns::Load(StorageBackend& storage) {
+  std::unique_lock lock(m_mutex);
+
+  Clear();
+  storage.ForEach(
+      [&](const PlayerInfo& info) {
+        Put(info, info.RecordedTime);
+        return true;
+      },
+      true
+  );
+
+  return m_rows - m_free.size();
+}
+
+
+void BedrockWhiteList::Utils::PlayerColumns::Apply(const PlayerInfo& info, int64_t now) {
+  std::unique_lock lock(m_mutex);
+
+  // The blacklist upsert leaves player_recorded_time alone.
+  const auto row = Find(info.PlayerUuid);
+  if (row != NO_ROW and info.PlayerStatus == Blacklist
+      and m_status[row] & ROW_BLACKLISTED) {
+    Put(info, m_recorded[row]);
+  } else {
+    Put(info, info.RecordedTime != 0 ? info.RecordedTime : now);
+  }
+
+  m_applied.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void BedrockWhiteList::Utils::PlayerColumns::Erase(const string& playerUuid) {
+  std::unique_lock lock(m_mutex);
+
+  const auto row = Find(playerUuid);
+  if (row == NO_ROW) {
+    return;
+  }
+
+  if (m_status[row] & ROW_TEXT_UUID) {
+    m_textUuids.erase(playerUuid);
+    m_textRows.erase(row);
+  } else {
+    m_slots[SlotOf(m_uuid[row])] = DELETED_SLOT;
+  }
+
+  Release(row);
+  m_status[row] = 0;
+  m_free.push_back(row);
+
+  m_applied.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+size_t BedrockWhiteList::Utils::PlayerColumns::Select(
+    const PlayerQuery&  query,
+    size_t              limit,
+    vector<PlayerInfo>& players
+) {
+  std::shared_lock lock(m_mutex);
+  m_queries.fetch_add(1, std::memory_order_relaxed);
+
+  vector<uint32_t> rows{};
+
+  switch (query.Kind) {
+  case ExpiringBefore: {
+    // Now < end < Time; 0, a permanent ban, is never in range.
+    const auto low  = std::max<uint32_t>(Clamp(query.Now + 1), 1);
+    const auto high = Clamp(query.Time - 1);
+    if (low <= high) {
+      ScanTimes(
+          m_expiry,
+          low,
+          high,
+          ROW_LIVE | ROW_BLACKLISTED | ROW_AUTO,
+          ROW_LIVE | ROW_BLACKLISTED,
+          rows
+      );
+    }
+    break;
+  }
+  case RecordedSince: {
+    const uint8_t newcomer = ROW_LIVE | ROW_BLACKLISTED | ROW_AUTO;
+    ScanTimes(
+        m_recorded,
+        Clamp(query.Time),
+        std::numeric_limits<uint32_t>::max(),
+        newcomer,
+        newcomer,
+        rows
+    );
+    break;
+  }
+  default: {
+    string text(query.Text);
+    std::transform(text.begin(), text.end(), text.begin(), Fold);
+    ScanNames(text, rows);
+    break;
+  }
+  }
+
+
+  const auto precedes = [&](uint32_t left, uint32_t right) {
+    if (query.Kind == ExpiringBefore and m_expiry[left] != m_expiry[right]) {
+      return m_expiry[left] < m_expiry[right];
+    }
+    if (query.Kind == RecordedSince and m_recorded[left] != m_recorded[right]) {
+      return m_recorded[left] > m_recorded[right];
+    }
+    return Name(left) < Name(right);
+  };
+
+  const auto listed = std::min(limit, rows.size());
+  std::partial_sort(rows.begin(), rows.begin() + listed, rows.end(), precedes);
+
+  for (size_t i = 0; i < listed; i++) {
+    players.push_back(Row(rows[i]));
+  }
+
+  return rows.size();
+}
+
+
+PlayerColumns::Statistics BedrockWhiteList::Utils::PlayerColumns::GetStatistics() const {
+  std::shared_lock lock(m_mutex);
+
+  const auto bytes = [](const auto& column) {
+    return column.capacity() * sizeof(column[0]);
+  };
+
+  return {
+      m_rows - m_free.size(),
+      bytes(m_expiry) + bytes(m_recorded) + bytes(m_status) + bytes(m_name)
+          + bytes(m_uuid) + bytes(m_free) + bytes(m_slots) + m_arena.capacity()
+          + bytes(m_starts) + bytes(m_owners),
+      m_arena.size(),
+      m_applied.load(std::memory_order_relaxed),
+      m_queries.load(std::memory_order_relaxed)
+  };
+}
+
+
+// The caller holds m_mutex exclusively.
+void BedrockWhiteList::Utils::PlayerColumns::Clear() {
+  m_expiry.clear();
+  m_recorded.clear();
+  m_status.clear();
+  m_name.clear();
+  m_uuid.clear();
+  m_rows = 0;
+  m_free.clear();
+
+  m_textUuids.clear();
+  m_textRows.clear();
+
+  m_slots.assign(1024, NO_ROW);
+  m_used = 0;
+
+  m_arena.clear();
+  m_starts.clear();
+  m_owners.clear();
+  m_garbage = 0;
+}
+
+
+// The caller holds m_mutex exclusively.
+void BedrockWhiteList::Utils::PlayerColumns::Put(
+    const PlayerInfo& info,
+    int64_t           recordedTime
+) {
+  auto row = Find(info.PlayerUuid);
+  if (row == NO_ROW) {
+    row         = Insert(info.PlayerUuid);
+    m_name[row] = Intern(info.PlayerName, row);
+  } else if (Name(row) != info.PlayerName) {
+    Release(row);
+    m_name[row] = Intern(info.PlayerName, row);
+  }
+
+  const bool blacklisted = info.PlayerStatus == Blacklist;
+
+  m_status[row] = static_cast<uint8_t>(
+      (m_status[row] & (ROW_LIVE | ROW_TEXT_UUID)) | (blacklisted ? ROW_BLACKLISTED : 0)
+      | (blacklisted and info.Flags == AutoRecorded ? ROW_AUTO : 0)
+  );
+  m_expiry[row]   = Clamp(info.LastTime.Time);
+  m_recorded[row] = blacklisted ? Clamp(recordedTime) : 0;
+
+  Compact();
+}
+
+
+// The caller holds m_mutex.
+uint32_t BedrockWhiteList::Utils::PlayerColumns::Find(const string& playerUuid) const {
+  Uuid uuid{};
+  if (not ParseUuid(playerUuid, uuid)) {
+    const auto it = m_textUuids.find(playerUuid);
+    return it != m_textUuids.end() ? it->second : NO_ROW;
+  }
+
+  const auto slot = SlotOf(uuid);
+  return slot < m_slots.size() ? m_slots[slot] : NO_ROW;
+}
+
+
+// The slot holding the row of uuid, m_slots.size() when there is none.
+// The caller holds m_mutex.
+size_t BedrockWhiteList::Utils::PlayerColumns::SlotOf(const Uuid& uuid) const {
+  if (m_slots.empty()) {
+    return 0;
+  }
+
+  const auto mask = m_slots.size() - 1;
+  for (auto slot = HashUuid(uuid) & mask;; slot = (slot + 1) & mask) {
+    const auto row = m_slots[slot];
+    if (row == NO_ROW) {
+      return m_slots.size();
+    }
+
+    if (row != DELETED_SLOT and m_uuid[row] == uuid) {
+      return slot;
+    }
+  }
+}
+
+
+// A new live row for playerUuid, which has none. The caller holds m_mutex
+// exclusively.
+uint32_t BedrockWhiteList::Utils::PlayerColumns::Insert(const string& playerUuid) {
+  uint32_t row{0};
+  if (not m_free.empty()) {
+    row = m_free.back();
+    m_free.pop_back();
+  } else {
+    if (m_rows == m_status.size()) {
+      const auto size = m_rows + BLOCK;
+      m_expiry.resize(size, 0);
+      m_recorded.resize(size, 0);
+      m_status.resize(size, 0);
+      m_name.resize(size, 0);
+      m_uuid.resize(size, Uuid{});
+    }
+    row = static_cast<uint32_t>(m_rows++);
+  }
+
+  m_status[row] = ROW_LIVE;
+
+  if (not ParseUuid(playerUuid, m_uuid[row])) {
+    m_status[row] |= ROW_TEXT_UUID;
+    m_textUuids[playerUuid] = row;
+    m_textRows[row]         = playerUuid;
+    return row;
+  }
+
+  // At most half full, deleted slots counted, so probes stay short.
+  if (m_slots.size() < (m_used + 1) * 2) {
+    Reindex(std::bit_ceil(std::max<size_t>((m_rows - m_free.size()) * 4, 1024)));
+  }
+
+  const auto mask = m_slots.size() - 1;
+  for (auto slot = HashUuid(m_uuid[row]) & mask;; slot = (slot + 1) & mask) {
+    if (m_slots[slot] == NO_ROW or m_slots[slot] == DELETED_SLOT) {
+      m_used        += m_slots[slot] == NO_ROW ? 1 : 0;
+      m_slots[slot]  = row;
+      return row;
+    }
+  }
+}
+
+
+// The caller holds m_mutex exclusively.
+void BedrockWhiteList::Utils::PlayerColumns::Reindex(size_t slots) {
+  m_slots.assign(slots, NO_ROW);
+  m_used = 0;
+
+  const auto mask = slots - 1;
+  for (uint32_t row = 0; row < m_rows; row++) {
+    if ((m_status[row] & (ROW_LIVE | ROW_TEXT_UUID)) != ROW_LIVE) {
+      continue;
+    }
+
+    auto slot = HashUuid(m_uuid[row]) & mask;
+    while (m_slots[slot] != NO_ROW) {
+      slot = (slot + 1) & mask;
+    }
+
+    m_slots[slot] = row;
+    m_used++;
+  }
+}
+
+
+// The caller holds m_mutex exclusively.
+uint32_t
+BedrockWhiteList::Utils::PlayerColumns::Intern(string_view playerName, uint32_t row) {
+  const auto start = static_cast<uint32_t>(m_arena.size());
+
+  // A name is never looked for past its end.
+  m_arena.append(playerName.substr(0, playerName.find('\0')));
+  m_arena.push_back('\0');
+  m_starts.push_back(start);
+  m_owners.push_back(row);
+
+  return start;
+}
+
+
+// The caller holds m_mutex exclusively.
+void BedrockWhiteList::Utils::PlayerColumns::Release(uint32_t row) {
+  const auto it    = std::lower_bound(m_starts.begin(), m_starts.end(), m_name[row]);
+  const auto index = static_cast<size_t>(it - m_starts.begin());
+
+  m_owners[index]  = NO_ROW;
+  m_garbage       += Name(row).size() + 1;
+}
+
+
+// Copies the names still used to a new arena once most of it is not.
+// The caller holds m_mutex exclusively.
+void BedrockWhiteList::Utils::PlayerColumns::Compact() {
+  if (m_garbage < 65536 or m_garbage * 2 < m_arena.size()) {
+    return;
+  }
+
+  string           arena{};
+  vector<uint32_t> starts{}, owners{};
+  arena.reserve(m_arena.size() - m_garbage);
+
+  for (size_t i = 0; i < m_starts.size(); i++) {
+    const auto row = m_owners[i];
+    if (row == NO_ROW) {
+      continue;
+    }
+
+    const auto name = Name(row);
+    m_name[row]     = static_cast<uint32_t>(arena.size());
+    starts.push_back(m_name[row]);
+    owners.push_back(row);
+    arena.append(name);
+    arena.push_back('\0');
+  }
+
+  m_arena   = std::move(arena);
+  m_starts  = std::move(starts);
+  m_owners  = std::move(owners);
+  m_garbage = 0;
+}
+
+
+// The caller holds m_mutex.
+string_view BedrockWhiteList::Utils::PlayerColumns::Name(uint32_t row) const {
+  return string_view(m_arena.data() + m_name[row]);
+}
+
+
+// The caller holds m_mutex.
+PlayerInfo BedrockWhiteList::Utils::PlayerColumns::Row(uint32_t row) const {
+  const auto status = m_status[row];
+
+  PlayerInfo info(
+      status & ROW_BLACKLISTED ? Blacklist : Whitelist,
+      string(Name(row)),
+      status & ROW_TEXT_UUID ? m_textRows.at(row) : FormatUuid(m_uuid[row]),
+      m_expiry[row] != 0 ? static_cast<int64_t>(m_expiry[row]) : -1
+  );
+  info.Flags        = status & ROW_AUTO ? AutoRecorded : 0;
+  info.RecordedTime = m_recorded[row];
+
+  return info;
+}
+
+
+// The caller holds m_mutex.
+void BedrockWhiteList::Utils::PlayerColumns::ScanTimes(
+    const vector<uint32_t>& column,
+    uint32_t                low,
+    uint32_t                high,
+    uint8_t                 mask,
+    uint8_t                 want,
+    vector<uint32_t>&       rows
+) const {
+  for (size_t base = 0; base < m_rows; base += BLOCK) {
+    auto bits = MatchBlock(
+        m_status.data() + base,
+        column.data() + base,
+        mask,
+        want,
+        low,
+        high - low
+    );
+
+    while (bits != 0) {
+      rows.push_back(static_cast<uint32_t>(base + std::countr_zero(bits)));
+      bits &= bits - 1;
+    }
+  }
+}
+
+
+// The caller holds m_mutex.
+void BedrockWhiteList::Utils::PlayerColumns::ScanNames(
+    string_view       text,
+    vector<uint32_t>& rows
+) const {
+  if (text.empty()) {
+    for (uint32_t row = 0; row < m_rows; row++) {
+      if (m_status[row] & ROW_LIVE) {
+        rows.push_back(row);
+      }
+    }
+    return;
+  }
+
+  // Positions come in order: the name of the next one is found galloping
+  // on from the last, and a name matching twice is the last row added.
+  size_t entry{0};
+  FindAll(m_arena, text, [&](size_t position) {
+    size_t step{1};
+    while (entry + step < m_starts.size() and m_starts[entry + step] <= position) {
+      entry += step;
+      step  *= 2;
+    }
+
+    const auto end = m_starts.begin() + std::min(entry + step, m_starts.size());
+    entry          = static_cast<size_t>(
+        std::upper_bound(m_starts.begin() + entry, end, static_cast<uint32_t>(position))
+        - m_starts.begin() - 1
+    );
+
+    const auto row = m_owners[entry];
+    if (row != NO_ROW and (rows.empty() or rows.back() != row)) {
+      rows.push_back(row);
+    }
+  });
+}
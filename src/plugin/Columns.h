@@ -0,0 +1,142 @@
+#pragma once
+
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "plugin/Storage.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+typedef enum __tagQueryKind {
+  ExpiringBefore, // timed bans ending after Now and before Time
+  NameContains,   // Text anywhere in the name, ASCII letters in any case
+  RecordedSince   // auto-recorded newcomers recorded at Time or later
+} QueryKind;
+
+
+// What /_whitelist find asks for, answered by PlayerColumns or, without
+// them, by a scan of the backend.
+struct PlayerQuery {
+  QueryKind   Kind;
+  int64_t     Time{0};
+  int64_t     Now{0};
+  std::string Text{};
+
+  bool Matches(const PlayerInfo& info) const;
+  // The order results are listed in: soonest expiry, newest newcomer, name.
+  bool Precedes(const PlayerInfo& left, const PlayerInfo& right) const;
+};
+
+
+/*
+ * A copy of both lists in memory, kept in columns for admin queries: one
+ * array each for the ban end, the recording time and the status of every
+ * row, and the names in one arena. A query tests 64 rows at a time with
+ * SSE2 or AVX2 compares into a bit mask and only reads the rows it matches;
+ * a name is looked for in the whole arena at once.
+ *
+ * PlayerDB applies every row it writes and the retention sweeper what it
+ * deleted, so the columns follow the lists without reading them again.
+ * Times are kept in 32 bits, a permanent ban as 0.
+ */
+class PlayerColumns {
+  public:
+  struct Statistics {
+    size_t   Rows;
+    size_t   Bytes;      // held by the columns, the arena and the index
+    size_t   ArenaBytes; // of which names, including ones no longer used
+    uint64_t Applied;
+    uint64_t Queries;
+  };
+
+  public:
+  // Replaces the columns with every row of storage, newcomers too.
+  size_t Load(StorageBackend& storage);
+
+  // As the backend stores it: a blacklisted player moved within the
+  // blacklist keeps the time it was recorded at.
+  void Apply(const PlayerInfo& info, int64_t now);
+  void Erase(const std::string& playerUuid);
+
+  // Counts the rows matching query, and lists the first limit of them in
+  // the order of PlayerQuery::Precedes().
+  size_t Select(const PlayerQuery& query, size_t limit, std::vector<PlayerInfo>& players);
+
+  Statistics GetStatistics() const;
+
+  private:
+  typedef std::array<uint8_t, 16> Uuid;
+
+  void     Clear();
+  void     Put(const PlayerInfo& info, int64_t recordedTime);
+  uint32_t Find(const std::string& playerUuid) const;
+  size_t   SlotOf(const Uuid& uuid) const;
+  uint32_t Insert(const std::string& playerUuid);
+  void     Reindex(size_t slots);
+
+  uint32_t Intern(std::string_view playerName, uint32_t row);
+  void     Release(uint32_t row);
+  void     Compact();
+
+  std::string_view Name(uint32_t row) const;
+  PlayerInfo       Row(uint32_t row) const;
+
+  void ScanTimes(
+      const std::vector<uint32_t>& column,
+      uint32_t                     low,
+      uint32_t                     high,
+      uint8_t                      mask,
+      uint8_t                      want,
+      std::vector<uint32_t>&       rows
+  ) const;
+  void ScanNames(std::string_view text, std::vector<uint32_t>& rows) const;
+
+  private:
+  mutable std::shared_mutex m_mutex;
+
+  // One entry per row; the arrays are padded to whole blocks of 64 rows
+  // with free ones, which never match.
+  std::vector<uint32_t> m_expiry{};
+  std::vector<uint32_t> m_recorded{};
+  std::vector<uint8_t>  m_status{};
+  std::vector<uint32_t> m_name{};
+  std::vector<Uuid>     m_uuid{};
+  size_t                m_rows{0};
+  std::vector<uint32_t> m_free{};
+
+  // Uuids that are not 8-4-4-4-12 hex, which no client sends; by text.
+  std::unordered_map<std::string, uint32_t> m_textUuids{};
+  std::unordered_map<uint32_t, std::string> m_textRows{};
+
+  // Open addressing over the uuid bytes.
+  std::vector<uint32_t> m_slots{};
+  size_t                m_used{0}; // live and deleted slots
+
+  // Names end with a NUL; every name ever interned has a start and a row,
+  // ascending by start, the row is NO_ROW once it is no longer used.
+  std::string           m_arena{};
+  std::vector<uint32_t> m_starts{};
+  std::vector<uint32_t> m_owners{};
+  size_t                m_garbage{0};
+
+  std::atomic<uint64_t> m_applied{0};
+  std::atomic<uint64_t> m_queries{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
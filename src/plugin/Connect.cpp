@@ -0,0 +1,199 @@
+#include "plugin/Connect.h"
+
+#include <ctime>
+
+using namespace std::chrono;
+
+using std::string;
+
+using BedrockWhiteList::Utils::AdmissionVerdict;
+using BedrockWhiteList::Utils::AutoRecorded;
+using BedrockWhiteList::Utils::ConnectOutcome;
+using BedrockWhiteList::Utils::RuleInput;
+
+
+// A cache verdict carries the status without the row. A timed ban that has
+// run out leaves the player on neither list, as the counters have it.
+inline static bool IsBlacklisted(const AdmissionVerdict& verdict) {
+  return not verdict.Admit
+     and (verdict.From == AdmissionVerdict::Cache or not verdict.Info.Empty())
+     and not verdict.Info.Expired(std::time(nullptr));
+}
+
+
+// Never seen before or only recorded by an earlier rejected connect.
+inline static bool IsNewcomer(const AdmissionVerdict& verdict) {
+  return verdict.From == AdmissionVerdict::Database and not verdict.Admit
+     and (verdict.Info.Empty() or verdict.Info.Flags == AutoRecorded);
+}
+
+
+bool BedrockWhiteList::Utils::ConnectOutcome::Admit() const {
+  return What == Admitted or What == WarmupAdmitted;
+}
+
+
+BedrockWhiteList::Utils::ConnectHandler::ConnectHandler(
+    const ReadinessGate& gate,
+    Options              options
+)
+: m_gate(gate),
+  m_options(options) {}
+
+
+void BedrockWhiteList::Utils::ConnectHandler::Attach(
+    AdmissionController* admission,
+    LastSeenTracker*     lastSeen,
+    NamedLists*          lists,
+    const RuleEngine*    rules,
+    IdentityIndex*       identities,
+    ListCounters*        counters
+) {
+  m_admission  = admission;
+  m_lastSeen   = lastSeen;
+  m_lists      = lists;
+  m_rules      = rules;
+  m_identities = identities;
+  m_counters   = counters;
+}
+
+
+bool BedrockWhiteList::Utils::ConnectHandler::Admits(
+    const string&           playerUuid,
+    const AdmissionVerdict& verdict,
+    RuleEngine::SlotUse     slots,
+    int*                    rule
+) const {
+  if (rule != nullptr) {
+    *rule = -1;
+  }
+
+  if (verdict.From == AdmissionVerdict::Policy) {
+    return verdict.Admit;
+  }
+
+  if (m_rules != nullptr and 0 < m_rules->Size()) {
+    auto input        = RuleInput::At(std::time(nullptr));
+    input.Whitelisted = verdict.Admit;
+    input.Blacklisted = IsBlacklisted(verdict);
+    input.Newcomer    = IsNewcomer(verdict);
+    input.PlayerUuid  = &playerUuid;
+
+    const auto decision = m_rules->Evaluate(input, slots);
+    if (decision.Matched()) {
+      if (rule != nullptr) {
+        *rule = decision.Rule;
+      }
+
+      return decision.Allow;
+    }
+  }
+
+  if (m_lists == nullptr) {
+    return verdict.Admit;
+  }
+
+  return m_lists->Admits(playerUuid, verdict.Admit, IsBlacklisted(verdict));
+}
+
+
+ConnectOutcome BedrockWhiteList::Utils::ConnectHandler::Decide(
+    const string& eventUuid,
+    const string& playerName,
+    uint64_t      xuid
+) {
+  const auto startTime = steady_clock::now();
+  const auto elapsed   = [&startTime]() {
+    return duration_cast<microseconds>(steady_clock::now() - startTime).count();
+  };
+
+  ConnectOutcome outcome{};
+  outcome.Verdict.Info.PlayerUuid = eventUuid;
+  outcome.Verdict.Info.PlayerName = playerName;
+
+
+  // Hold waits a bounded time for the warm-up and then behaves as
+  // fail-closed.
+  if (not m_gate.IsReady()) {
+    if (m_options.warmupPolicy == Hold) {
+      m_gate.WaitFor(m_options.holdTimeout);
+    }
+
+    if (not m_gate.IsReady()) {
+      outcome.What = m_options.warmupPolicy == FailOpen
+                       ? ConnectOutcome::WarmupAdmitted
+                       : ConnectOutcome::WarmupRejected;
+      outcome.Micros = elapsed();
+      return outcome;
+    }
+  }
+
+
+  // The lists know a player by the uuid first seen with their xuid, which
+  // outlives renames: one integer probe, a write only for a new or renamed
+  // player.
+  const auto playerUuid =
+      m_identities != nullptr and xuid != 0
+          ? m_identities->Observe(xuid, eventUuid, playerName, std::time(nullptr))
+          : eventUuid;
+
+  // Bounded by the admission budget, see AdmissionController.
+  outcome.Verdict = m_admission->Decide(playerUuid, playerName);
+
+  Apply(outcome, playerUuid, RuleEngine::Take);
+
+  // Coalesced in memory, written by the tracker in batches.
+  if (outcome.Admit() and m_lastSeen != nullptr) {
+    m_lastSeen->Touch(playerUuid, std::time(nullptr));
+  }
+
+  if (not outcome.Admit() and m_counters != nullptr) {
+    m_counters->Rejected(std::time(nullptr));
+  }
+
+  outcome.Micros = elapsed();
+  return outcome;
+}
+
+
+ConnectOutcome BedrockWhiteList::Utils::ConnectHandler::Review(
+    const string&     playerUuid,
+    const PlayerInfo& info
+) const {
+  ConnectOutcome outcome{};
+  outcome.Verdict = {
+      not info.Empty() and info.PlayerStatus == Whitelist,
+      AdmissionVerdict::Database,
+      info
+  };
+
+  Apply(outcome, playerUuid, RuleEngine::Held);
+  return outcome;
+}
+
+
+// Rules and lists over outcome.Verdict, then why it came out so.
+void BedrockWhiteList::Utils::ConnectHandler::Apply(
+    ConnectOutcome&     outcome,
+    const string&       playerUuid,
+    RuleEngine::SlotUse slots
+) const {
+  const bool whitelisted = outcome.Verdict.Admit;
+  const bool blacklisted = IsBlacklisted(outcome.Verdict);
+
+  outcome.Verdict.Admit = Admits(playerUuid, outcome.Verdict, slots, &outcome.Rule);
+
+  if (outcome.Verdict.Admit) {
+    outcome.What = ConnectOutcome::Admitted;
+  } else if (0 <= outcome.Rule) {
+    outcome.What = ConnectOutcome::RuleRejected;
+  } else if (outcome.Verdict.From == AdmissionVerdict::Policy) {
+    outcome.What = ConnectOutcome::PolicyRejected;
+  } else if (blacklisted) {
+    outcome.What = ConnectOutcome::BlacklistRejected;
+  } else if (whitelisted) {
+    outcome.What = ConnectOutcome::ListRejected;
+  } else {
+    outcome.What = ConnectOutcome::NewcomerRejected;
+  }
+}
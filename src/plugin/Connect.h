@@ -0,0 +1,137 @@
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "plugin/Admission.h"
+#include "plugin/Counters.h"
+#include "plugin/Identity.h"
+#include "plugin/LastSeen.h"
+#include "plugin/NamedLists.h"
+#include "plugin/Rules.h"
+#include "plugin/Warmup.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+struct ConnectOutcome {
+  typedef enum __tagReason {
+    Admitted,
+    WarmupAdmitted,
+    WarmupRejected,
+    PolicyRejected,
+    NewcomerRejected,
+    BlacklistRejected,
+    ListRejected,
+    RuleRejected
+  } Reason;
+
+  Reason           What;
+  AdmissionVerdict Verdict;
+  int64_t          Micros;
+  int              Rule{-1}; // the rule that decided, see RuleEngine
+
+  bool Admit() const;
+};
+
+
+/*
+ * What the PlayerConnectEvent listener decides for a joining player: the
+ * warm-up policy while the readiness gate is closed, the bounded admission
+ * decision after, the rules and the lists.admission expression over its
+ * verdict and the last-seen touch of an admitted player.
+ *
+ * Kept apart from the listener so it can be driven without a server, see
+ * tools/loadgen. Logging stays with the caller.
+ */
+class ConnectHandler {
+  public:
+  struct Options {
+    WarmupPolicy              warmupPolicy{Hold};
+    std::chrono::milliseconds holdTimeout{3000};
+  };
+
+  ConnectHandler(const ReadinessGate& gate, Options options);
+
+  public:
+  // Set by the warm-up before the gate opens; everything but admission may
+  // stay null, without lists only the whitelist is let in.
+  void Attach(
+      AdmissionController* admission,
+      LastSeenTracker*     lastSeen,
+      NamedLists*          lists      = nullptr,
+      const RuleEngine*    rules      = nullptr,
+      IdentityIndex*       identities = nullptr,
+      ListCounters*        counters   = nullptr
+  );
+
+  // The verdict with the first matching rule or else the admission
+  // expression of the named lists applied. Policy verdicts stand, there is
+  // no list status to go by. rule is set to the rule that decided or -1.
+  bool Admits(
+      const std::string&      playerUuid,
+      const AdmissionVerdict& verdict,
+      RuleEngine::SlotUse     slots = RuleEngine::Peek,
+      int*                    rule  = nullptr
+  ) const;
+
+  // xuid is 0 for offline players; otherwise it, not eventUuid, decides
+  // which uuid the player is looked up by, see IdentityIndex.
+  ConnectOutcome Decide(
+      const std::string& eventUuid,
+      const std::string& playerName,
+      uint64_t           xuid = 0
+  );
+
+  // The same decision for a player already online, by their current row,
+  // empty when they have none; no slot is taken and nothing is touched.
+  ConnectOutcome
+  Review(const std::string& playerUuid, const PlayerInfo& info) const;
+
+  // Event is ll::event::PlayerConnectEvent or anything with the same
+  // self().getUuid().asString() / getName() / getXuid() / disconnect() shape.
+  template <typename Event, typename RejectMessage>
+  ConnectOutcome Handle(Event& ev, RejectMessage&& rejectMessage) {
+    auto& player  = ev.self();
+    auto  outcome = Decide(
+        player.getUuid().asString(),
+        player.getName(),
+        IdentityIndex::ParseXuid(player.getXuid())
+    );
+
+    if (not outcome.Admit()) {
+      player.disconnect(rejectMessage(outcome));
+    }
+
+    return outcome;
+  }
+
+  private:
+  void Apply(
+      ConnectOutcome&     outcome,
+      const std::string&  playerUuid,
+      RuleEngine::SlotUse slots
+  ) const;
+
+  private:
+  const ReadinessGate& m_gate;
+  Options              m_options;
+  AdmissionController* m_admission{nullptr};
+  LastSeenTracker*     m_lastSeen{nullptr};
+  NamedLists*          m_lists{nullptr};
+  const RuleEngine*    m_rules{nullptr};
+  IdentityIndex*       m_identities{nullptr};
+  ListCounters*        m_counters{nullptr};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
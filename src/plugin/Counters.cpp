@@ -0,0 +1,385 @@
+#include "plugin/Counters.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "plugin/Shards.h"
+
+using std::string;
+
+using BedrockWhiteList::Utils::ListCounters;
+using BedrockWhiteList::Utils::PlayerInfo;
+
+
+constexpr int64_t DAY_MINUTES  = 24 * 60;
+constexpr int64_t HOUR_MINUTES = 60;
+
+
+inline static bool IsNewcomer(const PlayerInfo& info) {
+  return info.PlayerStatus == BedrockWhiteList::Utils::Blacklist
+     and info.Flags == BedrockWhiteList::Utils::AutoRecorded;
+}
+
+
+inline static void Bump(auto& window, int64_t minute) {
+  auto& slot = window[static_cast<size_t>(minute) % window.size()];
+  if (slot.Minute != minute) {
+    slot.Minute = minute;
+    slot.Count  = 0;
+  }
+
+  slot.Count++;
+}
+
+
+// Over the minutes [from, to].
+inline static int64_t Sum(const auto& window, int64_t from, int64_t to) {
+  int64_t sum{0};
+  for (auto& slot : window) {
+    if (from <= slot.Minute and slot.Minute <= to) {
+      sum += slot.Count;
+    }
+  }
+
+  return sum;
+}
+
+
+BedrockWhiteList::Utils::ListCounters::ListCounters(
+    string  databasePath,
+    int64_t interval
+)
+: m_databasePath(std::move(databasePath)),
+  m_interval(interval) {}
+
+
+BedrockWhiteList::Utils::ListCounters::~ListCounters() { Stop(); }
+
+
+void BedrockWhiteList::Utils::ListCounters::SetShards(size_t shards) {
+  m_shards = std::max<size_t>(shards, 1);
+}
+
+
+SQLite::Database& BedrockWhiteList::Utils::ListCounters::Session() {
+  if (m_session == nullptr) {
+    m_session =
+        std::make_unique<SQLite::Database>(m_databasePath, SQLite::OPEN_READWRITE);
+    m_session->setBusyTimeout(1000);
+  }
+
+  return *m_session;
+}
+
+
+bool BedrockWhiteList::Utils::ListCounters::Load(int64_t now) {
+  if (m_databasePath.empty()) {
+    return false;
+  }
+
+  std::lock_guard sessionLock(m_sessionMutex);
+  auto&           session = Session();
+
+  bool    complete{false};
+  int64_t whitelisted{0}, blacklisted{0}, autoRecorded{0};
+
+  std::lock_guard   lock(m_mutex);
+  SQLite::Statement query(
+      session,
+      "SELECT counter_name, counter_slot, counter_value FROM player_counters"
+  );
+
+  while (query.executeStep()) {
+    const auto name  = query.getColumn(0).getString();
+    const auto slot  = query.getColumn(1).getInt64();
+    const auto value = query.getColumn(2).getInt64();
+
+    if (name == "complete") {
+      complete = value == 1;
+    } else if (name == "whitelisted") {
+      whitelisted = value;
+    } else if (name == "blacklisted") {
+      blacklisted = value;
+    } else if (name == "auto_recorded") {
+      autoRecorded = value;
+    } else if (name == "newcomers" and now / 60 - DAY_MINUTES < slot) {
+      auto& entry  = m_newcomers[static_cast<size_t>(slot) % m_newcomers.size()];
+      entry.Minute = slot;
+      entry.Count  = static_cast<uint32_t>(value);
+    }
+  }
+
+  if (not complete) {
+    m_newcomers.fill({});
+    return false;
+  }
+
+
+  // Timed bans are few and have a partial index of their own, in every
+  // file that holds rows.
+  for (auto& path : RowDatabasePaths(m_databasePath, m_shards)) {
+    std::unique_ptr<SQLite::Database> shard{};
+    if (m_shards > 1) {
+      shard = std::make_unique<SQLite::Database>(path, SQLite::OPEN_READONLY, 1000);
+    }
+
+    SQLite::Statement timed(
+        shard != nullptr ? *shard : session,
+        "SELECT player_uuid, player_last_time FROM blacklist "
+        "WHERE player_last_time > 0 AND player_flags != 1"
+    );
+
+    while (timed.executeStep()) {
+      const auto end = timed.getColumn(1).getInt64();
+      if (now < end) {
+        m_timedBans[timed.getColumn(0).getString()] = end;
+        m_expiries.push({end, timed.getColumn(0).getString()});
+      }
+    }
+  }
+
+  m_whitelisted  = whitelisted;
+  m_blacklisted  = blacklisted;
+  m_autoRecorded = autoRecorded;
+  m_counted      = true;
+
+
+  // Until Stop() writes them again, a crash leaves them to be recounted.
+  session.exec(
+      "INSERT OR REPLACE INTO player_counters"
+      "(counter_name, counter_slot, counter_value) VALUES('complete', 0, 0)"
+  );
+
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Recount(
+    StorageBackend& storage,
+    int64_t         now
+) {
+  std::lock_guard lock(m_mutex);
+
+  m_whitelisted  = 0;
+  m_blacklisted  = 0;
+  m_autoRecorded = 0;
+  m_timedBans.clear();
+  m_expiries = {};
+  m_newcomers.fill({});
+
+  storage.ForEach(
+      [&](const PlayerInfo& info) {
+        Add(info, 1, now);
+
+        if (IsNewcomer(info) and now - DAY_MINUTES * 60 < info.RecordedTime) {
+          Bump(m_newcomers, info.RecordedTime / 60);
+        }
+        return true;
+      },
+      true
+  );
+
+  m_counted = true;
+  m_dirty   = true;
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Start() {
+  if (m_task != nullptr or m_databasePath.empty()) {
+    return;
+  }
+
+  m_task = std::make_unique<PeriodicTask>(
+      std::chrono::seconds(m_interval),
+      [this](auto&) { Flush(); }
+  );
+  m_task->SetErrorHandler(m_onError);
+  m_task->Start();
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Stop() {
+  if (m_task != nullptr) {
+    m_task->Stop();
+    m_task.reset();
+  }
+
+  try {
+    Write(true);
+  } catch (std::exception& e) {
+    if (m_onError) {
+      m_onError(e);
+    }
+  }
+
+  std::lock_guard sessionLock(m_sessionMutex);
+  m_session.reset();
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Flush() { Write(false); }
+
+
+// Every newcomer minute of the day is written again, there are at most
+// DAY_MINUTES of them.
+void BedrockWhiteList::Utils::ListCounters::Write(bool complete) {
+  std::lock_guard sessionLock(m_sessionMutex);
+
+  if (m_databasePath.empty() or not m_counted) {
+    return;
+  }
+
+  if (not m_dirty.exchange(false) and not complete) {
+    return;
+  }
+
+
+  std::vector<Slot> newcomers{};
+  {
+    std::lock_guard lock(m_mutex);
+
+    for (auto& slot : m_newcomers) {
+      if (slot.Count != 0) {
+        newcomers.push_back(slot);
+      }
+    }
+  }
+
+  try {
+
+    auto&               session = Session();
+    SQLite::Transaction transaction(session);
+
+    SQLite::Statement upsert(
+        session,
+        "INSERT OR REPLACE INTO player_counters"
+        "(counter_name, counter_slot, counter_value) VALUES(?, ?, ?)"
+    );
+    const auto put = [&upsert](const char* name, int64_t slot, int64_t value) {
+      upsert.bind(1, name);
+      upsert.bind(2, slot);
+      upsert.bind(3, value);
+      upsert.exec();
+      upsert.reset();
+    };
+
+    put("whitelisted", 0, m_whitelisted);
+    put("blacklisted", 0, m_blacklisted);
+    put("auto_recorded", 0, m_autoRecorded);
+
+    session.exec("DELETE FROM player_counters WHERE counter_name = 'newcomers'");
+    for (auto& slot : newcomers) {
+      put("newcomers", slot.Minute, slot.Count);
+    }
+
+    put("complete", 0, complete ? 1 : 0);
+
+    transaction.commit();
+
+  } catch (...) {
+    m_dirty = true;
+    throw;
+  }
+}
+
+
+// The caller holds m_mutex.
+void BedrockWhiteList::Utils::ListCounters::Add(
+    const PlayerInfo& info,
+    int64_t           sign,
+    int64_t           now
+) {
+  if (info.PlayerStatus == Whitelist) {
+    m_whitelisted += sign;
+    return;
+  }
+
+  if (IsNewcomer(info)) {
+    m_autoRecorded += sign;
+    return;
+  }
+
+  m_blacklisted += sign;
+
+  // A stale expiry left in the queue is skipped by Expire().
+  if (sign < 0) {
+    m_timedBans.erase(info.PlayerUuid);
+  } else if (now < info.LastTime.Time) {
+    m_timedBans[info.PlayerUuid] = info.LastTime.Time;
+    m_expiries.push({info.LastTime.Time, info.PlayerUuid});
+  }
+}
+
+
+// The caller holds m_mutex.
+void BedrockWhiteList::Utils::ListCounters::Expire(int64_t now) {
+  while (not m_expiries.empty() and m_expiries.top().first <= now) {
+    const auto& [end, playerUuid] = m_expiries.top();
+
+    const auto it = m_timedBans.find(playerUuid);
+    if (it != m_timedBans.end() and it->second == end) {
+      m_timedBans.erase(it);
+    }
+
+    m_expiries.pop();
+  }
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Apply(
+    const PlayerInfo& oldInfo,
+    const PlayerInfo& newInfo,
+    int64_t           now
+) {
+  std::lock_guard lock(m_mutex);
+
+  if (not oldInfo.Empty()) {
+    Add(oldInfo, -1, now);
+  } else if (IsNewcomer(newInfo)) {
+    Bump(m_newcomers, now / 60);
+  }
+
+  Add(newInfo, 1, now);
+
+  m_applied++;
+  m_dirty = true;
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Swept(size_t newcomers) {
+  m_autoRecorded -= static_cast<int64_t>(newcomers);
+  m_dirty         = true;
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::Rejected(int64_t now) {
+  std::lock_guard lock(m_mutex);
+  Bump(m_rejects, now / 60);
+}
+
+
+void BedrockWhiteList::Utils::ListCounters::SetErrorCallback(ErrorCallback callback
+) {
+  m_onError = std::move(callback);
+}
+
+
+ListCounters::Statistics
+BedrockWhiteList::Utils::ListCounters::GetStatistics(int64_t now) {
+  const auto minute = now / 60;
+
+  std::lock_guard lock(m_mutex);
+  Expire(now);
+
+  return {
+      m_whitelisted,
+      m_blacklisted,
+      static_cast<int64_t>(m_timedBans.size()),
+      m_autoRecorded,
+      Sum(m_newcomers, minute - HOUR_MINUTES + 1, minute),
+      Sum(m_newcomers, minute - DAY_MINUTES + 1, minute),
+      Sum(m_rejects, minute - 1, minute - 1),
+      Sum(m_rejects, minute - HOUR_MINUTES + 1, minute),
+      m_applied
+  };
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Storage.h"
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * How many players each list holds, kept up to date by every write rather
+ * than counted: PlayerDB applies the old and the new row of every player it
+ * writes, the retention sweeper what it deleted and the connect handler its
+ * rejections. Reading them costs the same whatever the size of the lists.
+ *
+ * Timed bans are held in memory with their end, and leave the count when it
+ * passes. Newcomers and rejections are counted per minute, over the last day
+ * and the last hour.
+ *
+ * The totals and the newcomer minutes are written to player_counters every
+ * interval and by Stop(), which also marks them as complete. Counters not
+ * marked so, after a crash, are counted again from the rows.
+ */
+class ListCounters {
+  public:
+  typedef PeriodicTask::ErrorHandler ErrorCallback;
+
+  struct Statistics {
+    int64_t  Whitelisted;
+    int64_t  Blacklisted;  // not counting the auto-recorded newcomers
+    int64_t  TimedBans;    // of Blacklisted, not yet expired
+    int64_t  AutoRecorded;
+    int64_t  NewcomersLastHour;
+    int64_t  NewcomersLastDay;
+    int64_t  RejectsLastMinute; // the last whole minute
+    int64_t  RejectsLastHour;
+    uint64_t Applied;
+  };
+
+  // Without a databasePath nothing is stored and Load() always fails.
+  ListCounters(std::string databasePath, int64_t interval);
+  ~ListCounters();
+
+  ListCounters(const ListCounters&)            = delete;
+  ListCounters& operator=(const ListCounters&) = delete;
+
+  public:
+  // The shard count of the player rows, before Load().
+  void SetShards(size_t shards);
+
+  // False when the stored counters are missing or incomplete, Recount()
+  // then.
+  bool Load(int64_t now);
+  // Visits every row, auto-recorded newcomers too; the caller keeps writers
+  // out meanwhile.
+  void Recount(StorageBackend& storage, int64_t now);
+
+  void Start();
+  // Writes the counters and marks them complete, call it after the last
+  // write to the lists.
+  void Stop();
+  void Flush();
+
+  // oldInfo is empty for a player not stored before.
+  void Apply(const PlayerInfo& oldInfo, const PlayerInfo& newInfo, int64_t now);
+  void Swept(size_t newcomers);
+  void Rejected(int64_t now);
+
+  void       SetErrorCallback(ErrorCallback callback);
+  Statistics GetStatistics(int64_t now);
+
+  private:
+  struct Slot {
+    int64_t  Minute{-1};
+    uint32_t Count{0};
+  };
+
+  typedef std::pair<int64_t, std::string> Expiry;
+
+  template <size_t Size>
+  using Window = std::array<Slot, Size>;
+
+  void Add(const PlayerInfo& info, int64_t sign, int64_t now);
+  void Expire(int64_t now);
+  void Write(bool complete);
+
+  SQLite::Database& Session();
+
+  private:
+  std::string                   m_databasePath;
+  int64_t                       m_interval;
+  size_t                        m_shards{1};
+  std::unique_ptr<PeriodicTask> m_task{};
+  ErrorCallback                 m_onError{};
+
+  std::atomic<int64_t>  m_whitelisted{0};
+  std::atomic<int64_t>  m_blacklisted{0};
+  std::atomic<int64_t>  m_autoRecorded{0};
+  std::atomic<uint64_t> m_applied{0};
+  std::atomic<bool>     m_dirty{false};
+  std::atomic<bool>     m_counted{false}; // loaded complete or recounted
+
+  // Guards the timed bans and both windows.
+  std::mutex                               m_mutex;
+  std::unordered_map<std::string, int64_t> m_timedBans{};
+  std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>>
+                    m_expiries{};
+  Window<24 * 60>   m_newcomers{};
+  Window<60>        m_rejects{};
+
+  // Serialises the interval flush with the one Stop() does.
+  std::mutex                        m_sessionMutex;
+  std::unique_ptr<SQLite::Database> m_session{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,178 @@
+#include "plugin/Enforcement.h"
+
+#include <chrono>
+
+using namespace std::chrono;
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::EnforcementReport;
+using BedrockWhiteList::Utils::EnforcementSweep;
+
+
+// - - - - - - Roster - - - - - -
+
+
+void BedrockWhiteList::Utils::OnlineRoster::Join(
+    const string& playerUuid,
+    const string& sessionUuid
+) {
+  std::lock_guard lock(m_mutex);
+  m_online[playerUuid] = sessionUuid;
+}
+
+
+void BedrockWhiteList::Utils::OnlineRoster::Leave(const string& playerUuid) {
+  std::lock_guard lock(m_mutex);
+  m_online.erase(playerUuid);
+}
+
+
+size_t BedrockWhiteList::Utils::OnlineRoster::Size() const {
+  std::lock_guard lock(m_mutex);
+  return m_online.size();
+}
+
+
+string BedrockWhiteList::Utils::OnlineRoster::SessionUuid(const string& playerUuid
+) const {
+  std::lock_guard lock(m_mutex);
+
+  const auto it = m_online.find(playerUuid);
+  return it != m_online.end() ? it->second : string{};
+}
+
+
+vector<string>
+BedrockWhiteList::Utils::OnlineRoster::Intersect(const vector<string>& playerUuids
+) const {
+  std::lock_guard lock(m_mutex);
+
+  vector<string> online{};
+  for (auto& playerUuid : playerUuids) {
+    if (m_online.contains(playerUuid)) {
+      online.push_back(playerUuid);
+    }
+  }
+
+  return online;
+}
+
+
+vector<string> BedrockWhiteList::Utils::OnlineRoster::Snapshot() const {
+  std::lock_guard lock(m_mutex);
+
+  vector<string> online{};
+  online.reserve(m_online.size());
+  for (auto& [playerUuid, sessionUuid] : m_online) {
+    online.push_back(playerUuid);
+  }
+
+  return online;
+}
+
+
+// - - - - - - Sweep - - - - - -
+
+
+BedrockWhiteList::Utils::EnforcementSweep::EnforcementSweep(
+    const OnlineRoster&   roster,
+    const ConnectHandler& connect,
+    PlayerDB&             playerDB
+)
+: m_roster(roster),
+  m_connect(connect),
+  m_playerDB(playerDB) {}
+
+
+EnforcementReport
+BedrockWhiteList::Utils::EnforcementSweep::Sweep(const vector<PlayerInfo>& changed
+) const {
+  const auto startTime = steady_clock::now();
+
+  vector<string> playerUuids{};
+  playerUuids.reserve(changed.size());
+  for (auto& playerInfo : changed) {
+    playerUuids.push_back(playerInfo.PlayerUuid);
+  }
+
+  EnforcementReport report{};
+  report.Changed = changed.size();
+
+  for (auto& playerUuid : m_roster.Intersect(playerUuids)) {
+    report.Online++;
+
+    // The last write of a player in the batch is the one that stands.
+    for (auto it = changed.rbegin(); it != changed.rend(); ++it) {
+      if (it->PlayerUuid != playerUuid) {
+        continue;
+      }
+
+      auto outcome = m_connect.Review(playerUuid, *it);
+      if (not outcome.Admit()) {
+        report.Rejected.emplace_back(playerUuid, std::move(outcome));
+      }
+      break;
+    }
+  }
+
+  Record(
+      report,
+      duration_cast<microseconds>(steady_clock::now() - startTime).count()
+  );
+  return report;
+}
+
+
+EnforcementReport
+BedrockWhiteList::Utils::EnforcementSweep::Sweep(const vector<string>& playerUuids
+) const {
+  const auto startTime = steady_clock::now();
+
+  EnforcementReport report{};
+  report.Changed = playerUuids.size();
+
+  for (auto& playerUuid : m_roster.Intersect(playerUuids)) {
+    report.Online++;
+
+    auto outcome =
+        m_connect.Review(playerUuid, m_playerDB.GetPlayerInfoAsUUID(playerUuid));
+    if (not outcome.Admit()) {
+      report.Rejected.emplace_back(playerUuid, std::move(outcome));
+    }
+  }
+
+  Record(
+      report,
+      duration_cast<microseconds>(steady_clock::now() - startTime).count()
+  );
+  return report;
+}
+
+
+EnforcementReport BedrockWhiteList::Utils::EnforcementSweep::SweepAll() const {
+  return Sweep(m_roster.Snapshot());
+}
+
+
+void BedrockWhiteList::Utils::EnforcementSweep::Record(
+    EnforcementReport& report,
+    int64_t            micros
+) const {
+  report.Micros = micros;
+
+  m_sweeps++;
+  m_online   += report.Online;
+  m_rejected += report.Rejected.size();
+  m_lastMicros = micros;
+
+  auto slowest = m_maxMicros.load();
+  while (micros > slowest
+         and not m_maxMicros.compare_exchange_weak(slowest, micros)) {}
+}
+
+
+EnforcementSweep::Statistics
+BedrockWhiteList::Utils::EnforcementSweep::GetStatistics() const {
+  return {m_sweeps, m_online, m_rejected, m_lastMicros, m_maxMicros};
+}
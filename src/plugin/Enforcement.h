@@ -0,0 +1,113 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "plugin/Connect.h"
+#include "plugin/PlayerDB.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// The players on the server by the uuid the lists know them by, kept by the
+// join and disconnect listeners, with the uuid of their session: the two
+// differ for a player whose uuid changed since the xuid was first seen.
+class OnlineRoster {
+  public:
+  void Join(const std::string& playerUuid, const std::string& sessionUuid);
+  void Leave(const std::string& playerUuid);
+
+  size_t Size() const;
+
+  // The uuid the server knows the player by, to find the online Player;
+  // empty when not online.
+  std::string SessionUuid(const std::string& playerUuid) const;
+
+  // Those of playerUuids that are online, one probe each: the cost follows
+  // the size of the change, not the server or the lists.
+  std::vector<std::string>
+  Intersect(const std::vector<std::string>& playerUuids) const;
+  std::vector<std::string> Snapshot() const;
+
+  private:
+  mutable std::mutex                           m_mutex;
+  std::unordered_map<std::string, std::string> m_online{};
+};
+
+
+struct EnforcementReport {
+  std::vector<std::pair<std::string, ConnectOutcome>> Rejected{};
+  size_t                                              Changed{0};
+  size_t                                              Online{0};
+  int64_t                                             Micros{0};
+};
+
+
+/*
+ * Applies a change of the lists to the players already online, who passed
+ * the connect decision before it. A sweep of rows just written runs right
+ * after the change, on the game thread, so the caller can disconnect the
+ * rejected players in the same tick; the sweeps that read rows again are
+ * meant for a worker, and their disconnects for the next tick.
+ *
+ * Only the online players among the changed ones are decided again, with
+ * ConnectHandler::Review(); a handful of changes costs a few hash probes.
+ */
+class EnforcementSweep {
+  public:
+  struct Statistics {
+    uint64_t Sweeps;
+    uint64_t Online;
+    uint64_t Rejected;
+    int64_t  LastMicros;
+    int64_t  MaxMicros;
+  };
+
+  EnforcementSweep(
+      const OnlineRoster&   roster,
+      const ConnectHandler& connect,
+      PlayerDB&             playerDB
+  );
+
+  public:
+  // Rows as they were just written.
+  EnforcementReport Sweep(const std::vector<PlayerInfo>& changed) const;
+
+  // Players whose named lists changed; their rows are read again.
+  EnforcementReport Sweep(const std::vector<std::string>& playerUuids) const;
+
+  // Everyone online, after the rules or the admission expression changed.
+  EnforcementReport SweepAll() const;
+
+  Statistics GetStatistics() const;
+
+  private:
+  void Record(EnforcementReport& report, int64_t micros) const;
+
+  private:
+  const OnlineRoster&   m_roster;
+  const ConnectHandler& m_connect;
+  PlayerDB&             m_playerDB;
+
+  mutable std::atomic<uint64_t> m_sweeps{0};
+  mutable std::atomic<uint64_t> m_online{0};
+  mutable std::atomic<uint64_t> m_rejected{0};
+  mutable std::atomic<int64_t>  m_lastMicros{0};
+  mutable std::atomic<int64_t>  m_maxMicros{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,164 @@
+#include "plugin/Groups.h"
+
+#include <mutex>
+
+#include <fmt/format.h>
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::GroupCache;
+
+
+bool BedrockWhiteList::Utils::GroupCache::Register(
+    const vector<string>& groups,
+    Bits&                 bits,
+    uint64_t&             mask,
+    string&               error
+) {
+  mask = 0;
+
+  for (auto& group : groups) {
+    auto it = bits.find(group);
+    if (it == bits.end()) {
+      if (bits.size() >= MAX_GROUPS) {
+        error = fmt::format("no more than {} groups may be named", MAX_GROUPS);
+        return false;
+      }
+
+      it = bits.emplace(group, static_cast<uint32_t>(bits.size())).first;
+    }
+
+    mask |= uint64_t{1} << it->second;
+  }
+
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::GroupCache::SetBits(Bits bits) {
+  std::unique_lock lock(m_mutex);
+
+  m_bits = std::move(bits);
+  for (auto& [playerUuid, entry] : m_players) {
+    entry.Mask = MaskOf(entry.Groups);
+  }
+}
+
+
+void BedrockWhiteList::Utils::GroupCache::SetResolver(Resolver resolver) {
+  std::unique_lock lock(m_mutex);
+
+  // What the old resolver answered may not hold for the new one.
+  m_resolver = std::move(resolver);
+  m_players.clear();
+  m_resolved.clear();
+  m_generation++;
+}
+
+
+void BedrockWhiteList::Utils::GroupCache::Set(
+    const string&  playerUuid,
+    vector<string> groups
+) {
+  std::unique_lock lock(m_mutex);
+
+  const auto mask       = MaskOf(groups);
+  m_players[playerUuid] = {std::move(groups), mask, false};
+  m_generation++;
+  m_notifications.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void BedrockWhiteList::Utils::GroupCache::Invalidate(const string& playerUuid) {
+  std::unique_lock lock(m_mutex);
+
+  m_players.erase(playerUuid);
+  m_generation++;
+  m_notifications.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void BedrockWhiteList::Utils::GroupCache::InvalidateAll() {
+  std::unique_lock lock(m_mutex);
+
+  m_players.clear();
+  m_resolved.clear();
+  m_generation++;
+  m_notifications.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+uint64_t BedrockWhiteList::Utils::GroupCache::Mask(const string& playerUuid) {
+  Resolver resolver{};
+  uint64_t generation{0};
+  {
+    std::shared_lock lock(m_mutex);
+
+    const auto it = m_players.find(playerUuid);
+    if (it != m_players.end()) {
+      m_hits.fetch_add(1, std::memory_order_relaxed);
+      return it->second.Mask;
+    }
+
+    if (not m_resolver) {
+      return 0;
+    }
+
+    resolver   = m_resolver;
+    generation = m_generation;
+  }
+
+  m_misses.fetch_add(1, std::memory_order_relaxed);
+
+  // A player is remembered without groups too, so the resolver is asked once
+  // while the player is among the last MAX_RESOLVED.
+  auto groups = resolver(playerUuid);
+
+  std::unique_lock lock(m_mutex);
+
+  const auto mask = MaskOf(groups);
+  if (generation == m_generation
+      and m_players.emplace(playerUuid, Entry{std::move(groups), mask, true})
+              .second) {
+    m_resolved.push_back(playerUuid);
+
+    if (m_resolved.size() > MAX_RESOLVED) {
+      const auto oldest = m_players.find(m_resolved.front());
+      if (oldest != m_players.end() and oldest->second.Resolved) {
+        m_players.erase(oldest);
+      }
+      m_resolved.pop_front();
+    }
+  }
+
+  return mask;
+}
+
+
+GroupCache::Statistics BedrockWhiteList::Utils::GroupCache::GetStatistics() const {
+  std::shared_lock lock(m_mutex);
+
+  return {
+      m_bits.size(),
+      m_players.size(),
+      m_hits.load(std::memory_order_relaxed),
+      m_misses.load(std::memory_order_relaxed),
+      m_notifications.load(std::memory_order_relaxed),
+      static_cast<bool>(m_resolver)
+  };
+}
+
+
+// The caller holds m_mutex.
+uint64_t BedrockWhiteList::Utils::GroupCache::MaskOf(const vector<string>& groups
+) const {
+  uint64_t mask{0};
+  for (auto& group : groups) {
+    const auto it = m_bits.find(group);
+    if (it != m_bits.end()) {
+      mask |= uint64_t{1} << it->second;
+    }
+  }
+
+  return mask;
+}
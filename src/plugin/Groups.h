@@ -0,0 +1,116 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * The permission groups of each player, held as one bit per group a rule
+ * names, so a rule with groups costs the connect path one AND.
+ *
+ * A group permission plugin keeps it up to date through Api.h: it sets the
+ * groups of a player whenever they change, and may install a resolver that
+ * is asked the first time a player is looked up and again after an
+ * invalidation. Nothing is polled; a player no one told the cache about is
+ * in no group.
+ *
+ * Every compile of the rules gives bits to the group names into a map of its
+ * own, which replaces the one in use only once the whole table compiled; a
+ * group no rule names any more gives its bit back. The names of every player
+ * are kept too, so the masks follow a new map without a new query.
+ *
+ * Players the group plugin set are kept until it invalidates them. Resolver
+ * answers are kept for the last MAX_RESOLVED players it was asked about,
+ * older ones are asked again; without a resolver a miss keeps nothing.
+ */
+class GroupCache {
+  public:
+  typedef std::function<std::vector<std::string>(const std::string& playerUuid)>
+      Resolver;
+
+  // Group name to bit.
+  typedef std::unordered_map<std::string, uint32_t> Bits;
+
+  static constexpr size_t MAX_GROUPS   = 64;
+  static constexpr size_t MAX_RESOLVED = 16384;
+
+  struct Statistics {
+    size_t   Groups;  // with a bit
+    size_t   Players;
+    uint64_t Hits;
+    uint64_t Misses;  // asked the resolver
+    uint64_t Notifications;
+    bool     HasResolver;
+  };
+
+  public:
+  // The mask of groups in bits, giving bits to the names that have none yet.
+  // Fails when there are no bits left.
+  static bool Register(
+      const std::vector<std::string>& groups,
+      Bits&                           bits,
+      uint64_t&                       mask,
+      std::string&                    error
+  );
+
+  // Puts bits in use and works the mask of every player out again.
+  void SetBits(Bits bits);
+
+  // From any thread; the resolver runs on the thread that looks up the
+  // player, without the cache locked. Null removes it.
+  void SetResolver(Resolver resolver);
+
+  void Set(const std::string& playerUuid, std::vector<std::string> groups);
+  void Invalidate(const std::string& playerUuid);
+  void InvalidateAll();
+
+  uint64_t Mask(const std::string& playerUuid);
+
+  Statistics GetStatistics() const;
+
+  private:
+  struct Entry {
+    std::vector<std::string> Groups;
+    uint64_t                 Mask;
+    bool                     Resolved; // answered by the resolver, not set
+  };
+
+  uint64_t MaskOf(const std::vector<std::string>& groups) const;
+
+  private:
+  mutable std::shared_mutex              m_mutex;
+  Bits                                   m_bits{};
+  std::unordered_map<std::string, Entry> m_players{};
+  Resolver                               m_resolver{};
+
+  // Resolved players, oldest first; some may have been set or invalidated
+  // since.
+  std::deque<std::string> m_resolved{};
+
+  // Bumped by every notification, a resolver answer that raced one is not
+  // kept.
+  uint64_t m_generation{0};
+
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+  std::atomic<uint64_t> m_notifications{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,331 @@
+#include "plugin/Identity.h"
+
+#include <algorithm>
+#include <cctype>
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::IdentityIndex;
+using BedrockWhiteList::Utils::PlayerIdentity;
+
+
+constexpr const char* SELECT_IDENTITY =
+    "SELECT i.player_xuid, i.player_uuid, i.player_name, i.identity_first_seen "
+    "FROM player_identities i ";
+
+
+inline static bool IsUuid(const string& key) {
+  if (key.size() != 36) {
+    return false;
+  }
+
+  for (size_t i = 0; i < key.size(); i++) {
+    const auto c    = static_cast<unsigned char>(key[i]);
+    const bool dash = i == 8 or i == 13 or i == 18 or i == 23;
+
+    if (dash ? c != '-' : not std::isxdigit(c)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::PlayerIdentity::Empty() const { return Xuid == 0; }
+
+
+// - - - - - - Index - - - - - -
+
+
+BedrockWhiteList::Utils::IdentityIndex::IdentityIndex(
+    string  databasePath,
+    int64_t interval
+)
+: m_databasePath(std::move(databasePath)),
+  m_interval(interval) {}
+
+
+BedrockWhiteList::Utils::IdentityIndex::~IdentityIndex() { Stop(); }
+
+
+uint64_t BedrockWhiteList::Utils::IdentityIndex::ParseXuid(const string& xuid) {
+  if (xuid.empty() or xuid.size() > 19
+      or not std::all_of(xuid.begin(), xuid.end(), [](unsigned char c) {
+           return std::isdigit(c);
+         })) {
+    return 0;
+  }
+
+  return std::stoull(xuid);
+}
+
+
+SQLite::Database& BedrockWhiteList::Utils::IdentityIndex::Session() {
+  if (m_session == nullptr) {
+    m_session =
+        std::make_unique<SQLite::Database>(m_databasePath, SQLite::OPEN_READWRITE);
+    m_session->setBusyTimeout(1000);
+  }
+
+  return *m_session;
+}
+
+
+size_t BedrockWhiteList::Utils::IdentityIndex::Load() {
+  std::unordered_map<uint64_t, Entry> identities{};
+  {
+    std::lock_guard   sessionLock(m_sessionMutex);
+    SQLite::Statement query(
+        Session(),
+        "SELECT player_xuid, player_uuid, player_name FROM player_identities"
+    );
+
+    while (query.executeStep()) {
+      identities.emplace(
+          static_cast<uint64_t>(query.getColumn(0).getInt64()),
+          Entry{query.getColumn(1).getString(), query.getColumn(2).getString()}
+      );
+    }
+  }
+
+  std::unique_lock lock(m_mutex);
+  m_identities.swap(identities);
+  return m_identities.size();
+}
+
+
+void BedrockWhiteList::Utils::IdentityIndex::Start() {
+  if (m_task != nullptr) {
+    return;
+  }
+
+  m_task = std::make_unique<PeriodicTask>(
+      std::chrono::seconds(m_interval),
+      [this](auto&) { Flush(); }
+  );
+  m_task->SetErrorHandler(m_onError);
+  m_task->Start();
+}
+
+
+void BedrockWhiteList::Utils::IdentityIndex::Stop() {
+  if (m_task != nullptr) {
+    m_task->Stop();
+    m_task.reset();
+  }
+
+  try {
+    Flush();
+  } catch (std::exception& e) {
+    if (m_onError) {
+      m_onError(e);
+    }
+  }
+
+  std::lock_guard sessionLock(m_sessionMutex);
+  m_session.reset();
+}
+
+
+bool BedrockWhiteList::Utils::IdentityIndex::Resolve(
+    uint64_t        xuid,
+    PlayerIdentity& identity
+) const {
+  std::shared_lock lock(m_mutex);
+
+  const auto it = m_identities.find(xuid);
+  if (it == m_identities.end()) {
+    return false;
+  }
+
+  identity.Xuid       = xuid;
+  identity.PlayerUuid = it->second.PlayerUuid;
+  identity.PlayerName = it->second.PlayerName;
+  return true;
+}
+
+
+string BedrockWhiteList::Utils::IdentityIndex::Observe(
+    uint64_t      xuid,
+    const string& playerUuid,
+    const string& playerName,
+    int64_t       time
+) {
+  // Known under the same name is every join but the first and a rename.
+  {
+    std::shared_lock lock(m_mutex);
+
+    const auto it = m_identities.find(xuid);
+    if (it != m_identities.end() and it->second.PlayerName == playerName) {
+      m_resolved++;
+      return it->second.PlayerUuid;
+    }
+  }
+
+
+  std::unique_lock lock(m_mutex);
+
+  auto [it, inserted] =
+      m_identities.try_emplace(xuid, Entry{playerUuid, playerName});
+  if (not inserted) {
+    m_resolved++;
+    if (it->second.PlayerName == playerName) {
+      return it->second.PlayerUuid;
+    }
+
+    it->second.PlayerName = playerName;
+    m_renamed++;
+  }
+
+  m_pending.push_back({xuid, it->second.PlayerUuid, playerName, time});
+
+  return it->second.PlayerUuid;
+}
+
+
+void BedrockWhiteList::Utils::IdentityIndex::Flush() {
+  std::lock_guard sessionLock(m_sessionMutex);
+  WritePending();
+}
+
+
+// The uuid of a known player stays as it was.
+void BedrockWhiteList::Utils::IdentityIndex::WritePending() {
+  vector<Change> changes{};
+  {
+    std::unique_lock lock(m_mutex);
+    changes.swap(m_pending);
+  }
+
+  if (changes.empty()) {
+    return;
+  }
+
+  try {
+
+    auto&               session = Session();
+    SQLite::Transaction transaction(session);
+
+    SQLite::Statement identity(
+        session,
+        "INSERT INTO player_identities"
+        "(player_xuid, player_uuid, player_name, identity_first_seen) "
+        "VALUES(?, ?, ?, ?) ON CONFLICT(player_xuid) "
+        "DO UPDATE SET player_name = excluded.player_name"
+    );
+    SQLite::Statement name(
+        session,
+        "INSERT OR REPLACE INTO player_names(player_name, player_xuid, name_since) "
+        "VALUES(?, ?, ?)"
+    );
+
+    for (auto& change : changes) {
+      identity.bind(1, static_cast<int64_t>(change.Xuid));
+      identity.bind(2, change.PlayerUuid);
+      identity.bind(3, change.PlayerName);
+      identity.bind(4, change.Time);
+      identity.exec();
+      identity.reset();
+
+      name.bind(1, change.PlayerName);
+      name.bind(2, static_cast<int64_t>(change.Xuid));
+      name.bind(3, change.Time);
+      name.exec();
+      name.reset();
+    }
+
+    transaction.commit();
+
+  } catch (...) {
+    // Put the changes back for the next flush, in front of newer ones.
+    std::unique_lock lock(m_mutex);
+    changes.insert(changes.end(), m_pending.begin(), m_pending.end());
+    m_pending.swap(changes);
+
+    throw;
+  }
+
+  m_recorded += changes.size();
+}
+
+
+vector<PlayerIdentity>
+BedrockWhiteList::Utils::IdentityIndex::Find(const string& key, size_t nameLimit) {
+  std::lock_guard sessionLock(m_sessionMutex);
+
+  // Joins wait for the next flush otherwise, up to the whole interval.
+  WritePending();
+
+  auto& session = Session();
+
+  std::unique_ptr<SQLite::Statement> query{};
+  if (const auto xuid = ParseXuid(key); xuid != 0) {
+    query = std::make_unique<SQLite::Statement>(
+        session,
+        string(SELECT_IDENTITY) + "WHERE i.player_xuid = ?"
+    );
+    query->bind(1, static_cast<int64_t>(xuid));
+  } else if (IsUuid(key)) {
+    query = std::make_unique<SQLite::Statement>(
+        session,
+        string(SELECT_IDENTITY) + "WHERE i.player_uuid = ?"
+    );
+    query->bind(1, key);
+  } else {
+    // player_names is keyed by the name, NOCASE.
+    query = std::make_unique<SQLite::Statement>(
+        session,
+        string(SELECT_IDENTITY)
+            + "JOIN player_names n ON n.player_xuid = i.player_xuid "
+              "WHERE n.player_name = ?"
+    );
+    query->bind(1, key);
+  }
+
+  vector<PlayerIdentity> found{};
+  while (query->executeStep()) {
+    PlayerIdentity identity{};
+    identity.Xuid       = static_cast<uint64_t>(query->getColumn(0).getInt64());
+    identity.PlayerUuid = query->getColumn(1).getString();
+    identity.PlayerName = query->getColumn(2).getString();
+    identity.FirstSeen  = query->getColumn(3).getInt64();
+    found.push_back(std::move(identity));
+  }
+
+  if (nameLimit == 0) {
+    return found;
+  }
+
+  SQLite::Statement names(
+      session,
+      "SELECT player_name, name_since FROM player_names "
+      "WHERE player_xuid = ? ORDER BY name_since DESC LIMIT ?"
+  );
+  for (auto& identity : found) {
+    names.bind(1, static_cast<int64_t>(identity.Xuid));
+    names.bind(2, static_cast<int64_t>(nameLimit));
+
+    while (names.executeStep()) {
+      identity.Names.push_back(
+          {names.getColumn(0).getString(), names.getColumn(1).getInt64()}
+      );
+    }
+    names.reset();
+  }
+
+  return found;
+}
+
+
+void BedrockWhiteList::Utils::IdentityIndex::SetErrorCallback(ErrorCallback callback
+) {
+  m_onError = std::move(callback);
+}
+
+
+IdentityIndex::Statistics BedrockWhiteList::Utils::IdentityIndex::GetStatistics(
+) const {
+  std::shared_lock lock(m_mutex);
+  return {m_identities.size(), m_resolved, m_recorded, m_renamed};
+}
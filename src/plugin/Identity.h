@@ -0,0 +1,142 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// A name a player joined with, from the first join with it on.
+struct NameRecord {
+  std::string Name;
+  int64_t     Since;
+};
+
+
+struct PlayerIdentity {
+  uint64_t                Xuid{0};
+  std::string             PlayerUuid; // the one the lists know the player by
+  std::string             PlayerName; // the latest one
+  int64_t                 FirstSeen{0};
+  std::vector<NameRecord> Names{};    // newest first, filled by Find()
+
+  bool Empty() const;
+};
+
+
+/*
+ * Players by their Xbox Live id, which stays when they rename. Stored in
+ * player_identities with the xuid as INTEGER PRIMARY KEY, that is the rowid
+ * itself, next to the uuid and the latest name; every name a player joined
+ * with goes to player_names.
+ *
+ * All identities are held in memory, so the connect path resolves a xuid
+ * with one integer probe. New and renamed players are queued and written in
+ * one transaction every interval, as the last-seen times are; the writes of
+ * a connect storm do not queue up against the newcomer writes.
+ */
+class IdentityIndex {
+  public:
+  typedef std::function<void(const std::exception&)> ErrorCallback;
+
+  struct Statistics {
+    uint64_t Identities;
+    uint64_t Resolved;
+    uint64_t Recorded;
+    uint64_t Renamed;
+  };
+
+  IdentityIndex(std::string databasePath, int64_t interval);
+  ~IdentityIndex();
+
+  IdentityIndex(const IdentityIndex&)            = delete;
+  IdentityIndex& operator=(const IdentityIndex&) = delete;
+
+  public:
+  // 0 when xuid is not one, offline players have none.
+  static uint64_t ParseXuid(const std::string& xuid);
+
+  size_t Load();
+
+  void Start();
+  // Also writes what is queued.
+  void Stop();
+  void Flush();
+
+  // From memory.
+  bool Resolve(uint64_t xuid, PlayerIdentity& identity) const;
+
+  // Records a join and returns the uuid the player is known by: the first
+  // one seen with xuid, playerUuid for a new player.
+  std::string Observe(
+      uint64_t           xuid,
+      const std::string& playerUuid,
+      const std::string& playerName,
+      int64_t            time
+  );
+
+  // By a xuid, a uuid, or a current or former name, case-insensitively;
+  // one indexed lookup whichever it is, after writing what is queued. A
+  // name may have been used by more than one player.
+  std::vector<PlayerIdentity> Find(const std::string& key, size_t nameLimit);
+
+  void       SetErrorCallback(ErrorCallback callback);
+  Statistics GetStatistics() const;
+
+  private:
+  struct Entry {
+    std::string PlayerUuid;
+    std::string PlayerName;
+  };
+
+  struct Change {
+    uint64_t    Xuid;
+    std::string PlayerUuid;
+    std::string PlayerName;
+    int64_t     Time;
+  };
+
+  SQLite::Database& Session();
+  // With m_sessionMutex held.
+  void WritePending();
+
+  private:
+  std::string                   m_databasePath;
+  int64_t                       m_interval;
+  std::unique_ptr<PeriodicTask> m_task{};
+  ErrorCallback                 m_onError{};
+
+  mutable std::shared_mutex           m_mutex;
+  std::unordered_map<uint64_t, Entry> m_identities{};
+  std::vector<Change>                 m_pending{};
+
+  // Flush() and Find() on the command workers share it.
+  std::mutex                        m_sessionMutex;
+  std::unique_ptr<SQLite::Database> m_session{};
+
+  std::atomic<uint64_t> m_resolved{0};
+  std::atomic<uint64_t> m_recorded{0};
+  std::atomic<uint64_t> m_renamed{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,698 @@
+#include "plugin/Journal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fmt/core.h>
+
+using std::string, std::vector;
+
+namespace filesystem = std::filesystem;
+
+using BedrockWhiteList::Utils::JournalRecord;
+
+
+constexpr uint8_t  JOURNAL_RECORD_VERSION = 1;
+constexpr uint32_t JOURNAL_HEADER_SIZE    = 8;
+constexpr uint32_t JOURNAL_MAX_PAYLOAD    = 64 * 1024;
+constexpr auto     JOURNAL_EXTENSION      = ".journal";
+constexpr auto     INDEX_EXTENSION        = ".index";
+constexpr auto     TEMPORARY_EXTENSION    = ".tmp";
+
+
+// - - - - - - - - - - - - - - - - Encoding - - - - - - - - - - - - - - - -
+
+
+uint64_t BedrockWhiteList::Utils::Fnv1a64(const void* data, size_t length) {
+  auto     bytes = static_cast<const uint8_t*>(data);
+  uint64_t hash  = 0xcbf29ce484222325ull;
+
+  for (size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+
+inline static uint32_t Checksum(const uint8_t* data, size_t length) {
+  auto hash = BedrockWhiteList::Utils::Fnv1a64(data, length);
+  return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+
+inline static uint64_t HashUuid(const string& uuid) {
+  return BedrockWhiteList::Utils::Fnv1a64(uuid.data(), uuid.size());
+}
+
+
+inline static void PutInt(vector<uint8_t>& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+
+inline static void PutString(vector<uint8_t>& out, const string& value) {
+  const auto length = std::min<size_t>(value.size(), 0xFFFF);
+  PutInt(out, length, 2);
+  out.insert(out.end(), value.begin(), value.begin() + length);
+}
+
+
+inline static void EncodeRecord(const JournalRecord& record, vector<uint8_t>& out) {
+  const auto start = out.size();
+  out.resize(start + JOURNAL_HEADER_SIZE);
+
+  out.push_back(JOURNAL_RECORD_VERSION);
+  PutInt(out, static_cast<uint64_t>(record.Timestamp), 8);
+  out.push_back(record.OldStatus);
+  out.push_back(record.NewStatus);
+  PutInt(out, static_cast<uint64_t>(record.OldLastTime), 8);
+  PutInt(out, static_cast<uint64_t>(record.NewLastTime), 8);
+  PutString(out, record.Actor);
+  PutString(out, record.PlayerUuid);
+  PutString(out, record.PlayerName);
+
+  const auto length   = static_cast<uint32_t>(out.size() - start - JOURNAL_HEADER_SIZE);
+  const auto checksum = Checksum(&out[start + JOURNAL_HEADER_SIZE], length);
+
+  for (int i = 0; i < 4; i++) {
+    out[start + i]     = static_cast<uint8_t>(length >> (8 * i));
+    out[start + 4 + i] = static_cast<uint8_t>(checksum >> (8 * i));
+  }
+}
+
+
+struct RecordReader {
+  const uint8_t* data;
+  size_t         length;
+  size_t         cursor{0};
+
+  bool Int(uint64_t& value, int bytes) {
+    if (cursor + bytes > length) {
+      return false;
+    }
+
+    value = 0;
+    for (int i = 0; i < bytes; i++) {
+      value |= static_cast<uint64_t>(data[cursor++]) << (8 * i);
+    }
+    return true;
+  }
+
+  bool String(string& value) {
+    uint64_t size{};
+    if (not Int(size, 2) or cursor + size > length) {
+      return false;
+    }
+
+    value.assign(reinterpret_cast<const char*>(data + cursor), size);
+    cursor += size;
+    return true;
+  }
+};
+
+
+inline static bool
+DecodeRecord(const uint8_t* data, size_t length, JournalRecord& record) {
+  RecordReader reader{data, length};
+  uint64_t     version{}, timestamp{}, oldStatus{}, newStatus{}, oldLast{},
+      newLast{};
+
+  if (not(reader.Int(version, 1) and version == JOURNAL_RECORD_VERSION
+          and reader.Int(timestamp, 8) and reader.Int(oldStatus, 1)
+          and reader.Int(newStatus, 1) and reader.Int(oldLast, 8)
+          and reader.Int(newLast, 8) and reader.String(record.Actor)
+          and reader.String(record.PlayerUuid)
+          and reader.String(record.PlayerName))) {
+    return false;
+  }
+
+  record.Timestamp   = static_cast<int64_t>(timestamp);
+  record.OldStatus   = static_cast<uint8_t>(oldStatus);
+  record.NewStatus   = static_cast<uint8_t>(newStatus);
+  record.OldLastTime = static_cast<int64_t>(oldLast);
+  record.NewLastTime = static_cast<int64_t>(newLast);
+  return true;
+}
+
+
+// Reads one record at the stream position. Returns false at the end of the
+// file or on a torn / corrupted record.
+inline static bool ReadRecord(std::ifstream& in, JournalRecord& record) {
+  uint8_t header[JOURNAL_HEADER_SIZE]{};
+  if (not in.read(reinterpret_cast<char*>(header), JOURNAL_HEADER_SIZE)) {
+    return false;
+  }
+
+  uint32_t length{}, checksum{};
+  for (int i = 0; i < 4; i++) {
+    length   |= static_cast<uint32_t>(header[i]) << (8 * i);
+    checksum |= static_cast<uint32_t>(header[4 + i]) << (8 * i);
+  }
+
+  if (length == 0 or length > JOURNAL_MAX_PAYLOAD) {
+    return false;
+  }
+
+  vector<uint8_t> payload(length);
+  if (not in.read(reinterpret_cast<char*>(payload.data()), length)) {
+    return false;
+  }
+
+  return Checksum(payload.data(), length) == checksum
+     and DecodeRecord(payload.data(), length, record);
+}
+
+
+inline static int64_t NowUnix() { return std::time(nullptr); }
+
+
+// - - - - - - - - - - - - - - - - Journal - - - - - - - - - - - - - - - -
+
+
+BedrockWhiteList::Utils::AuditJournal::AuditJournal(Options options)
+: m_options(std::move(options)) {}
+
+
+BedrockWhiteList::Utils::AuditJournal::~AuditJournal() { Stop(); }
+
+
+void BedrockWhiteList::Utils::AuditJournal::Start() {
+  if (m_writer.joinable()) {
+    return;
+  }
+
+  filesystem::create_directories(m_options.directory);
+  Recover();
+
+  m_stopping       = false;
+  m_lastCompaction = NowUnix();
+  m_writer         = std::thread(&AuditJournal::WriterLoop, this);
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::Stop() {
+  {
+    std::lock_guard lock(m_queueMutex);
+    m_stopping = true;
+  }
+  m_queueCond.notify_all();
+
+  if (m_writer.joinable()) {
+    m_writer.join();
+  }
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::Append(JournalRecord record) {
+  if (record.Timestamp == 0) {
+    record.Timestamp = NowUnix();
+  }
+
+  {
+    std::lock_guard lock(m_queueMutex);
+
+    if (m_pending.size() >= m_options.maxPending) {
+      m_dropped++;
+      return;
+    }
+
+    m_pending.push_back(std::move(record));
+  }
+
+  m_appended++;
+  m_queueCond.notify_one();
+}
+
+
+BedrockWhiteList::Utils::AuditJournal::Statistics
+BedrockWhiteList::Utils::AuditJournal::GetStatistics() const {
+  return {m_appended, m_written, m_dropped, m_compactions};
+}
+
+
+filesystem::path
+BedrockWhiteList::Utils::AuditJournal::SegmentPath(uint32_t sequence) const {
+  return filesystem::path(m_options.directory)
+       / fmt::format("{0:08}{1}", sequence, JOURNAL_EXTENSION);
+}
+
+
+filesystem::path
+BedrockWhiteList::Utils::AuditJournal::IndexPath(uint32_t sequence) const {
+  return filesystem::path(m_options.directory)
+       / fmt::format("{0:08}{1}", sequence, INDEX_EXTENSION);
+}
+
+
+// Lists the segments a compaction emptied; its being there commits it.
+filesystem::path BedrockWhiteList::Utils::AuditJournal::CompactionPath() const {
+  return filesystem::path(m_options.directory) / "compaction";
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::WriterLoop() {
+  vector<JournalRecord> batch{};
+
+  while (true) {
+    {
+      std::unique_lock lock(m_queueMutex);
+      m_queueCond.wait_for(lock, std::chrono::seconds(1), [this] {
+        return m_stopping or not m_pending.empty();
+      });
+
+      batch.swap(m_pending);
+
+      if (m_stopping and batch.empty()) {
+        break;
+      }
+    }
+
+    if (not batch.empty()) {
+      WriteBatch(batch);
+      batch.clear();
+    }
+
+    if (m_options.compactInterval > 0
+        and NowUnix() - m_lastCompaction >= m_options.compactInterval) {
+      Compact();
+      m_lastCompaction = NowUnix();
+    }
+  }
+
+  m_activeFile.close();
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::WriteBatch(
+    const vector<JournalRecord>& batch
+) {
+  vector<uint8_t>    buffer{};
+  vector<IndexEntry> entries{};
+
+  auto flush = [&]() {
+    m_activeFile.write(
+        reinterpret_cast<const char*>(buffer.data()),
+        static_cast<std::streamsize>(buffer.size())
+    );
+    m_activeFile.flush();
+    m_activeSize += buffer.size();
+    m_written    += entries.size();
+
+    {
+      std::unique_lock lock(m_segmentMutex);
+      m_activeIndex.insert(m_activeIndex.end(), entries.begin(), entries.end());
+    }
+
+    buffer.clear();
+    entries.clear();
+
+    if (m_activeSize >= m_options.maxSegmentSize) {
+      SealActiveSegment();
+    }
+  };
+
+  for (auto& record : batch) {
+    entries.push_back(
+        {HashUuid(record.PlayerUuid),
+         static_cast<uint32_t>(m_activeSize + buffer.size())}
+    );
+    EncodeRecord(record, buffer);
+
+    if (m_activeSize + buffer.size() >= m_options.maxSegmentSize) {
+      flush();
+    }
+  }
+
+  if (not buffer.empty()) {
+    flush();
+  }
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::Recover() {
+  // A compaction cut short is finished if it was committed, otherwise its
+  // output is thrown away and the old segments stay.
+  if (filesystem::exists(CompactionPath())) {
+    FinishCompaction();
+  } else {
+    for (auto& entry : filesystem::directory_iterator(m_options.directory)) {
+      if (entry.path().extension() == TEMPORARY_EXTENSION) {
+        filesystem::remove(entry.path());
+      }
+    }
+    filesystem::remove(CompactionPath().string() + ".pending");
+  }
+
+  vector<uint32_t> sequences{};
+
+  for (auto& entry : filesystem::directory_iterator(m_options.directory)) {
+    if (entry.path().extension() != JOURNAL_EXTENSION) {
+      continue;
+    }
+
+    try {
+      sequences.push_back(std::stoul(entry.path().stem().string()));
+    } catch (std::exception&) {
+      continue;
+    }
+  }
+  std::sort(sequences.begin(), sequences.end());
+
+  std::unique_lock lock(m_segmentMutex);
+  m_sealed.clear();
+
+  if (sequences.empty()) {
+    m_activeSequence = 1;
+    OpenActiveSegment();
+    return;
+  }
+
+  // Every segment but the newest is sealed; rebuild any index lost in a crash.
+  for (size_t i = 0; i + 1 < sequences.size(); i++) {
+    if (not filesystem::exists(IndexPath(sequences[i]))) {
+      WriteIndex(IndexPath(sequences[i]), ScanSegment(SegmentPath(sequences[i]), nullptr));
+    }
+    m_sealed.push_back(sequences[i]);
+  }
+
+  // Cut a torn tail off the active segment before appending to it again.
+  uint64_t validLength{0};
+  m_activeSequence = sequences.back();
+  m_activeIndex    = ScanSegment(SegmentPath(m_activeSequence), &validLength);
+
+  if (filesystem::file_size(SegmentPath(m_activeSequence)) != validLength) {
+    filesystem::resize_file(SegmentPath(m_activeSequence), validLength);
+  }
+
+  m_activeSize = validLength;
+  m_activeFile.open(
+      SegmentPath(m_activeSequence),
+      std::ios::binary | std::ios::out | std::ios::app
+  );
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::OpenActiveSegment() {
+  m_activeIndex.clear();
+  m_activeSize = 0;
+  m_activeFile.open(
+      SegmentPath(m_activeSequence),
+      std::ios::binary | std::ios::out | std::ios::trunc
+  );
+}
+
+
+// The sequence moves on together with the index and the file it belongs
+// to, so a query never reads the new segment at the offsets of the old one.
+void BedrockWhiteList::Utils::AuditJournal::SealActiveSegment() {
+  m_activeFile.close();
+  WriteIndex(IndexPath(m_activeSequence), m_activeIndex);
+
+  std::unique_lock lock(m_segmentMutex);
+  m_sealed.push_back(m_activeSequence);
+  m_activeSequence++;
+  OpenActiveSegment();
+
+  // Rotate the oldest segments out once the journal is over its budget.
+  while (m_sealed.size() > m_options.maxSegments) {
+    filesystem::remove(SegmentPath(m_sealed.front()));
+    filesystem::remove(IndexPath(m_sealed.front()));
+    m_sealed.erase(m_sealed.begin());
+  }
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::Compact() {
+  vector<uint32_t> sealed{};
+  {
+    std::shared_lock lock(m_segmentMutex);
+    sealed = m_sealed;
+  }
+
+  if (sealed.empty()) {
+    return;
+  }
+
+  // Rewrite the surviving records into as few segments as possible. The
+  // output reuses the lowest input sequence numbers so ordering is kept, and
+  // is written to temporary files while queries still read the originals.
+  const auto cutoff = NowUnix() - m_options.retention;
+
+  vector<uint32_t> outputs{};
+  std::ofstream    out{};
+  uint64_t         outSize{0};
+  vector<uint8_t>  buffer{};
+
+  auto nextOutput = [&]() {
+    if (out.is_open()) {
+      out.close();
+    }
+    outputs.push_back(sealed[outputs.size()]);
+    out.open(
+        SegmentPath(outputs.back()).string() + TEMPORARY_EXTENSION,
+        std::ios::binary | std::ios::out | std::ios::trunc
+    );
+    outSize = 0;
+  };
+
+  uint64_t dropped{0};
+  for (auto sequence : sealed) {
+    std::ifstream in(SegmentPath(sequence), std::ios::binary);
+    JournalRecord record{};
+
+    while (ReadRecord(in, record)) {
+      if (record.Timestamp < cutoff) {
+        dropped++;
+        continue;
+      }
+
+      buffer.clear();
+      EncodeRecord(record, buffer);
+
+      if (outputs.empty() or outSize + buffer.size() > m_options.maxSegmentSize) {
+        nextOutput();
+      }
+
+      out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+      outSize += buffer.size();
+    }
+  }
+  out.close();
+
+  if (dropped == 0 and outputs.size() == sealed.size()) {
+    for (auto sequence : outputs) {
+      filesystem::remove(SegmentPath(sequence).string() + TEMPORARY_EXTENSION);
+    }
+    return;
+  }
+
+  for (auto sequence : outputs) {
+    WriteIndex(
+        IndexPath(sequence).string() + TEMPORARY_EXTENSION,
+        ScanSegment(
+            SegmentPath(sequence).string() + TEMPORARY_EXTENSION,
+            nullptr
+        )
+    );
+  }
+
+  // Committed once the marker is renamed into place; a crash before leaves
+  // the old segments, one after is finished by Recover().
+  {
+    std::ofstream marker(
+        CompactionPath().string() + ".pending",
+        std::ios::out | std::ios::trunc
+    );
+    for (size_t i = outputs.size(); i < sealed.size(); i++) {
+      marker << sealed[i] << '\n';
+    }
+  }
+  filesystem::rename(CompactionPath().string() + ".pending", CompactionPath());
+
+  std::unique_lock lock(m_segmentMutex);
+  FinishCompaction();
+
+  m_sealed = outputs;
+  m_compactions++;
+}
+
+
+// Every rewritten file is renamed over the one it replaces, which swaps it
+// in one step (MoveFileExW with MOVEFILE_REPLACE_EXISTING on Windows), so a
+// sequence is always either all old or all new records. Run again after a
+// crash, it picks up the files not renamed yet.
+void BedrockWhiteList::Utils::AuditJournal::FinishCompaction() {
+  vector<filesystem::path> outputs{};
+  for (auto& entry : filesystem::directory_iterator(m_options.directory)) {
+    const auto& path = entry.path();
+    const auto  kind = path.stem().extension();
+
+    if (path.extension() == TEMPORARY_EXTENSION
+        and (kind == JOURNAL_EXTENSION or kind == INDEX_EXTENSION)) {
+      outputs.push_back(path);
+    }
+  }
+
+  for (auto& output : outputs) {
+    filesystem::rename(output, filesystem::path(output).replace_extension());
+  }
+
+  std::ifstream marker(CompactionPath());
+  uint32_t      sequence{0};
+  while (marker >> sequence) {
+    filesystem::remove(SegmentPath(sequence));
+    filesystem::remove(IndexPath(sequence));
+  }
+  marker.close();
+
+  filesystem::remove(CompactionPath());
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::WriteIndex(
+    const filesystem::path& path,
+    vector<IndexEntry>      entries
+) {
+  std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) {
+    return a.Hash < b.Hash or (a.Hash == b.Hash and a.Offset < b.Offset);
+  });
+
+  vector<uint8_t> buffer{};
+  buffer.reserve(entries.size() * 12);
+
+  for (auto& entry : entries) {
+    PutInt(buffer, entry.Hash, 8);
+    PutInt(buffer, entry.Offset, 4);
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::out | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+
+vector<BedrockWhiteList::Utils::AuditJournal::IndexEntry>
+BedrockWhiteList::Utils::AuditJournal::ScanSegment(
+    const filesystem::path& path,
+    uint64_t*               validLength
+) {
+  vector<IndexEntry> entries{};
+  std::ifstream      in(path, std::ios::binary);
+  JournalRecord      record{};
+  uint64_t           offset{0};
+
+  while (ReadRecord(in, record)) {
+    entries.push_back({HashUuid(record.PlayerUuid), static_cast<uint32_t>(offset)}
+    );
+    offset = static_cast<uint64_t>(in.tellg());
+  }
+
+  if (validLength != nullptr) {
+    *validLength = offset;
+  }
+
+  return entries;
+}
+
+
+void BedrockWhiteList::Utils::AuditJournal::ReadMatching(
+    const filesystem::path&  segment,
+    const vector<uint32_t>&  offsets,
+    const string&            playerUuid,
+    size_t                   limit,
+    vector<JournalRecord>&   result
+) {
+  if (offsets.empty()) {
+    return;
+  }
+
+  std::ifstream in(segment, std::ios::binary);
+  JournalRecord record{};
+
+  // Offsets are ascending, walk them backwards for newest first.
+  for (auto it = offsets.rbegin(); it != offsets.rend(); it++) {
+    if (result.size() >= limit) {
+      return;
+    }
+
+    in.clear();
+    in.seekg(*it);
+
+    if (ReadRecord(in, record) and record.PlayerUuid == playerUuid) {
+      result.push_back(record);
+    }
+  }
+}
+
+
+vector<JournalRecord> BedrockWhiteList::Utils::AuditJournal::Query(
+    const string& playerUuid,
+    size_t        limit
+) const {
+  const auto            hash = HashUuid(playerUuid);
+  vector<JournalRecord> result{};
+  vector<uint32_t>      offsets{};
+
+  std::shared_lock lock(m_segmentMutex);
+
+  for (auto& entry : m_activeIndex) {
+    if (entry.Hash == hash) {
+      offsets.push_back(entry.Offset);
+    }
+  }
+  ReadMatching(SegmentPath(m_activeSequence), offsets, playerUuid, limit, result);
+
+  for (auto it = m_sealed.rbegin(); it != m_sealed.rend(); it++) {
+    if (result.size() >= limit) {
+      break;
+    }
+
+    // The index is an array of fixed 12 byte entries sorted by hash.
+    std::ifstream index(IndexPath(*it), std::ios::binary | std::ios::ate);
+    if (not index) {
+      continue;
+    }
+
+    const auto count = static_cast<uint64_t>(index.tellg()) / 12;
+    auto       readEntry = [&](uint64_t position, IndexEntry& entry) {
+      uint8_t raw[12]{};
+      index.seekg(position * 12);
+      index.read(reinterpret_cast<char*>(raw), 12);
+
+      RecordReader reader{raw, 12};
+      uint64_t     offset{};
+      reader.Int(entry.Hash, 8);
+      reader.Int(offset, 4);
+      entry.Offset = static_cast<uint32_t>(offset);
+    };
+
+    // Lower bound on the hash.
+    uint64_t   low{0}, high{count};
+    IndexEntry entry{};
+    while (low < high) {
+      const auto middle = (low + high) / 2;
+      readEntry(middle, entry);
+      if (entry.Hash < hash) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    offsets.clear();
+    for (; low < count; low++) {
+      readEntry(low, entry);
+      if (entry.Hash != hash) {
+        break;
+      }
+      offsets.push_back(entry.Offset);
+    }
+
+    ReadMatching(SegmentPath(*it), offsets, playerUuid, limit, result);
+  }
+
+  return result;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// Status byte used when a record has no old or no new row.
+constexpr uint8_t JournalNoStatus = 0xFF;
+
+
+struct JournalRecord {
+  int64_t     Timestamp{0};
+  std::string Actor{};
+  std::string PlayerUuid{};
+  std::string PlayerName{};
+  uint8_t     OldStatus{JournalNoStatus};
+  uint8_t     NewStatus{JournalNoStatus};
+  int64_t     OldLastTime{0};
+  int64_t     NewLastTime{0};
+};
+
+
+/*
+ * Append-only audit journal of list mutations.
+ *
+ * Records are queued in memory by Append() and written by a background
+ * thread as length-prefixed binary records:
+ *
+ *   u32 payload length | u32 checksum | payload
+ *
+ * into numbered segment files ("00000001.journal"). A segment is sealed once
+ * it grows past maxSegmentSize, and a sorted index of (uuid hash, offset) is
+ * written next to it, which Query() uses to seek directly to a player's
+ * records. Sealed segments are compacted periodically, dropping records older
+ * than the retention window.
+ */
+class AuditJournal {
+  public:
+  struct Options {
+    std::string directory{};
+    uint64_t    maxSegmentSize{4 * 1024 * 1024};
+    uint32_t    maxSegments{16};
+    int64_t     compactInterval{3600};
+    int64_t     retention{90 * 24 * 3600};
+    size_t      maxPending{65536};
+  };
+
+  struct Statistics {
+    uint64_t appended;
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t compactions;
+  };
+
+  explicit AuditJournal(Options options);
+  ~AuditJournal();
+
+  AuditJournal(const AuditJournal&)            = delete;
+  AuditJournal& operator=(const AuditJournal&) = delete;
+
+  public:
+  void Start();
+  void Stop();
+
+  // Never touches the disk; records beyond maxPending are dropped and counted.
+  void Append(JournalRecord record);
+
+  // Newest first.
+  std::vector<JournalRecord>
+  Query(const std::string& playerUuid, size_t limit) const;
+
+  Statistics GetStatistics() const;
+
+  private:
+  struct IndexEntry {
+    uint64_t Hash;
+    uint32_t Offset;
+  };
+
+  void WriterLoop();
+  void WriteBatch(const std::vector<JournalRecord>& batch);
+  void Recover();
+  // With m_segmentMutex held exclusively.
+  void OpenActiveSegment();
+  // Seals the active segment and opens the next one.
+  void SealActiveSegment();
+  void Compact();
+  // Moves the output of a committed compaction over the old segments.
+  void FinishCompaction();
+
+  std::filesystem::path SegmentPath(uint32_t sequence) const;
+  std::filesystem::path IndexPath(uint32_t sequence) const;
+  std::filesystem::path CompactionPath() const;
+
+  static void WriteIndex(
+      const std::filesystem::path& path,
+      std::vector<IndexEntry>      entries
+  );
+  static std::vector<IndexEntry>
+  ScanSegment(const std::filesystem::path& path, uint64_t* validLength);
+
+  static void ReadMatching(
+      const std::filesystem::path&    segment,
+      const std::vector<uint32_t>&    offsets,
+      const std::string&              playerUuid,
+      size_t                          limit,
+      std::vector<JournalRecord>&     result
+  );
+
+  private:
+  Options m_options;
+
+  // Producer side.
+  mutable std::mutex         m_queueMutex;
+  std::condition_variable    m_queueCond;
+  std::vector<JournalRecord> m_pending{};
+  bool                       m_stopping{false};
+  std::thread                m_writer{};
+
+  // Writer side. Sealed segments are guarded by m_segmentMutex so that
+  // compaction never removes a file a query is reading.
+  mutable std::shared_mutex m_segmentMutex;
+  std::vector<uint32_t>     m_sealed{};
+  uint32_t                  m_activeSequence{0};
+  std::ofstream             m_activeFile{};
+  uint64_t                  m_activeSize{0};
+  std::vector<IndexEntry>   m_activeIndex{};
+  int64_t                   m_lastCompaction{0};
+
+  std::atomic<uint64_t> m_appended{0};
+  std::atomic<uint64_t> m_written{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<uint64_t> m_compactions{0};
+};
+
+
+uint64_t Fnv1a64(const void* data, size_t length);
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
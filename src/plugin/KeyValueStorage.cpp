@@ -0,0 +1,389 @@
+#include "plugin/KeyValueStorage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+
+using std::string, std::string_view, std::vector;
+
+using BedrockWhiteList::Utils::PlayerInfo;
+using BedrockWhiteList::Utils::PlayerMeta;
+
+
+constexpr string_view KV_PLAYER_PREFIX = "player.";
+constexpr string_view KV_NAME_PREFIX   = "name.";
+constexpr string_view KV_META_PREFIX   = "meta.";
+
+constexpr size_t KV_HEADER_SIZE = 1 + 8 + 4 + 8;
+
+constexpr size_t KV_HISTORY_LIMIT = 64;
+
+
+inline static string PlayerKey(const string& playerUuid) {
+  return string(KV_PLAYER_PREFIX) + playerUuid;
+}
+
+
+inline static string NameKey(const string& playerName) {
+  return string(KV_NAME_PREFIX) + playerName;
+}
+
+
+inline static string MetaKey(const string& playerUuid) {
+  return string(KV_META_PREFIX) + playerUuid;
+}
+
+
+inline static string EncodePlayer(const PlayerInfo& info, int64_t recordedTime) {
+  string value(KV_HEADER_SIZE, '\0');
+
+  const auto    status   = static_cast<uint8_t>(info.PlayerStatus);
+  const int64_t lastTime = info.LastTime.Time;
+  const int32_t flags    = info.Flags;
+
+  std::memcpy(value.data(), &status, 1);
+  std::memcpy(value.data() + 1, &lastTime, 8);
+  std::memcpy(value.data() + 9, &flags, 4);
+  std::memcpy(value.data() + 13, &recordedTime, 8);
+
+  return value + info.PlayerName;
+}
+
+
+inline static bool
+DecodePlayer(string_view playerUuid, string_view value, PlayerInfo& info) {
+  if (value.size() < KV_HEADER_SIZE) {
+    return false;
+  }
+
+  uint8_t status{0};
+  int64_t lastTime{0};
+  int32_t flags{0};
+  int64_t recordedTime{0};
+
+  std::memcpy(&status, value.data(), 1);
+  std::memcpy(&lastTime, value.data() + 1, 8);
+  std::memcpy(&flags, value.data() + 9, 4);
+  std::memcpy(&recordedTime, value.data() + 13, 8);
+
+  info.PlayerStatus = status == 0 ? BedrockWhiteList::Utils::Whitelist
+                                  : BedrockWhiteList::Utils::Blacklist;
+  info.PlayerUuid   = string(playerUuid);
+  info.PlayerName   = string(value.substr(KV_HEADER_SIZE));
+  info.LastTime     = lastTime;
+  info.Flags        = flags;
+  info.RecordedTime = recordedTime;
+
+  return true;
+}
+
+
+inline static void PutInteger(string& value, int64_t integer) {
+  value.append(reinterpret_cast<const char*>(&integer), 8);
+}
+
+
+inline static void PutString(string& value, const string& text) {
+  const auto length = static_cast<uint32_t>(text.size());
+  value.append(reinterpret_cast<const char*>(&length), 4);
+  value.append(text);
+}
+
+
+inline static bool GetInteger(string_view& value, int64_t& integer) {
+  if (value.size() < 8) {
+    return false;
+  }
+
+  std::memcpy(&integer, value.data(), 8);
+  value.remove_prefix(8);
+  return true;
+}
+
+
+inline static bool GetString(string_view& value, string& text) {
+  uint32_t length{0};
+  if (value.size() < 4) {
+    return false;
+  }
+
+  std::memcpy(&length, value.data(), 4);
+  value.remove_prefix(4);
+  if (value.size() < length) {
+    return false;
+  }
+
+  text = string(value.substr(0, length));
+  value.remove_prefix(length);
+  return true;
+}
+
+
+// History is stored oldest first, LoadMeta() hands it out newest first.
+inline static string EncodeMeta(const PlayerMeta& meta) {
+  string value{};
+
+  PutInteger(value, meta.UpdatedTime);
+  PutString(value, meta.Reason);
+  PutString(value, meta.Issuer);
+  PutString(value, meta.Notes);
+  PutInteger(value, static_cast<int64_t>(meta.History.size()));
+
+  for (auto& record : meta.History) {
+    PutInteger(value, record.Time);
+    PutString(value, record.Actor);
+    PutInteger(value, static_cast<int64_t>(record.Status));
+    PutInteger(value, record.LastTime);
+    PutString(value, record.Reason);
+  }
+
+  return value;
+}
+
+
+inline static bool DecodeMeta(string_view value, PlayerMeta& meta) {
+  int64_t count{0};
+
+  if (not GetInteger(value, meta.UpdatedTime) or not GetString(value, meta.Reason)
+      or not GetString(value, meta.Issuer) or not GetString(value, meta.Notes)
+      or not GetInteger(value, count)) {
+    return false;
+  }
+
+  meta.History.clear();
+  for (int64_t i = 0; i < count; i++) {
+    BedrockWhiteList::Utils::BanRecord record{};
+    int64_t                            status{0};
+
+    if (not GetInteger(value, record.Time) or not GetString(value, record.Actor)
+        or not GetInteger(value, status) or not GetInteger(value, record.LastTime)
+        or not GetString(value, record.Reason)) {
+      return false;
+    }
+
+    record.Status = status == 0 ? BedrockWhiteList::Utils::Whitelist
+                                : BedrockWhiteList::Utils::Blacklist;
+    meta.History.push_back(std::move(record));
+  }
+
+  return true;
+}
+
+
+BedrockWhiteList::Utils::KeyValueBackend::KeyValueBackend(
+    const std::filesystem::path& directory
+)
+: m_database(std::make_unique<ll::data::KeyValueDB>(directory)) {}
+
+
+BedrockWhiteList::Utils::StorageKind
+BedrockWhiteList::Utils::KeyValueBackend::Kind() const {
+  return KeyValueStorage;
+}
+
+
+bool BedrockWhiteList::Utils::KeyValueBackend::FindByUuid(
+    const string& playerUuid,
+    PlayerInfo&   info
+) {
+  const auto value = m_database->get(PlayerKey(playerUuid));
+  if (not value) {
+    return false;
+  }
+
+  return DecodePlayer(playerUuid, *value, info);
+}
+
+
+bool BedrockWhiteList::Utils::KeyValueBackend::FindByName(
+    const string& playerName,
+    PlayerInfo&   info
+) {
+  const auto playerUuid = m_database->get(NameKey(playerName));
+  if (not playerUuid) {
+    return false;
+  }
+
+  // The name key is written before the player key, so a stale one is
+  // possible after a crash; trust the player row.
+  return FindByUuid(*playerUuid, info) and info.PlayerName == playerName;
+}
+
+
+vector<PlayerInfo>
+BedrockWhiteList::Utils::KeyValueBackend::ListByStatus(PlayerStatus status) {
+  vector<PlayerInfo> infoList{};
+
+  ForEach(
+      [&](const PlayerInfo& info) {
+        if (info.PlayerStatus == status) {
+          infoList.push_back(info);
+        }
+        return true;
+      },
+      true
+  );
+
+  return infoList;
+}
+
+
+void BedrockWhiteList::Utils::KeyValueBackend::ForEach(
+    const Visitor& visitor,
+    bool           withAutoRecorded
+) {
+  PlayerInfo info{};
+
+  m_database->iter([&](string_view key, string_view value) {
+    if (not key.starts_with(KV_PLAYER_PREFIX)) {
+      return true;
+    }
+
+    if (not DecodePlayer(key.substr(KV_PLAYER_PREFIX.size()), value, info)) {
+      return true;
+    }
+
+    if (not withAutoRecorded and info.PlayerStatus == Blacklist
+        and info.Flags == AutoRecorded) {
+      return true;
+    }
+
+    return visitor(info);
+  });
+}
+
+
+void BedrockWhiteList::Utils::KeyValueBackend::WriteBatch(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos
+) {
+  std::lock_guard lock(m_writeMutex);
+  PutRows(batch, oldInfos);
+}
+
+
+void BedrockWhiteList::Utils::KeyValueBackend::PutRows(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos
+) {
+  const auto now = static_cast<int64_t>(std::time(nullptr));
+
+  for (auto& playerInfo : batch) {
+    PlayerInfo oldInfo{};
+    const auto found = FindByUuid(playerInfo.PlayerUuid, oldInfo);
+
+    if (oldInfos != nullptr) {
+      oldInfos->push_back(found ? oldInfo : PlayerInfo{});
+    }
+
+    // Kept like the blacklist upsert keeps player_recorded_time.
+    auto recordedTime = playerInfo.RecordedTime != 0 ? playerInfo.RecordedTime : now;
+    if (found and oldInfo.PlayerStatus == Blacklist
+        and playerInfo.PlayerStatus == Blacklist and playerInfo.RecordedTime == 0) {
+      recordedTime = oldInfo.RecordedTime;
+    }
+
+    if (found and oldInfo.PlayerName != playerInfo.PlayerName) {
+      m_database->del(NameKey(oldInfo.PlayerName));
+    }
+
+    m_database->set(NameKey(playerInfo.PlayerName), playerInfo.PlayerUuid);
+    m_database->set(
+        PlayerKey(playerInfo.PlayerUuid),
+        EncodePlayer(playerInfo, recordedTime)
+    );
+  }
+}
+
+
+// The key-value store has no transactions: the rows are written first, then
+// the history.
+void BedrockWhiteList::Utils::KeyValueBackend::WriteBatchWithHistory(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos,
+    const vector<PlayerInfo>& history,
+    const string&             actor,
+    const string&             reason,
+    int64_t                   time,
+    const Committed&          committed
+) {
+  std::lock_guard    lock(m_writeMutex);
+  vector<PlayerInfo> olds{};
+  PutRows(batch, oldInfos != nullptr ? &olds : nullptr);
+
+  for (auto& playerInfo : history) {
+    PlayerMeta meta{};
+    if (const auto value = m_database->get(MetaKey(playerInfo.PlayerUuid))) {
+      DecodeMeta(*value, meta);
+    }
+
+    meta.Reason      = reason;
+    meta.Issuer      = actor;
+    meta.UpdatedTime = time;
+    meta.History.push_back(
+        {time, actor, playerInfo.PlayerStatus, playerInfo.LastTime.Time, reason}
+    );
+
+    if (meta.History.size() > KV_HISTORY_LIMIT) {
+      meta.History.erase(
+          meta.History.begin(),
+          meta.History.end() - KV_HISTORY_LIMIT
+      );
+    }
+
+    StoreMeta(playerInfo.PlayerUuid, meta);
+  }
+
+  if (committed) {
+    committed(batch, olds);
+  }
+
+  if (oldInfos != nullptr) {
+    oldInfos->insert(oldInfos->end(), olds.begin(), olds.end());
+  }
+}
+
+
+void BedrockWhiteList::Utils::KeyValueBackend::WriteNotes(
+    const string& playerUuid,
+    const string& notes
+) {
+  std::lock_guard lock(m_writeMutex);
+  PlayerMeta      meta{};
+  if (const auto value = m_database->get(MetaKey(playerUuid))) {
+    DecodeMeta(*value, meta);
+  }
+
+  meta.Notes       = notes;
+  meta.UpdatedTime = static_cast<int64_t>(std::time(nullptr));
+
+  StoreMeta(playerUuid, meta);
+}
+
+
+bool BedrockWhiteList::Utils::KeyValueBackend::LoadMeta(
+    const string& playerUuid,
+    PlayerMeta&   meta,
+    size_t        historyLimit
+) {
+  const auto value = m_database->get(MetaKey(playerUuid));
+  if (not value or not DecodeMeta(*value, meta)) {
+    return false;
+  }
+
+  std::reverse(meta.History.begin(), meta.History.end());
+  if (meta.History.size() > historyLimit) {
+    meta.History.resize(historyLimit);
+  }
+
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::KeyValueBackend::StoreMeta(
+    const string&     playerUuid,
+    const PlayerMeta& meta
+) {
+  m_database->set(MetaKey(playerUuid), EncodeMeta(meta));
+}
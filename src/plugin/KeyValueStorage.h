@@ -0,0 +1,89 @@
+#pragma once
+
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ll/api/data/KeyValueDB.h>
+
+#include "plugin/Storage.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * The lists in a LevelDB directory through ll::data::KeyValueDB.
+ *
+ *   "player.<uuid>" -> u8 status | i64 last time | i32 flags |
+ *                      i64 recorded time | name
+ *   "name.<name>"   -> uuid
+ *   "meta.<uuid>"   -> i64 updated time | reason | issuer | notes |
+ *                      i32 records | records, strings length-prefixed
+ *
+ * A player is a single key, so moving it between lists is atomic per
+ * player. KeyValueDB has no write batches, a batch is not atomic as a whole.
+ * The metadata lives under its own key so a lookup never reads it; its
+ * history keeps the newest 64 records.
+ *
+ * Lookups go straight to the store; writes read before they write, and
+ * take turns.
+ */
+class KeyValueBackend : public StorageBackend {
+  public:
+  explicit KeyValueBackend(const std::filesystem::path& directory);
+
+  public:
+  StorageKind Kind() const override;
+
+  bool FindByUuid(const std::string& playerUuid, PlayerInfo& info) override;
+  bool FindByName(const std::string& playerName, PlayerInfo& info) override;
+
+  std::vector<PlayerInfo> ListByStatus(PlayerStatus status) override;
+
+  void ForEach(const Visitor& visitor, bool withAutoRecorded) override;
+
+  void WriteBatch(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos
+  ) override;
+
+  void WriteBatchWithHistory(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos,
+      const std::vector<PlayerInfo>& history,
+      const std::string&             actor,
+      const std::string&             reason,
+      int64_t                        time,
+      const Committed&               committed
+  ) override;
+
+  void WriteNotes(const std::string& playerUuid, const std::string& notes) override;
+
+  bool LoadMeta(const std::string& playerUuid, PlayerMeta& meta, size_t historyLimit)
+      override;
+
+  private:
+  // WriteBatch, with m_writeMutex held.
+  void PutRows(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos
+  );
+  void StoreMeta(const std::string& playerUuid, const PlayerMeta& meta);
+
+  private:
+  std::unique_ptr<ll::data::KeyValueDB> m_database;
+  std::mutex                            m_writeMutex;
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
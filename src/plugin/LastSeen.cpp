@@ -0,0 +1,172 @@
+#include "plugin/LastSeen.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "plugin/Shards.h"
+
+using namespace std::chrono;
+
+
+BedrockWhiteList::Utils::LastSeenTracker::LastSeenTracker(
+    std::string databasePath,
+    int64_t     interval
+)
+: m_databasePath(std::move(databasePath)),
+  m_interval(interval) {}
+
+
+BedrockWhiteList::Utils::LastSeenTracker::~LastSeenTracker() { Stop(); }
+
+
+void BedrockWhiteList::Utils::LastSeenTracker::SetShards(size_t shards) {
+  m_shards = std::max<size_t>(shards, 1);
+}
+
+
+void BedrockWhiteList::Utils::LastSeenTracker::Start() {
+  if (m_task != nullptr) {
+    return;
+  }
+
+  m_task = std::make_unique<PeriodicTask>(seconds(m_interval), [this](auto&) {
+    Flush();
+  });
+  m_task->SetErrorHandler(m_onError);
+  m_task->Start();
+}
+
+
+void BedrockWhiteList::Utils::LastSeenTracker::Stop() {
+  if (m_task == nullptr) {
+    return;
+  }
+
+  m_task->Stop();
+  m_task.reset();
+
+  try {
+    Flush();
+  } catch (std::exception& e) {
+    if (m_onError) {
+      m_onError(e);
+    }
+  }
+
+  m_sessions.clear();
+}
+
+
+void BedrockWhiteList::Utils::LastSeenTracker::Touch(
+    const std::string& playerUuid,
+    int64_t            time
+) {
+  std::lock_guard lock(m_dirtyMutex);
+
+  auto& seen = m_dirty[playerUuid];
+  seen       = std::max(seen, time);
+}
+
+
+void BedrockWhiteList::Utils::LastSeenTracker::Flush() {
+  std::lock_guard flushLock(m_flushMutex);
+
+  std::unordered_map<std::string, int64_t> batch{};
+  {
+    std::lock_guard lock(m_dirtyMutex);
+    batch.swap(m_dirty);
+  }
+
+  if (batch.empty()) {
+    return;
+  }
+
+
+  const auto startTime = steady_clock::now();
+
+  try {
+
+    if (m_sessions.empty()) {
+      std::vector<std::unique_ptr<SQLite::Database>> sessions{};
+      for (auto& path : RowDatabasePaths(m_databasePath, m_shards)) {
+        sessions.push_back(
+            std::make_unique<SQLite::Database>(path, SQLite::OPEN_READWRITE, 1000)
+        );
+      }
+      m_sessions.swap(sessions);
+    }
+
+    // A transaction per shard; one that fails puts the whole batch back,
+    // writing a time again changes nothing.
+    std::vector<std::vector<const std::pair<const std::string, int64_t>*>> parts(
+        m_sessions.size()
+    );
+    for (auto& entry : batch) {
+      parts[ShardOf(entry.first, m_sessions.size())].push_back(&entry);
+    }
+
+    for (size_t shard = 0; shard < parts.size(); shard++) {
+      if (parts[shard].empty()) {
+        continue;
+      }
+
+      auto&               session = *m_sessions[shard];
+      SQLite::Transaction transaction(session);
+      SQLite::Statement   update(
+          session,
+          "UPDATE whitelist SET player_last_seen = max(player_last_seen, ?1) "
+          "WHERE player_uuid = ?2"
+      );
+
+      for (auto entry : parts[shard]) {
+        update.bind(1, static_cast<long long>(entry->second));
+        update.bind(2, entry->first);
+        update.exec();
+        update.reset();
+      }
+
+      transaction.commit();
+    }
+
+  } catch (...) {
+    // Put the batch back for the next flush, newer touches win.
+    std::lock_guard lock(m_dirtyMutex);
+
+    for (auto& [playerUuid, time] : batch) {
+      auto& seen = m_dirty[playerUuid];
+      seen       = std::max(seen, time);
+    }
+
+    throw;
+  }
+
+
+  const auto elapsed = duration_cast<microseconds>(steady_clock::now() - startTime).count();
+
+  m_flushes++;
+  m_rowsWritten     += batch.size();
+  m_lastFlushMicros  = elapsed;
+
+  auto maxFlush = m_maxFlushMicros.load();
+  while (elapsed > maxFlush
+         and not m_maxFlushMicros.compare_exchange_weak(maxFlush, elapsed)) {}
+}
+
+
+void BedrockWhiteList::Utils::LastSeenTracker::SetErrorCallback(
+    ErrorCallback callback
+) {
+  m_onError = std::move(callback);
+}
+
+
+BedrockWhiteList::Utils::LastSeenTracker::Statistics
+BedrockWhiteList::Utils::LastSeenTracker::GetStatistics() const {
+  uint64_t pending{0};
+  {
+    std::lock_guard lock(m_dirtyMutex);
+    pending = m_dirty.size();
+  }
+
+  return {m_flushes, m_rowsWritten, pending, m_lastFlushMicros, m_maxFlushMicros};
+}
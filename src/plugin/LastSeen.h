@@ -0,0 +1,83 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * Last join time of whitelisted players.
+ *
+ * Touch() only updates an in-memory dirty map, repeated joins of a player
+ * between two flushes collapse into one entry. A background task writes the
+ * map in one transaction every interval, and Stop() writes what is left.
+ * With the rows sharded, a flush is one transaction per shard file.
+ */
+class LastSeenTracker {
+  public:
+  typedef PeriodicTask::ErrorHandler ErrorCallback;
+
+  struct Statistics {
+    uint64_t Flushes;
+    uint64_t RowsWritten;
+    uint64_t Pending;
+    int64_t  LastFlushMicros;
+    int64_t  MaxFlushMicros;
+  };
+
+  LastSeenTracker(std::string databasePath, int64_t interval);
+  ~LastSeenTracker();
+
+  public:
+  // The shard count of the player rows, before Start().
+  void SetShards(size_t shards);
+
+  void Start();
+  void Stop();
+
+  void Touch(const std::string& playerUuid, int64_t time);
+  void Flush();
+
+  void       SetErrorCallback(ErrorCallback callback);
+  Statistics GetStatistics() const;
+
+  private:
+  std::string                                    m_databasePath;
+  int64_t                                        m_interval;
+  size_t                                         m_shards{1};
+  std::vector<std::unique_ptr<SQLite::Database>> m_sessions{}; // per shard
+  std::unique_ptr<PeriodicTask>                  m_task{};
+  ErrorCallback                                  m_onError{};
+
+  mutable std::mutex                       m_dirtyMutex;
+  std::unordered_map<std::string, int64_t> m_dirty{};
+
+  // Serialises the interval flush with the one Stop() does.
+  std::mutex m_flushMutex;
+
+  std::atomic<uint64_t> m_flushes{0};
+  std::atomic<uint64_t> m_rowsWritten{0};
+  std::atomic<int64_t>  m_lastFlushMicros{0};
+  std::atomic<int64_t>  m_maxFlushMicros{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,192 @@
+#include "plugin/Messages.h"
+
+#include <cassert>
+#include <mutex>
+
+using std::string, std::string_view, std::vector;
+
+using BedrockWhiteList::Utils::MessageCatalog;
+using BedrockWhiteList::Utils::MessageCount;
+using BedrockWhiteList::Utils::MessageId;
+using BedrockWhiteList::Utils::MessageTemplate;
+
+
+// In MessageId order, the same text as the lang files.
+constexpr string_view MESSAGE_KEYS[MessageCount] = {
+    "The server is busy, please reconnect later. ",
+    "You are disconnected because you are not whitelisted. ",
+    "You are on the blacklist forever. ",
+    "You are on the blacklist until {0}. ",
+    "You may not join the server at this time. ",
+    "The server is still starting, please reconnect later. ",
+    "You are not on a list that may join now. ",
+    "{0} joined before the warm-up finished and is let in. ",
+    "{0} joined before the warm-up finished and is disconnected. ",
+    "No database answer for {0} within {1} ms, decided by the {2}. ",
+    "last known verdict",
+    "fallback policy",
+    "{0} is disconnected by the fallback policy. ",
+    "{0} is a newcomer without whitelist, and is disconnected. ",
+    "{0} is on the blacklist and is auto disconnected. ",
+    "{0} is not let in by lists.admission and is disconnected. ",
+    "{0} is turned away by rule \"{1}\" and is disconnected. ",
+    "{0} is let in by rule \"{1}\". ",
+    "{0} is no longer let in and is disconnected. ",
+};
+
+
+inline static string_view Language(string_view locale) {
+  return locale.substr(0, locale.find('_'));
+}
+
+
+// - - - - - - Template - - - - - -
+
+
+BedrockWhiteList::Utils::MessageTemplate::MessageTemplate(string text)
+: m_text(std::move(text)) {
+  size_t start{0};
+
+  const auto literal = [this, &start](size_t end) {
+    if (start < end) {
+      m_parts.push_back(
+          {static_cast<uint32_t>(start), static_cast<uint32_t>(end - start), -1}
+      );
+    }
+  };
+
+  for (size_t i = 0; i < m_text.size(); i++) {
+    const auto c    = m_text[i];
+    const auto next = i + 1 < m_text.size() ? m_text[i + 1] : '\0';
+
+    // One brace of a doubled pair is kept.
+    if ((c == '{' or c == '}') and next == c) {
+      literal(i + 1);
+      start = i + 2;
+      i++;
+      continue;
+    }
+
+    if (c == '{' and '0' <= next and next <= '9' and i + 2 < m_text.size()
+        and m_text[i + 2] == '}') {
+      literal(i);
+      m_parts.push_back({0, 0, next - '0'});
+      start = i + 3;
+      i    += 2;
+    }
+  }
+
+  literal(m_text.size());
+}
+
+
+string BedrockWhiteList::Utils::MessageTemplate::Render(
+    std::initializer_list<string_view> args
+) const {
+  const auto argument = [&args](int32_t index) {
+    return static_cast<size_t>(index) < args.size() ? args.begin()[index]
+                                                    : string_view{};
+  };
+
+  size_t size{0};
+  for (auto& part : m_parts) {
+    size += part.Argument < 0 ? part.Length : argument(part.Argument).size();
+  }
+
+  string rendered{};
+  rendered.reserve(size);
+
+  for (auto& part : m_parts) {
+    if (part.Argument < 0) {
+      rendered.append(m_text, part.Offset, part.Length);
+    } else {
+      rendered.append(argument(part.Argument));
+    }
+  }
+
+  return rendered;
+}
+
+
+// - - - - - - Catalog - - - - - -
+
+
+BedrockWhiteList::Utils::MessageCatalog::MessageCatalog() {
+  Compile({}, [](string_view key, string_view) { return string(key); });
+}
+
+
+string_view BedrockWhiteList::Utils::MessageCatalog::Key(MessageId id) {
+  assert(id < MessageCount);
+  return MESSAGE_KEYS[id];
+}
+
+
+void BedrockWhiteList::Utils::MessageCatalog::Compile(
+    const vector<string>& locales,
+    const Translate&      translate
+) {
+  vector<Locale> compiled{};
+  compiled.reserve(locales.size() + 1);
+
+  const auto add = [&compiled, &translate](const string& name) {
+    auto& locale = compiled.emplace_back();
+    locale.Name  = name;
+
+    for (int id = 0; id < MessageCount; id++) {
+      locale.Messages[id] = MessageTemplate(translate(MESSAGE_KEYS[id], name));
+    }
+  };
+
+  add(string());
+  for (auto& name : locales) {
+    if (not name.empty()) {
+      add(name);
+    }
+  }
+
+  std::unique_lock lock(m_mutex);
+  m_locales.swap(compiled);
+}
+
+
+// The caller holds m_mutex.
+const MessageCatalog::Locale&
+BedrockWhiteList::Utils::MessageCatalog::Find(string_view locale) const {
+  if (locale.empty()) {
+    return m_locales.front();
+  }
+
+  for (auto& compiled : m_locales) {
+    if (compiled.Name == locale) {
+      return compiled;
+    }
+  }
+
+  const auto language = Language(locale);
+  for (auto& compiled : m_locales) {
+    if (not compiled.Name.empty() and Language(compiled.Name) == language) {
+      return compiled;
+    }
+  }
+
+  return m_locales.front();
+}
+
+
+string BedrockWhiteList::Utils::MessageCatalog::Render(
+    MessageId                          id,
+    string_view                        locale,
+    std::initializer_list<string_view> args
+) const {
+  assert(id < MessageCount);
+
+  std::shared_lock lock(m_mutex);
+  return Find(locale).Messages[id].Render(args);
+}
+
+
+size_t BedrockWhiteList::Utils::MessageCatalog::Size() const {
+  std::shared_lock lock(m_mutex);
+  return m_locales.size();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// The messages of the connect path, by the English text that keys them in
+// assets/lang. Kicks go to the player in their locale, the rest to the log.
+typedef enum __tagMessageId {
+  KickServerBusy,
+  KickNotWhitelisted,
+  KickBlacklistedForever,
+  KickBlacklistedUntil,
+  KickRuleDenied,
+  KickStarting,
+  KickNotOnList,
+  LogWarmupAdmitted,
+  LogWarmupRejected,
+  LogNoDatabaseAnswer,
+  LogLastVerdict,
+  LogFallbackPolicy,
+  LogPolicyRejected,
+  LogNewcomerRejected,
+  LogBlacklistRejected,
+  LogListRejected,
+  LogRuleRejected,
+  LogRuleAdmitted,
+  LogNoLongerLetIn,
+  MessageCount
+} MessageId;
+
+
+/*
+ * A message with its {0} .. {9} placeholders split out once: rendering only
+ * appends the literal pieces and the arguments to a string reserved to the
+ * final size. {{ and }} stand for braces, anything else in braces is kept
+ * as it is.
+ */
+class MessageTemplate {
+  public:
+  MessageTemplate() = default;
+  explicit MessageTemplate(std::string text);
+
+  // A placeholder without an argument renders empty.
+  std::string Render(std::initializer_list<std::string_view> args) const;
+
+  private:
+  struct Part {
+    uint32_t Offset;
+    uint32_t Length;
+    int32_t  Argument; // -1 for a literal piece of m_text
+  };
+
+  std::string       m_text{};
+  std::vector<Part> m_parts{};
+};
+
+
+/*
+ * Every MessageId compiled into a MessageTemplate for each locale there is a
+ * translation for when the plugin loads its lang files, so a kick costs a
+ * locale probe and one render instead of a translation lookup and a format.
+ * Compile() may run again at any time, it swaps all templates at once.
+ *
+ * A player's locale is matched by its name, en_US, then by its language,
+ * en; players of other locales and the log get the server's locale, which
+ * is compiled under the empty name. Before the first Compile() the English
+ * keys are used.
+ */
+class MessageCatalog {
+  public:
+  typedef std::function<std::string(std::string_view key, std::string_view locale)>
+      Translate;
+
+  MessageCatalog();
+
+  public:
+  static std::string_view Key(MessageId id);
+
+  // Replaces every template at once; the server's locale needs not be among
+  // locales.
+  void Compile(const std::vector<std::string>& locales, const Translate& translate);
+
+  std::string Render(
+      MessageId                               id,
+      std::string_view                        locale,
+      std::initializer_list<std::string_view> args = {}
+  ) const;
+
+  size_t Size() const;
+
+  private:
+  struct Locale {
+    std::string                                 Name;
+    std::array<MessageTemplate, MessageCount> Messages;
+  };
+
+  const Locale& Find(std::string_view locale) const;
+
+  private:
+  mutable std::shared_mutex m_mutex;
+  std::vector<Locale>       m_locales{}; // the server's first
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
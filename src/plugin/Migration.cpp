@@ -0,0 +1,624 @@
+#include "plugin/Migration.h"
+
+#include <ctime>
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <sqlite3.h>
+#include <thread>
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::Migration;
+
+
+constexpr auto MIN_RETRY_WAIT = std::chrono::milliseconds(10);
+constexpr auto MAX_RETRY_WAIT = std::chrono::milliseconds(2000);
+
+
+inline static vector<string> SplitColumns(const string& columns) {
+  vector<string> result{};
+  string         column{};
+
+  for (auto c : columns + ",") {
+    if (c == ',') {
+      result.push_back(column);
+      column.clear();
+    } else if (c != ' ') {
+      column.push_back(c);
+    }
+  }
+
+  return result;
+}
+
+
+inline static string ShadowTable(const Migration& migration, const string& table) {
+  return fmt::format("{0}__v{1}", table, migration.Version);
+}
+
+
+// - - - - - - - - - - - - - - - - Migrator - - - - - - - - - - - - - - - -
+
+
+BedrockWhiteList::Utils::Migrator::Migrator(
+    SQLite::Database& database,
+    vector<Migration> migrations,
+    int               batchSize
+)
+: m_database(database),
+  m_migrations(std::move(migrations)),
+  m_batchSize(batchSize) {
+
+  m_database.exec("CREATE TABLE IF NOT EXISTS schema_migration("
+                  "version INTEGER NOT NULL,"
+                  "table_name TEXT NOT NULL,"
+                  "cursor INTEGER NOT NULL,"
+                  "PRIMARY KEY(version, table_name));");
+}
+
+
+int BedrockWhiteList::Utils::Migrator::CurrentVersion() const {
+  SQLite::Statement query(m_database, "PRAGMA user_version");
+  query.executeStep();
+  return query.getColumn(0).getInt();
+}
+
+
+int BedrockWhiteList::Utils::Migrator::LatestVersion() const {
+  return m_migrations.empty() ? 0 : m_migrations.back().Version;
+}
+
+
+void BedrockWhiteList::Utils::Migrator::SetBatchPause(
+    std::chrono::milliseconds pause
+) {
+  m_batchPause = pause;
+}
+
+
+void BedrockWhiteList::Utils::Migrator::SetLogCallback(LogCallback callback) {
+  m_log = std::move(callback);
+}
+
+
+bool BedrockWhiteList::Utils::Migrator::Run(
+    int                      untilVersion,
+    const std::atomic<bool>* stop
+) {
+  const auto current = CurrentVersion();
+
+  for (auto& migration : m_migrations) {
+    if (migration.Version <= current) {
+      continue;
+    }
+
+    if (untilVersion != -1 and migration.Version > untilVersion) {
+      break;
+    }
+
+    if (m_log) {
+      m_log(fmt::format(
+          "Applying schema migration {0} ({1}). ",
+          migration.Version,
+          migration.Name
+      ));
+    }
+
+    for (auto& rewrite : migration.Rewrites) {
+      if (not Rewrite(migration, rewrite, stop)) {
+        return false;
+      }
+    }
+
+    if (not Retry(stop, [&] { Finish(migration, current); })) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// The plugin keeps writing while an online migration runs, and a write
+// transaction that finds the lock taken for longer than the busy timeout
+// fails. The step is tried again, waiting twice as long each time, until
+// it goes through or the stop flag is set.
+bool BedrockWhiteList::Utils::Migrator::Retry(
+    const std::atomic<bool>*     stop,
+    const std::function<void()>& step
+) {
+  auto wait = std::max(m_batchPause, MIN_RETRY_WAIT);
+
+  for (int attempt = 1;; attempt++) {
+    try {
+      step();
+      return true;
+    } catch (SQLite::Exception& e) {
+      const auto code = e.getErrorCode() & 0xFF;
+      if (code != SQLITE_BUSY and code != SQLITE_LOCKED) {
+        throw;
+      }
+
+      // Once per step, a busy server would otherwise fill the log.
+      if (m_log and attempt == 1) {
+        m_log("Schema migration waits for the database lock. ");
+      }
+    }
+
+    for (auto waited = std::chrono::milliseconds(0); waited < wait;
+         waited += MIN_RETRY_WAIT) {
+      if (stop != nullptr and stop->load()) {
+        return false;
+      }
+      std::this_thread::sleep_for(MIN_RETRY_WAIT);
+    }
+
+    wait = std::min(wait * 2, MAX_RETRY_WAIT);
+  }
+}
+
+
+bool BedrockWhiteList::Utils::Migrator::Rewrite(
+    const Migration&         migration,
+    const TableRewrite&      rewrite,
+    const std::atomic<bool>* stop
+) {
+  const auto shadow = ShadowTable(migration, rewrite.Table);
+  long long  cursor{0};
+  bool       started{false};
+
+  {
+    SQLite::Statement state(
+        m_database,
+        "SELECT cursor FROM schema_migration WHERE version = ? AND table_name = ?"
+    );
+    state.bind(1, migration.Version);
+    state.bind(2, rewrite.Table);
+
+    if (state.executeStep()) {
+      cursor  = state.getColumn(0).getInt64();
+      started = true;
+    }
+  }
+
+  // First run: new table and the triggers that keep it in step with writes
+  // made while the copy is running.
+  //
+  // Every write transaction here takes the write lock up front: a deferred
+  // one reads first and then fails at once, past the busy timeout, when a
+  // writer of the plugin committed in between.
+  const auto start = [&] {
+    SQLite::Transaction transaction(
+        m_database,
+        SQLite::TransactionBehavior::IMMEDIATE
+    );
+
+    m_database.exec(fmt::format("DROP TABLE IF EXISTS {0};", shadow));
+    m_database.exec(fmt::format(fmt::runtime(rewrite.CreateSql), shadow));
+
+    const auto newValues =
+        fmt::format("NEW.{0}", fmt::join(SplitColumns(rewrite.Columns), ", NEW."));
+
+    m_database.exec(fmt::format(
+        "CREATE TRIGGER {0}_insert AFTER INSERT ON {1} BEGIN "
+        "INSERT OR REPLACE INTO {0}({2}) VALUES({3}); END;",
+        shadow,
+        rewrite.Table,
+        rewrite.Columns,
+        newValues
+    ));
+    m_database.exec(fmt::format(
+        "CREATE TRIGGER {0}_update AFTER UPDATE ON {1} BEGIN "
+        "DELETE FROM {0} WHERE {4} = OLD.{4}; "
+        "INSERT OR REPLACE INTO {0}({2}) VALUES({3}); END;",
+        shadow,
+        rewrite.Table,
+        rewrite.Columns,
+        newValues,
+        rewrite.KeyColumn
+    ));
+    m_database.exec(fmt::format(
+        "CREATE TRIGGER {0}_delete AFTER DELETE ON {1} BEGIN "
+        "DELETE FROM {0} WHERE {2} = OLD.{2}; END;",
+        shadow,
+        rewrite.Table,
+        rewrite.KeyColumn
+    ));
+
+    SQLite::Statement insert(
+        m_database,
+        "INSERT INTO schema_migration(version, table_name, cursor) "
+        "VALUES(?, ?, 0)"
+    );
+    insert.bind(1, migration.Version);
+    insert.bind(2, rewrite.Table);
+    insert.exec();
+
+    transaction.commit();
+  };
+
+  if (not started and not Retry(stop, start)) {
+    return false;
+  }
+
+  // -1 marks a table already swapped in an unfinished migration.
+  if (cursor == -1) {
+    return true;
+  }
+
+
+  // Rows the triggers already mirrored are newer than the copy, hence the
+  // OR IGNORE.
+  const auto copySql = fmt::format(
+      "INSERT OR IGNORE INTO {0}({2}) SELECT {2} FROM {1} "
+      "WHERE rowid > ? AND rowid <= ?",
+      shadow,
+      rewrite.Table,
+      rewrite.Columns
+  );
+  const auto boundSql = fmt::format(
+      "SELECT max(rowid) FROM (SELECT rowid FROM {0} WHERE rowid > ? "
+      "ORDER BY rowid LIMIT ?)",
+      rewrite.Table
+  );
+
+  unsigned long long copied{0};
+  bool               finished{false};
+
+  // The cursor and the count only move once the batch is committed, so a
+  // retried batch copies the same rows again.
+  const auto copyBatch = [&] {
+    SQLite::Transaction transaction(
+        m_database,
+        SQLite::TransactionBehavior::IMMEDIATE
+    );
+
+    SQLite::Statement bound(m_database, boundSql);
+    bound.bind(1, cursor);
+    bound.bind(2, m_batchSize);
+    bound.executeStep();
+
+    if (bound.getColumn(0).isNull()) {
+      finished = true;
+      return;
+    }
+
+    const auto upper = bound.getColumn(0).getInt64();
+
+    SQLite::Statement copy(m_database, copySql);
+    copy.bind(1, cursor);
+    copy.bind(2, upper);
+    const auto rows = copy.exec();
+
+    SQLite::Statement update(
+        m_database,
+        "UPDATE schema_migration SET cursor = ? "
+        "WHERE version = ? AND table_name = ?"
+    );
+    update.bind(1, upper);
+    update.bind(2, migration.Version);
+    update.bind(3, rewrite.Table);
+    update.exec();
+
+    transaction.commit();
+    cursor  = upper;
+    copied += rows;
+  };
+
+  while (not finished) {
+    if (stop != nullptr and stop->load()) {
+      return false;
+    }
+
+    if (not Retry(stop, copyBatch)) {
+      return false;
+    }
+
+    std::this_thread::sleep_for(m_batchPause);
+  }
+
+
+  // Swap: the only step that takes the write lock for longer than a batch,
+  // and it does not depend on the table size.
+  const auto swap = [&] {
+    SQLite::Transaction transaction(
+        m_database,
+        SQLite::TransactionBehavior::IMMEDIATE
+    );
+
+    m_database.exec(fmt::format(
+        "DROP TRIGGER IF EXISTS {0}_insert;"
+        "DROP TRIGGER IF EXISTS {0}_update;"
+        "DROP TRIGGER IF EXISTS {0}_delete;"
+        "DROP TABLE {1};"
+        "ALTER TABLE {0} RENAME TO {1};",
+        shadow,
+        rewrite.Table
+    ));
+
+    for (auto& index : rewrite.IndexSql) {
+      m_database.exec(fmt::format(fmt::runtime(index), rewrite.Table));
+    }
+
+    SQLite::Statement update(
+        m_database,
+        "UPDATE schema_migration SET cursor = -1 "
+        "WHERE version = ? AND table_name = ?"
+    );
+    update.bind(1, migration.Version);
+    update.bind(2, rewrite.Table);
+    update.exec();
+
+    transaction.commit();
+  };
+
+  if (not Retry(stop, swap)) {
+    return false;
+  }
+
+
+  if (m_log) {
+    m_log(fmt::format("Rewrote table {0}, {1} rows copied. ", rewrite.Table, copied)
+    );
+  }
+
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::Migrator::Finish(
+    const Migration& migration,
+    int              fromVersion
+) {
+  SQLite::Transaction transaction(
+      m_database,
+      SQLite::TransactionBehavior::IMMEDIATE
+  );
+
+  if (migration.Apply) {
+    migration.Apply(m_database, fromVersion);
+  }
+
+  SQLite::Statement clear(
+      m_database,
+      "DELETE FROM schema_migration WHERE version = ?"
+  );
+  clear.bind(1, migration.Version);
+  clear.exec();
+
+  // PRAGMA does not take bound parameters.
+  m_database.exec(fmt::format("PRAGMA user_version = {0};", migration.Version));
+
+  transaction.commit();
+}
+
+
+// - - - - - - - - - - - - - - Player schema - - - - - - - - - - - - - - -
+
+
+vector<Migration> BedrockWhiteList::Utils::PlayerSchemaMigrations() {
+  vector<Migration> migrations{};
+
+
+  // The layout every release before the migrations shipped with.
+  migrations.push_back({1, "baseline", [](SQLite::Database& database, int) {
+                          for (auto table : {"whitelist", "blacklist"}) {
+                            database.exec(fmt::format(
+                                "CREATE TABLE IF NOT EXISTS {0}("
+                                "player_uuid TINYTEXT NOT NULL UNIQUE,"
+                                "player_name TINYTEXT NOT NULL,"
+                                "player_last_time BIGINT NOT NULL,"
+                                "PRIMARY KEY(player_uuid));",
+                                table
+                            ));
+                          }
+                        }});
+
+
+  // 2 and 3 rewrote the tables and indexed the names before the baseline,
+  // keeping the plugin from starting for as long as the copy took. Both moved
+  // behind it, to 11; the numbers stay taken so that a database which
+  // applied them keeps its version.
+  migrations.push_back(
+      {2, "moved to 11", [](SQLite::Database& database, int) {
+         // What a copy of the old 2 left behind when it was interrupted.
+         for (auto table : {"whitelist", "blacklist"}) {
+           database.exec(fmt::format(
+               "DROP TRIGGER IF EXISTS {0}__v2_insert;"
+               "DROP TRIGGER IF EXISTS {0}__v2_update;"
+               "DROP TRIGGER IF EXISTS {0}__v2_delete;"
+               "DROP TABLE IF EXISTS {0}__v2;",
+               table
+           ));
+         }
+       }}
+  );
+  migrations.push_back({3, "moved to 11"});
+
+
+  // Marks rows recorded by the connect listener so the retention sweeper can
+  // tell them from real bans; every writer sets the flag, a row without one
+  // is a ban. Only the blacklist of a release without migrations is known to
+  // hold nothing else, its `set` wrote nothing. A database that has seen any
+  // migration may hold bans set since, which look just the same; its rows
+  // stay bans. The TTL of the existing rows counts from the upgrade.
+  migrations.push_back(
+      {4,
+       "record newcomer provenance",
+       [](SQLite::Database& database, int fromVersion) {
+         database.exec(
+             "ALTER TABLE blacklist ADD COLUMN "
+             "player_flags INTEGER NOT NULL DEFAULT 0;"
+         );
+         database.exec(fmt::format(
+             "ALTER TABLE blacklist ADD COLUMN "
+             "player_recorded_time INTEGER NOT NULL DEFAULT {0};",
+             static_cast<long long>(std::time(nullptr))
+         ));
+
+         if (fromVersion == 0) {
+           database.exec("UPDATE blacklist SET player_flags = 1;");
+         }
+       }}
+  );
+
+
+  // Last join time, written in batches by the last-seen tracker.
+  migrations.push_back(
+      {5, "track last seen", [](SQLite::Database& database, int) {
+         database.exec(
+             "ALTER TABLE whitelist ADD COLUMN "
+             "player_last_seen INTEGER NOT NULL DEFAULT 0;"
+         );
+       }}
+  );
+
+
+  // Reasons, notes and history of a player, apart from the list rows the
+  // connect listener reads.
+  migrations.push_back(
+      {6, "split ban metadata", [](SQLite::Database& database, int) {
+         database.exec(
+             "CREATE TABLE IF NOT EXISTS player_meta("
+             "player_uuid TEXT PRIMARY KEY NOT NULL, "
+             "meta_reason TEXT NOT NULL DEFAULT '', "
+             "meta_issuer TEXT NOT NULL DEFAULT '', "
+             "meta_notes TEXT NOT NULL DEFAULT '', "
+             "meta_updated_time INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID;"
+         );
+         database.exec(
+             "CREATE TABLE IF NOT EXISTS player_history("
+             "history_id INTEGER PRIMARY KEY, "
+             "player_uuid TEXT NOT NULL, "
+             "history_time INTEGER NOT NULL, "
+             "history_actor TEXT NOT NULL, "
+             "history_status INTEGER NOT NULL, "
+             "history_last_time INTEGER NOT NULL, "
+             "history_reason TEXT NOT NULL DEFAULT '');"
+         );
+         database.exec(
+             "CREATE INDEX IF NOT EXISTS player_history_uuid "
+             "ON player_history(player_uuid, history_id);"
+         );
+       }}
+  );
+
+
+  // Named lists: dense player ids and one row per bitmap container.
+  migrations.push_back({7, "named lists", [](SQLite::Database& database, int) {
+                          database.exec(
+                              "CREATE TABLE IF NOT EXISTS player_ids("
+                              "player_id INTEGER PRIMARY KEY, "
+                              "player_uuid TEXT NOT NULL UNIQUE);"
+                          );
+                          database.exec(
+                              "CREATE TABLE IF NOT EXISTS lists("
+                              "list_id INTEGER PRIMARY KEY, "
+                              "list_name TEXT NOT NULL UNIQUE);"
+                          );
+                          database.exec(
+                              "CREATE TABLE IF NOT EXISTS list_containers("
+                              "list_id INTEGER NOT NULL, "
+                              "container_key INTEGER NOT NULL, "
+                              "container_data BLOB NOT NULL, "
+                              "PRIMARY KEY(list_id, container_key)) WITHOUT ROWID;"
+                          );
+                        }});
+
+
+  // Players by xuid, the rowid itself, and every name they joined with.
+  migrations.push_back(
+      {8, "player identities", [](SQLite::Database& database, int) {
+         database.exec(
+             "CREATE TABLE IF NOT EXISTS player_identities("
+             "player_xuid INTEGER PRIMARY KEY, "
+             "player_uuid TEXT NOT NULL, "
+             "player_name TEXT NOT NULL, "
+             "identity_first_seen INTEGER NOT NULL);"
+         );
+         database.exec(
+             "CREATE INDEX IF NOT EXISTS player_identities_uuid "
+             "ON player_identities(player_uuid);"
+         );
+         database.exec(
+             "CREATE TABLE IF NOT EXISTS player_names("
+             "player_name TEXT NOT NULL COLLATE NOCASE, "
+             "player_xuid INTEGER NOT NULL, "
+             "name_since INTEGER NOT NULL, "
+             "PRIMARY KEY(player_name, player_xuid)) WITHOUT ROWID;"
+         );
+         database.exec(
+             "CREATE INDEX IF NOT EXISTS player_names_xuid "
+             "ON player_names(player_xuid, name_since);"
+         );
+       }}
+  );
+
+
+  // List counters kept up to date by the writers.
+  migrations.push_back(
+      {9, "list counters", [](SQLite::Database& database, int) {
+         database.exec(
+             "CREATE TABLE IF NOT EXISTS player_counters("
+             "counter_name TEXT NOT NULL, "
+             "counter_slot INTEGER NOT NULL, "
+             "counter_value INTEGER NOT NULL, "
+             "PRIMARY KEY(counter_name, counter_slot)) WITHOUT ROWID;"
+         );
+       }}
+  );
+
+
+  // How many files the player rows are sharded over, see Shards.h.
+  migrations.push_back(
+      {10, "storage layout", [](SQLite::Database& database, int) {
+         database.exec(
+             "CREATE TABLE IF NOT EXISTS storage_layout("
+             "layout_key TEXT PRIMARY KEY NOT NULL, "
+             "layout_value INTEGER NOT NULL) WITHOUT ROWID;"
+         );
+       }}
+  );
+
+
+  // - - - - - - Online, after PLAYER_SCHEMA_BASELINE - - - - - -
+
+
+  // UNIQUE next to PRIMARY KEY built a second, identical index on the uuid,
+  // doubling the index work of every write. The new tables get their
+  // secondary indexes before the copy, so they grow with it batch by batch:
+  // the names GetPlayerInfo looks up and the few timed bans the counters
+  // load at startup. The indexes of the old table go with it at the swap.
+  Migration rebuildLists{11, "rebuild list tables"};
+  rebuildLists.Rewrites.push_back(
+      {"whitelist",
+       "CREATE TABLE {0}("
+       "player_uuid TEXT NOT NULL PRIMARY KEY,"
+       "player_name TEXT NOT NULL,"
+       "player_last_time INTEGER NOT NULL,"
+       "player_last_seen INTEGER NOT NULL DEFAULT 0);"
+       "CREATE INDEX whitelist_by_name ON {0}(player_name);",
+       "player_uuid, player_name, player_last_time, player_last_seen",
+       "player_uuid"}
+  );
+  rebuildLists.Rewrites.push_back(
+      {"blacklist",
+       "CREATE TABLE {0}("
+       "player_uuid TEXT NOT NULL PRIMARY KEY,"
+       "player_name TEXT NOT NULL,"
+       "player_last_time INTEGER NOT NULL,"
+       "player_flags INTEGER NOT NULL DEFAULT 0,"
+       "player_recorded_time INTEGER NOT NULL "
+       "DEFAULT (CAST(strftime('%s', 'now') AS INTEGER)));"
+       "CREATE INDEX blacklist_by_name ON {0}(player_name);"
+       "CREATE INDEX blacklist_by_end ON {0}(player_last_time) "
+       "WHERE player_last_time > 0;",
+       "player_uuid, player_name, player_last_time, player_flags, "
+       "player_recorded_time",
+       "player_uuid"}
+  );
+  migrations.push_back(rebuildLists);
+
+
+  return migrations;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * Copies a table into a new layout without blocking readers.
+ *
+ * "{0}" in CreateSql and IndexSql is replaced by the table name to create.
+ * Columns lists the columns copied from the old table, KeyColumn is the
+ * unique column used to mirror updates and deletes made during the copy.
+ */
+struct TableRewrite {
+  std::string              Table;
+  std::string              CreateSql;
+  std::string              Columns;
+  std::string              KeyColumn;
+  std::vector<std::string> IndexSql{};
+};
+
+
+struct Migration {
+  int         Version;
+  std::string Name;
+
+  // Runs in the transaction that bumps user_version, keep it quick.
+  // fromVersion is the version the database had before this run, 0 for a
+  // new one and for one made by a release without migrations.
+  std::function<void(SQLite::Database&, int fromVersion)> Apply{};
+
+  std::vector<TableRewrite> Rewrites{};
+};
+
+
+/*
+ * Applies migrations in order, tracking the schema version with
+ * `PRAGMA user_version`.
+ *
+ * A table rewrite creates the new table plus triggers mirroring every write
+ * on the old one, copies rows in batches of batchSize, one transaction each,
+ * and finally swaps the tables. The copy cursor is stored in the
+ * schema_migration table, so a rewrite interrupted by a crash or shutdown
+ * resumes where it stopped. A step that finds the database locked is
+ * tried again with a growing pause until it goes through or is stopped.
+ */
+class Migrator {
+  public:
+  typedef std::function<void(const std::string&)> LogCallback;
+
+  Migrator(
+      SQLite::Database&      database,
+      std::vector<Migration> migrations,
+      int                    batchSize = 500
+  );
+
+  public:
+  int CurrentVersion() const;
+  int LatestVersion() const;
+
+  void SetBatchPause(std::chrono::milliseconds pause);
+  void SetLogCallback(LogCallback callback);
+
+  // Applies pending migrations up to untilVersion (all of them when -1).
+  // Returns false when stopped by the flag before finishing.
+  bool Run(int untilVersion = -1, const std::atomic<bool>* stop = nullptr);
+
+  private:
+  bool Rewrite(
+      const Migration&         migration,
+      const TableRewrite&      rewrite,
+      const std::atomic<bool>* stop
+  );
+  void Finish(const Migration& migration, int fromVersion);
+  bool Retry(const std::atomic<bool>* stop, const std::function<void()>& step);
+
+  private:
+  SQLite::Database&         m_database;
+  std::vector<Migration>    m_migrations;
+  int                       m_batchSize;
+  std::chrono::milliseconds m_batchPause{5};
+  LogCallback               m_log{};
+};
+
+
+// Schema of whitelist.sqlite3.db, in version order.
+std::vector<Migration> PlayerSchemaMigrations();
+
+// The last version that must be applied before the database can be used,
+// that is the newest set of tables and columns the plugin code reads or
+// writes. Migrations after it only change the physical layout, table
+// rewrites and indexes, and run online; keep them there.
+constexpr int PLAYER_SCHEMA_BASELINE = 10;
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,697 @@
+#include "plugin/NamedLists.h"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <mutex>
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::ListExpression;
+
+
+// - - - - - - Expression - - - - - -
+
+
+bool BedrockWhiteList::Utils::ListExpression::Empty() const {
+  return m_program.empty();
+}
+
+
+bool BedrockWhiteList::Utils::ListExpression::ProbesLists() const {
+  return m_probesLists;
+}
+
+
+bool BedrockWhiteList::Utils::ListExpression::Evaluate(
+    bool     hasId,
+    uint32_t playerId,
+    bool     whitelisted,
+    bool     blacklisted
+) const {
+  bool   stack[MAX_DEPTH];
+  size_t depth{0};
+
+  for (auto& step : m_program) {
+    switch (step.Op) {
+    case Whitelisted:
+      stack[depth++] = whitelisted;
+      break;
+    case Blacklisted:
+      stack[depth++] = blacklisted;
+      break;
+    case Probe:
+      stack[depth++] = hasId and step.List->Contains(playerId);
+      break;
+    case Never:
+      stack[depth++] = false;
+      break;
+    case And:
+      depth--;
+      stack[depth - 1] = stack[depth - 1] and stack[depth];
+      break;
+    case Or:
+      depth--;
+      stack[depth - 1] = stack[depth - 1] or stack[depth];
+      break;
+    case Not:
+      stack[depth - 1] = not stack[depth - 1];
+      break;
+    }
+  }
+
+  return depth == 1 and stack[0];
+}
+
+
+// Recursive descent straight to postfix:
+//   expression := term { or term }
+//   term       := factor { and factor }
+//   factor     := not factor | ( expression ) | name
+namespace {
+
+
+class ExpressionParser {
+  public:
+  typedef std::function<bool(const string&, ListExpression::Step&)> Resolver;
+
+  ExpressionParser(const string& source, Resolver resolve)
+  : m_source(source),
+    m_resolve(std::move(resolve)) {}
+
+  bool Parse(vector<ListExpression::Step>& program, string& error) {
+    Next();
+
+    if (not Expression(program) or not m_error.empty()) {
+      error = m_error.empty() ? "syntax error" : m_error;
+      return false;
+    }
+
+    if (not m_token.empty()) {
+      error = "unexpected \"" + m_token + "\"";
+      return false;
+    }
+
+    return true;
+  }
+
+  private:
+  void Next() {
+    while (m_position < m_source.size()
+           and std::isspace(static_cast<unsigned char>(m_source[m_position]))) {
+      m_position++;
+    }
+
+    m_token.clear();
+    if (m_position >= m_source.size()) {
+      return;
+    }
+
+    const auto c = m_source[m_position];
+    if (c == '(' or c == ')' or c == '!') {
+      m_token = string(1, c);
+      m_position++;
+      return;
+    }
+
+    if ((c == '&' or c == '|') and m_position + 1 < m_source.size()
+        and m_source[m_position + 1] == c) {
+      m_token = c == '&' ? "and" : "or";
+      m_position += 2;
+      return;
+    }
+
+    while (m_position < m_source.size()
+           and NamedListChar(m_source[m_position])) {
+      m_token.push_back(m_source[m_position++]);
+    }
+
+    if (m_token.empty()) {
+      m_error = string("unexpected \"") + c + "\"";
+      m_position = m_source.size();
+    }
+  }
+
+  static bool NamedListChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) or c == '_' or c == '-'
+        or c == '.';
+  }
+
+  bool Expression(vector<ListExpression::Step>& program) {
+    if (not Term(program)) {
+      return false;
+    }
+
+    while (m_token == "or") {
+      Next();
+      if (not Term(program)) {
+        return false;
+      }
+      program.push_back({ListExpression::Or, nullptr});
+    }
+
+    return true;
+  }
+
+  bool Term(vector<ListExpression::Step>& program) {
+    if (not Factor(program)) {
+      return false;
+    }
+
+    while (m_token == "and") {
+      Next();
+      if (not Factor(program)) {
+        return false;
+      }
+      program.push_back({ListExpression::And, nullptr});
+    }
+
+    return true;
+  }
+
+  bool Factor(vector<ListExpression::Step>& program) {
+    if (m_token == "not" or m_token == "!") {
+      Next();
+      if (not Factor(program)) {
+        return false;
+      }
+      program.push_back({ListExpression::Not, nullptr});
+      return true;
+    }
+
+    if (m_token == "(") {
+      Next();
+      if (not Expression(program)) {
+        return false;
+      }
+
+      if (m_token != ")") {
+        m_error = "missing \")\"";
+        return false;
+      }
+
+      Next();
+      return true;
+    }
+
+    if (m_token.empty() or m_token == ")" or m_token == "and" or m_token == "or") {
+      m_error = m_token.empty() ? "unexpected end" : "unexpected \"" + m_token + "\"";
+      return false;
+    }
+
+    ListExpression::Step step{};
+    if (not m_resolve(m_token, step)) {
+      m_error = "unknown list \"" + m_token + "\"";
+      return false;
+    }
+
+    program.push_back(step);
+    Next();
+    return true;
+  }
+
+  private:
+  const string& m_source;
+  Resolver      m_resolve;
+  size_t        m_position{0};
+  string        m_token{};
+  string        m_error{};
+};
+
+
+} // namespace
+
+
+// - - - - - - Lists - - - - - -
+
+
+BedrockWhiteList::Utils::NamedLists::NamedLists(string databasePath)
+: m_databasePath(std::move(databasePath)) {}
+
+
+bool BedrockWhiteList::Utils::NamedLists::IsBuiltin(const string& name) {
+  return name == "whitelist" or name == "blacklist";
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::IsValidName(const string& name) {
+  if (name.empty() or name.size() > 64 or IsBuiltin(name) or name == "and"
+      or name == "or" or name == "not") {
+    return false;
+  }
+
+  return std::all_of(name.begin(), name.end(), [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) or c == '_' or c == '-'
+        or c == '.';
+  });
+}
+
+
+void BedrockWhiteList::Utils::NamedLists::Load() {
+  std::unique_lock lock(m_mutex);
+
+  if (m_session == nullptr) {
+    m_session =
+        std::make_unique<SQLite::Database>(m_databasePath, SQLite::OPEN_READWRITE);
+    m_session->setBusyTimeout(1000);
+  }
+
+  m_lists.clear();
+  m_ids.clear();
+  m_nextId = 1;
+
+
+  SQLite::Statement ids(*m_session, "SELECT player_id, player_uuid FROM player_ids");
+  while (ids.executeStep()) {
+    const auto id = static_cast<uint32_t>(ids.getColumn(0).getInt64());
+
+    m_ids.emplace(ids.getColumn(1).getString(), id);
+    m_nextId = std::max(m_nextId, id + 1);
+  }
+
+  std::unordered_map<int64_t, RoaringBitmap*> byId{};
+
+  SQLite::Statement lists(*m_session, "SELECT list_id, list_name FROM lists");
+  while (lists.executeStep()) {
+    auto& list   = m_lists[lists.getColumn(1).getString()];
+    list.Id      = lists.getColumn(0).getInt64();
+    list.Members = std::make_unique<RoaringBitmap>();
+
+    byId[list.Id] = list.Members.get();
+  }
+
+  SQLite::Statement containers(
+      *m_session,
+      "SELECT list_id, container_key, container_data FROM list_containers"
+  );
+  while (containers.executeStep()) {
+    const auto found = byId.find(containers.getColumn(0).getInt64());
+    if (found == byId.end()) {
+      continue;
+    }
+
+    const auto data = containers.getColumn(2);
+    found->second->LoadContainer(
+        static_cast<uint16_t>(containers.getColumn(1).getInt()),
+        {static_cast<const char*>(data.getBlob()), static_cast<size_t>(data.getBytes())}
+    );
+  }
+
+
+  // Names may resolve differently now.
+  Recompile();
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Create(const string& name) {
+  if (not IsValidName(name)) {
+    return false;
+  }
+
+  std::unique_lock lock(m_mutex);
+  if (m_lists.contains(name)) {
+    return false;
+  }
+
+  SQLite::Statement insert(*m_session, "INSERT INTO lists(list_name) VALUES(?)");
+  insert.bind(1, name);
+  insert.exec();
+
+  auto& list   = m_lists[name];
+  list.Id      = m_session->getLastInsertRowid();
+  list.Members = std::make_unique<RoaringBitmap>();
+
+  Recompile();
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Drop(const string& name) {
+  std::unique_lock lock(m_mutex);
+
+  const auto found = m_lists.find(name);
+  if (found == m_lists.end()) {
+    return false;
+  }
+
+  SQLite::Transaction transaction(*m_session);
+  for (auto table : {"list_containers", "lists"}) {
+    SQLite::Statement remove(
+        *m_session,
+        string("DELETE FROM ") + table + " WHERE list_id = ?"
+    );
+    remove.bind(1, found->second.Id);
+    remove.exec();
+  }
+  transaction.commit();
+
+
+  // The compiled expression points into the bitmap, move it off first.
+  auto members = std::move(found->second.Members);
+  m_lists.erase(found);
+
+  Recompile();
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Exists(const string& name) const {
+  std::shared_lock lock(m_mutex);
+  return m_lists.contains(name);
+}
+
+
+uint32_t BedrockWhiteList::Utils::NamedLists::AssignId(
+    const string&      playerUuid,
+    SQLite::Statement& insert
+) {
+  const auto found = m_ids.find(playerUuid);
+  if (found != m_ids.end()) {
+    return found->second;
+  }
+
+  const auto id = m_nextId++;
+
+  insert.bind(1, static_cast<long long>(id));
+  insert.bind(2, playerUuid);
+  insert.exec();
+  insert.reset();
+
+  m_ids.emplace(playerUuid, id);
+  return id;
+}
+
+
+// Only the containers the change touched are written.
+void BedrockWhiteList::Utils::NamedLists::Persist(const List& list) {
+  SQLite::Statement save(
+      *m_session,
+      "INSERT OR REPLACE INTO list_containers(list_id, container_key, "
+      "container_data) VALUES(?1, ?2, ?3)"
+  );
+  SQLite::Statement remove(
+      *m_session,
+      "DELETE FROM list_containers WHERE list_id = ?1 AND container_key = ?2"
+  );
+
+  for (auto key : list.Members->TakeDirty()) {
+    const auto data = list.Members->SaveContainer(key);
+    auto&      statement = data.empty() ? remove : save;
+
+    statement.bind(1, list.Id);
+    statement.bind(2, static_cast<int>(key));
+    if (not data.empty()) {
+      statement.bind(3, data.data(), static_cast<int>(data.size()));
+    }
+    statement.exec();
+    statement.reset();
+  }
+}
+
+
+size_t BedrockWhiteList::Utils::NamedLists::Add(
+    const string&         name,
+    const vector<string>& playerUuids
+) {
+  std::unique_lock lock(m_mutex);
+
+  const auto found = m_lists.find(name);
+  if (found == m_lists.end()) {
+    return 0;
+  }
+
+  auto&            members = *found->second.Members;
+  const auto       nextId  = m_nextId;
+  vector<string>   assigned{};
+  vector<uint32_t> added{};
+
+  try {
+    SQLite::Transaction transaction(*m_session);
+    SQLite::Statement   insertId(
+        *m_session,
+        "INSERT INTO player_ids(player_id, player_uuid) VALUES(?1, ?2)"
+    );
+
+    for (auto& playerUuid : playerUuids) {
+      if (not m_ids.contains(playerUuid)) {
+        assigned.push_back(playerUuid);
+      }
+
+      const auto id = AssignId(playerUuid, insertId);
+      if (members.Add(id)) {
+        added.push_back(id);
+      }
+    }
+
+    Persist(found->second);
+    transaction.commit();
+  } catch (...) {
+    // Nothing was stored, so nothing stays in memory either. The containers
+    // undone are dirty again, and hold what the file has.
+    for (auto id : added) {
+      members.Remove(id);
+    }
+    for (auto& playerUuid : assigned) {
+      m_ids.erase(playerUuid);
+    }
+    m_nextId = nextId;
+    throw;
+  }
+
+  return added.size();
+}
+
+
+size_t BedrockWhiteList::Utils::NamedLists::Remove(
+    const string&         name,
+    const vector<string>& playerUuids
+) {
+  std::unique_lock lock(m_mutex);
+
+  const auto found = m_lists.find(name);
+  if (found == m_lists.end()) {
+    return 0;
+  }
+
+  auto&            members = *found->second.Members;
+  vector<uint32_t> removed{};
+
+  try {
+    for (auto& playerUuid : playerUuids) {
+      const auto id = m_ids.find(playerUuid);
+      if (id != m_ids.end() and members.Remove(id->second)) {
+        removed.push_back(id->second);
+      }
+    }
+
+    SQLite::Transaction transaction(*m_session);
+    Persist(found->second);
+    transaction.commit();
+  } catch (...) {
+    // As in Add().
+    for (auto id : removed) {
+      members.Add(id);
+    }
+    throw;
+  }
+
+  return removed.size();
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Contains(
+    const string& name,
+    const string& playerUuid
+) const {
+  std::shared_lock lock(m_mutex);
+
+  const auto list = m_lists.find(name);
+  const auto id   = m_ids.find(playerUuid);
+
+  return list != m_lists.end() and id != m_ids.end()
+     and list->second.Members->Contains(id->second);
+}
+
+
+vector<std::pair<string, uint64_t>>
+BedrockWhiteList::Utils::NamedLists::Summary() const {
+  std::shared_lock lock(m_mutex);
+
+  vector<std::pair<string, uint64_t>> summary{};
+  for (auto& [name, list] : m_lists) {
+    summary.emplace_back(name, list.Members->Cardinality());
+  }
+
+  return summary;
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Compile(
+    const string&   source,
+    ListExpression& expression,
+    string&         error
+) const {
+  ListExpression compiled{};
+
+  ExpressionParser parser(source, [&](const string& name, ListExpression::Step& step) {
+    if (name == "whitelist") {
+      step = {ListExpression::Whitelisted, nullptr};
+      return true;
+    }
+
+    if (name == "blacklist") {
+      step = {ListExpression::Blacklisted, nullptr};
+      return true;
+    }
+
+    const auto found = m_lists.find(name);
+    if (found == m_lists.end()) {
+      // Not created yet, it simply has no members until then.
+      step = {ListExpression::Never, nullptr};
+      return IsValidName(name);
+    }
+
+    step = {ListExpression::Probe, found->second.Members.get()};
+    compiled.m_probesLists = true;
+    return true;
+  });
+
+  if (not parser.Parse(compiled.m_program, error)) {
+    return false;
+  }
+
+
+  size_t depth{0}, maxDepth{0};
+  for (auto& step : compiled.m_program) {
+    depth    = step.Op == ListExpression::And or step.Op == ListExpression::Or ? depth - 1
+             : step.Op == ListExpression::Not                                  ? depth
+                                                                               : depth + 1;
+    maxDepth = std::max(maxDepth, depth);
+  }
+
+  if (maxDepth > ListExpression::MAX_DEPTH) {
+    error = "expression is nested too deeply";
+    return false;
+  }
+
+  expression = std::move(compiled);
+  return true;
+}
+
+
+// Sources compiled before still do, unknown names only turn into Never.
+void BedrockWhiteList::Utils::NamedLists::Recompile() {
+  string error{};
+  Compile(m_admissionSource, m_admission, error);
+
+  for (size_t i = 0; i < m_expressions.size(); i++) {
+    Compile(m_expressionSources[i], m_expressions[i], error);
+  }
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::SetAdmission(
+    const string& source,
+    string&       error
+) {
+  std::unique_lock lock(m_mutex);
+
+  if (not Compile(source, m_admission, error)) {
+    return false;
+  }
+
+  m_admissionSource = source;
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::CheckAdmission(
+    const string& source,
+    string&       error
+) const {
+  std::shared_lock lock(m_mutex);
+  ListExpression   expression{};
+
+  return Compile(source, expression, error);
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Admits(
+    const string& playerUuid,
+    bool          whitelisted,
+    bool          blacklisted
+) const {
+  std::shared_lock lock(m_mutex);
+
+  if (m_admission.Empty()) {
+    return whitelisted;
+  }
+
+  uint32_t playerId{0};
+  bool     hasId{false};
+
+  if (m_admission.ProbesLists()) {
+    const auto found = m_ids.find(playerUuid);
+    if (found != m_ids.end()) {
+      playerId = found->second;
+      hasId    = true;
+    }
+  }
+
+  return m_admission.Evaluate(hasId, playerId, whitelisted, blacklisted);
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::SetExpressions(
+    const vector<string>& sources,
+    string&               error
+) {
+  std::unique_lock lock(m_mutex);
+
+  vector<ListExpression> expressions(sources.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    if (not Compile(sources[i], expressions[i], error)) {
+      error = "'" + sources[i] + "': " + error;
+      return false;
+    }
+  }
+
+  m_expressionSources = sources;
+  m_expressions       = std::move(expressions);
+  return true;
+}
+
+
+BedrockWhiteList::Utils::NamedLists::Reader::Reader(const NamedLists& lists)
+: m_lists(lists),
+  m_lock(lists.m_mutex) {}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Reader::FindId(
+    const string& playerUuid,
+    uint32_t&     playerId
+) const {
+  const auto found = m_lists.m_ids.find(playerUuid);
+  if (found == m_lists.m_ids.end()) {
+    return false;
+  }
+
+  playerId = found->second;
+  return true;
+}
+
+
+bool BedrockWhiteList::Utils::NamedLists::Reader::Evaluate(
+    int      expression,
+    bool     hasId,
+    uint32_t playerId,
+    bool     whitelisted,
+    bool     blacklisted
+) const {
+  const auto& expressions = m_lists.m_expressions;
+  if (expression < 0 or static_cast<size_t>(expression) >= expressions.size()) {
+    return false;
+  }
+
+  return expressions[expression].Evaluate(hasId, playerId, whitelisted, blacklisted);
+}
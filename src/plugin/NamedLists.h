@@ -0,0 +1,161 @@
+#pragma once
+
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Bitmap.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * An expression over list names, compiled to a postfix program of bitmap
+ * probes. "whitelist" and "blacklist" are the two built-in lists, answered
+ * by the player's verdict instead of a bitmap.
+ *
+ *   (beta or staff or whitelist) and not blacklist
+ *
+ * and / or / not bind in the usual order, && || ! are accepted as well.
+ */
+class ListExpression {
+  public:
+  typedef enum __tagOperation { Whitelisted, Blacklisted, Probe, Never, And, Or, Not } Operation;
+
+  struct Step {
+    Operation            Op;
+    const RoaringBitmap* List;
+  };
+
+  // Deepest operand stack an expression may need.
+  static constexpr size_t MAX_DEPTH = 32;
+
+  public:
+  bool Empty() const;
+  bool ProbesLists() const;
+
+  // No allocation; playerId is ignored when the player has none.
+  bool Evaluate(bool hasId, uint32_t playerId, bool whitelisted, bool blacklisted)
+      const;
+
+  private:
+  friend class NamedLists;
+
+  std::vector<Step> m_program{};
+  bool              m_probesLists{false};
+};
+
+
+/*
+ * Lists of players beside the whitelist and blacklist, such as "staff",
+ * "beta" or "event-2026".
+ *
+ * A player put on any list gets a dense integer id (player_ids), and a
+ * list is a RoaringBitmap of those ids, entirely in memory. A membership
+ * change rewrites only the containers it touched (list_containers), in
+ * one transaction per call.
+ *
+ * Runs on a connection of its own.
+ */
+class NamedLists {
+  public:
+  explicit NamedLists(std::string databasePath);
+
+  public:
+  void Load();
+
+  bool Create(const std::string& name);
+  bool Drop(const std::string& name);
+  bool Exists(const std::string& name) const;
+
+  // Returns how many players changed; false-y when the list does not exist.
+  size_t Add(const std::string& name, const std::vector<std::string>& playerUuids);
+  size_t Remove(const std::string& name, const std::vector<std::string>& playerUuids);
+
+  bool Contains(const std::string& name, const std::string& playerUuid) const;
+
+  std::vector<std::pair<std::string, uint64_t>> Summary() const;
+
+  // The admission expression, recompiled when lists are created or dropped.
+  // Keeps the previous one and fills error when source does not compile.
+  bool SetAdmission(const std::string& source, std::string& error);
+  // Whether SetAdmission() would take source, without setting it.
+  bool CheckAdmission(const std::string& source, std::string& error) const;
+  bool Admits(const std::string& playerUuid, bool whitelisted, bool blacklisted)
+      const;
+
+  // Further expressions evaluated by handle, the rules section's lists for
+  // one. Either all sources compile or none replace the current ones; the
+  // handle of an expression is its index in sources.
+  bool SetExpressions(const std::vector<std::string>& sources, std::string& error);
+
+  // Holds the lists steady for a run of lookups, one lock for all of them.
+  class Reader {
+    public:
+    explicit Reader(const NamedLists& lists);
+
+    bool FindId(const std::string& playerUuid, uint32_t& playerId) const;
+    bool Evaluate(
+        int      expression,
+        bool     hasId,
+        uint32_t playerId,
+        bool     whitelisted,
+        bool     blacklisted
+    ) const;
+
+    private:
+    const NamedLists&                   m_lists;
+    std::shared_lock<std::shared_mutex> m_lock;
+  };
+
+  static bool IsBuiltin(const std::string& name);
+  static bool IsValidName(const std::string& name);
+
+  private:
+  struct List {
+    int64_t                        Id;
+    std::unique_ptr<RoaringBitmap> Members;
+  };
+
+  bool Compile(const std::string& source, ListExpression& expression, std::string& error)
+      const;
+
+  // After lists are created, dropped or loaded.
+  void Recompile();
+
+  uint32_t AssignId(const std::string& playerUuid, SQLite::Statement& insert);
+  void     Persist(const List& list);
+
+  private:
+  std::string                       m_databasePath;
+  std::unique_ptr<SQLite::Database> m_session{};
+
+  mutable std::shared_mutex                 m_mutex;
+  std::map<std::string, List>               m_lists{};
+  std::unordered_map<std::string, uint32_t> m_ids{};
+  uint32_t                                  m_nextId{1};
+
+  std::string    m_admissionSource{"whitelist"};
+  ListExpression m_admission{};
+
+  std::vector<std::string>    m_expressionSources{};
+  std::vector<ListExpression> m_expressions{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,420 @@
+#include "plugin/PlayerDB.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <utility>
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::PlayerInfo;
+using BedrockWhiteList::Utils::Verdict;
+
+
+// Auto-recorded newcomers are left out as by Preload(): they get the same
+// verdict as an unknown player, and a flood of them would only grow the
+// cache. Their row is written only when the player had none, so there is no
+// older verdict of theirs to replace.
+inline static void PutVerdicts(
+    BedrockWhiteList::Utils::VerdictCache& cache,
+    const vector<PlayerInfo>&              batch
+) {
+  vector<std::pair<string, Verdict>> verdicts{};
+  verdicts.reserve(batch.size());
+
+  for (auto& playerInfo : batch) {
+    if (playerInfo.Flags == BedrockWhiteList::Utils::AutoRecorded) {
+      continue;
+    }
+
+    verdicts.push_back(
+        {playerInfo.PlayerUuid,
+         {static_cast<uint8_t>(playerInfo.PlayerStatus), playerInfo.LastTime.Time}}
+    );
+  }
+
+  if (not verdicts.empty()) {
+    cache.PutBatch(verdicts);
+  }
+}
+
+
+BedrockWhiteList::Utils::PlayerDB::PlayerDB() { m_pStorage = nullptr; }
+
+
+BedrockWhiteList::Utils::PlayerDB::PlayerDB(StorageBackend* storage) {
+  assert(storage);
+
+  // The SQLite tables are created by the schema migrations, see Migration.cpp.
+  m_pStorage = storage;
+}
+
+
+BedrockWhiteList::Utils::PlayerDB::~PlayerDB() {
+  // Owned by PluginConfig.
+  m_pStorage = nullptr;
+}
+
+
+BedrockWhiteList::Utils::StorageBackend*
+BedrockWhiteList::Utils::PlayerDB::GetStorage() {
+  return m_pStorage;
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetJournal(AuditJournal* journal) {
+  m_pJournal = journal;
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetCache(VerdictCache* cache) {
+  m_pCache = cache;
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetCounters(ListCounters* counters) {
+  m_pCounters = counters;
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetColumns(PlayerColumns* columns) {
+  m_pColumns = columns;
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetChangeCallback(ChangeCallback callback) {
+  m_changeCallback = std::move(callback);
+}
+
+
+size_t BedrockWhiteList::Utils::PlayerDB::Preload(VerdictCache& cache) {
+  assert(m_pStorage);
+
+  std::unique_lock lock(m_mutex);
+  size_t           count{0};
+
+  // Auto-recorded newcomers are left out, they are the bulk of the blacklist
+  // and an unknown player gets the same verdict anyway.
+  m_pStorage->ForEach(
+      [&](const PlayerInfo& info) {
+        cache.Put(
+            info.PlayerUuid,
+            {static_cast<uint8_t>(info.PlayerStatus), info.LastTime.Time}
+        );
+        count++;
+        return true;
+      },
+      false
+  );
+
+  return count;
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::RecountCounters() {
+  assert(m_pStorage);
+
+  if (m_pCounters == nullptr) {
+    return;
+  }
+
+  std::unique_lock lock(m_mutex);
+  m_pCounters->Recount(*m_pStorage, std::time(nullptr));
+}
+
+
+size_t BedrockWhiteList::Utils::PlayerDB::LoadColumns() {
+  assert(m_pStorage);
+
+  if (m_pColumns == nullptr) {
+    return 0;
+  }
+
+  std::unique_lock lock(m_mutex);
+  return m_pColumns->Load(*m_pStorage);
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetPlayerInfo(
+    PlayerInfo    playerInfo,
+    const string& actor
+) {
+  SetPlayerInfoBatch({playerInfo}, actor);
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetPlayerInfo(
+    PlayerInfo        playerInfo,
+    const string&     actor,
+    const PlayerInfo& oldInfo
+) {
+  const vector<PlayerInfo> oldInfos{oldInfo};
+  SetPlayerInfoBatch({playerInfo}, actor, &oldInfos);
+}
+
+
+size_t BedrockWhiteList::Utils::PlayerDB::SetPlayerInfoBatch(
+    const vector<PlayerInfo>& batch,
+    const string&             actor,
+    const vector<PlayerInfo>* oldInfos,
+    const string&             reason
+) {
+  assert(m_pStorage);
+  assert(oldInfos == nullptr or oldInfos->size() == batch.size());
+
+  if (batch.empty()) {
+    return 0;
+  }
+
+
+  // The old rows are needed by the journal and the counters, skip the reads
+  // without them. The counters read them in the write transaction even when
+  // given, two writes of one newcomer must not both count it.
+  const bool lookupOld =
+      (m_pJournal != nullptr and oldInfos == nullptr) or m_pCounters != nullptr;
+
+  // Newcomers have no reason to keep, and are the bulk of the writes.
+  vector<PlayerInfo> listed{};
+  for (auto& playerInfo : batch) {
+    if (playerInfo.Flags != AutoRecorded) {
+      listed.push_back(playerInfo);
+    }
+  }
+
+  vector<PlayerInfo> lookedUp{};
+  {
+    // The mirrors are updated as each part commits, under the backend's
+    // lock for its players, so they see the writes of concurrent batches in
+    // the order the backend did; the shards of one batch go in parallel.
+    const int64_t    now = std::time(nullptr);
+    std::shared_lock lock(m_mutex);
+    m_pStorage->WriteBatchWithHistory(
+        batch,
+        lookupOld ? &lookedUp : nullptr,
+        listed,
+        actor,
+        reason,
+        now,
+        [this, now](const auto& part, const auto& olds) {
+          Mirror(part, olds, now);
+        }
+    );
+  }
+
+
+  if (m_pJournal != nullptr) {
+    const auto& olds = oldInfos != nullptr ? *oldInfos : lookedUp;
+
+    for (size_t i = 0; i < batch.size(); i++) {
+      JournalRecord record{};
+      record.Actor       = actor;
+      record.PlayerUuid  = batch[i].PlayerUuid;
+      record.PlayerName  = batch[i].PlayerName;
+      record.NewStatus   = static_cast<uint8_t>(batch[i].PlayerStatus);
+      record.NewLastTime = batch[i].LastTime.Time;
+
+      if (not olds[i].Empty()) {
+        record.OldStatus   = static_cast<uint8_t>(olds[i].PlayerStatus);
+        record.OldLastTime = olds[i].LastTime.Time;
+      }
+
+      m_pJournal->Append(std::move(record));
+    }
+  }
+
+
+  if (m_changeCallback and not listed.empty()) {
+    m_changeCallback(listed);
+  }
+
+  return batch.size();
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::Mirror(
+    const vector<PlayerInfo>& part,
+    const vector<PlayerInfo>& oldInfos,
+    int64_t                   now
+) {
+  if (m_pCache != nullptr) {
+    PutVerdicts(*m_pCache, part);
+  }
+
+  if (m_pCounters != nullptr) {
+    for (size_t i = 0; i < part.size(); i++) {
+      m_pCounters->Apply(oldInfos[i], part[i], now);
+    }
+  }
+
+  if (m_pColumns != nullptr) {
+    for (auto& playerInfo : part) {
+      m_pColumns->Apply(playerInfo, now);
+    }
+  }
+}
+
+
+PlayerInfo
+BedrockWhiteList::Utils::PlayerDB::GetPlayerInfo(string playerName) {
+  assert(m_pStorage);
+
+  PlayerInfo info{};
+  m_pStorage->FindByName(playerName, info);
+
+  return info;
+}
+
+
+PlayerInfo
+BedrockWhiteList::Utils::PlayerDB::GetPlayerInfoAsUUID(string playerUuid) {
+  assert(m_pStorage);
+
+  PlayerInfo info{};
+  m_pStorage->FindByUuid(playerUuid, info);
+
+  return info;
+}
+
+
+vector<PlayerInfo>
+BedrockWhiteList::Utils::PlayerDB::GetPlayerListAsStatus(PlayerStatus status) {
+  assert(m_pStorage);
+
+  return m_pStorage->ListByStatus(status);
+}
+
+
+size_t BedrockWhiteList::Utils::PlayerDB::FindPlayers(
+    const PlayerQuery&  query,
+    size_t              limit,
+    vector<PlayerInfo>& players
+) {
+  assert(m_pStorage);
+
+  if (m_pColumns != nullptr) {
+    return m_pColumns->Select(query, limit, players);
+  }
+
+  // Without the columns every row is read, auto-recorded newcomers too.
+  vector<PlayerInfo> matches{};
+  m_pStorage->ForEach(
+      [&](const PlayerInfo& info) {
+        if (query.Matches(info)) {
+          matches.push_back(info);
+        }
+        return true;
+      },
+      true
+  );
+
+  const auto listed = std::min(limit, matches.size());
+  std::partial_sort(
+      matches.begin(),
+      matches.begin() + listed,
+      matches.end(),
+      [&](const auto& left, const auto& right) { return query.Precedes(left, right); }
+  );
+  players.insert(players.end(), matches.begin(), matches.begin() + listed);
+
+  return matches.size();
+}
+
+
+bool BedrockWhiteList::Utils::PlayerDB::GetPlayerMeta(
+    const string& playerUuid,
+    PlayerMeta&   meta,
+    size_t        historyLimit
+) {
+  assert(m_pStorage);
+
+  return m_pStorage->LoadMeta(playerUuid, meta, historyLimit);
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::SetPlayerNotes(
+    const string& playerUuid,
+    const string& notes
+) {
+  assert(m_pStorage);
+
+  m_pStorage->WriteNotes(playerUuid, notes);
+}
+
+
+void BedrockWhiteList::Utils::PlayerDB::ForgetSwept(
+    const vector<string>& playerUuids
+) {
+  assert(m_pStorage);
+
+  // Held alone, so no write mirrors a player between the lookup and the
+  // erase.
+  std::unique_lock lock(m_mutex);
+
+  if (m_pCounters != nullptr) {
+    m_pCounters->Swept(playerUuids.size());
+  }
+
+  for (auto& playerUuid : playerUuids) {
+    PlayerInfo info{};
+    if (m_pStorage->FindByUuid(playerUuid, info)) {
+      continue;
+    }
+
+    if (m_pCache != nullptr) {
+      m_pCache->Erase(playerUuid);
+    }
+
+    if (m_pColumns != nullptr) {
+      m_pColumns->Erase(playerUuid);
+    }
+  }
+}
+
+
+size_t BedrockWhiteList::Utils::PlayerDB::Import(StorageBackend& source) {
+  assert(m_pStorage);
+
+  constexpr size_t   batchSize = 1000;
+  vector<PlayerInfo> batch{};
+  size_t             count{0};
+
+  batch.reserve(batchSize);
+
+  // The lock is taken per batch, a recount waits for one batch at most.
+  const auto flush = [&]() {
+    vector<PlayerInfo> lookedUp{};
+    const int64_t      now = std::time(nullptr);
+    std::shared_lock   lock(m_mutex);
+    m_pStorage->WriteBatchWithHistory(
+        batch,
+        m_pCounters != nullptr ? &lookedUp : nullptr,
+        {},
+        "",
+        "",
+        now,
+        [this, now](const auto& part, const auto& olds) {
+          Mirror(part, olds, now);
+        }
+    );
+
+    count += batch.size();
+    batch.clear();
+  };
+
+  source.ForEach(
+      [&](const PlayerInfo& info) {
+        batch.push_back(info);
+        if (batch.size() >= batchSize) {
+          flush();
+        }
+        return true;
+      },
+      true
+  );
+
+  if (not batch.empty()) {
+    flush();
+  }
+
+  return count;
+}
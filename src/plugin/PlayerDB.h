@@ -0,0 +1,119 @@
+#pragma once
+
+
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "plugin/Columns.h"
+#include "plugin/Counters.h"
+#include "plugin/Journal.h"
+#include "plugin/Storage.h"
+#include "plugin/VerdictCache.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * The player lists as the rest of the plugin sees them: rows from the
+ * storage backend, with every write mirrored to the verdict cache, the
+ * audit journal, the list counters and the query columns.
+ */
+class PlayerDB {
+  public:
+  PlayerDB();
+  PlayerDB(StorageBackend*);
+  ~PlayerDB();
+
+  // Gets the rows of a batch that are not auto-recorded newcomers, after
+  // they were written, on the writing thread.
+  typedef std::function<void(const std::vector<PlayerInfo>&)> ChangeCallback;
+
+  public:
+  StorageBackend* GetStorage();
+
+  void SetJournal(AuditJournal* journal);
+  void SetCache(VerdictCache* cache);
+  void SetCounters(ListCounters* counters);
+  void SetColumns(PlayerColumns* columns);
+  void SetChangeCallback(ChangeCallback callback);
+
+  size_t Preload(VerdictCache& cache);
+  // Counts every row into the counters again, writes wait meanwhile.
+  void RecountCounters();
+  // Copies every row into the columns, writes wait meanwhile.
+  size_t LoadColumns();
+
+  void SetPlayerInfo(PlayerInfo playerInfo, const std::string& actor);
+  void SetPlayerInfo(
+      PlayerInfo         playerInfo,
+      const std::string& actor,
+      const PlayerInfo&  oldInfo
+  );
+  // Every player but auto-recorded newcomers also gets a history record
+  // with reason.
+  size_t SetPlayerInfoBatch(
+      const std::vector<PlayerInfo>& batch,
+      const std::string&             actor,
+      const std::vector<PlayerInfo>* oldInfos = nullptr,
+      const std::string&             reason   = ""
+  );
+  PlayerInfo              GetPlayerInfo(std::string playerName);
+  PlayerInfo              GetPlayerInfoAsUUID(std::string playerUuid);
+  std::vector<PlayerInfo> GetPlayerListAsStatus(PlayerStatus status);
+
+  // The players matching query, the first limit of them into players;
+  // from the columns when there are, otherwise by visiting every row.
+  size_t FindPlayers(
+      const PlayerQuery&       query,
+      size_t                   limit,
+      std::vector<PlayerInfo>& players
+  );
+
+  // Cold metadata, for commands; the connect path never reads it.
+  bool GetPlayerMeta(const std::string& playerUuid, PlayerMeta& meta, size_t historyLimit);
+  void SetPlayerNotes(const std::string& playerUuid, const std::string& notes);
+
+  // Newcomers the retention sweeper deleted, taken out of the counters, the
+  // cache and the columns; a player written again since keeps what that
+  // write put there.
+  void ForgetSwept(const std::vector<std::string>& playerUuids);
+
+  // Copies every row of another backend in, a bounded batch at a time, each
+  // written and mirrored like any other, so joins and commands go on in
+  // between. Not journaled, the lists do not change.
+  size_t Import(StorageBackend& source);
+
+  private:
+  // Mirrors a committed part of a batch into the cache, the counters and
+  // the columns; called by the backend under its lock for those players.
+  void Mirror(
+      const std::vector<PlayerInfo>& part,
+      const std::vector<PlayerInfo>& oldInfos,
+      int64_t                        now
+  );
+
+  private:
+  // Shared by writes, which the backend orders itself, and held alone by
+  // what reads every row into the mirrors. Lookups do not take it, the
+  // backend is safe to read while it writes.
+  mutable std::shared_mutex m_mutex;
+
+  StorageBackend* m_pStorage;
+  AuditJournal*   m_pJournal{nullptr};
+  VerdictCache*   m_pCache{nullptr};
+  ListCounters*   m_pCounters{nullptr};
+  PlayerColumns*  m_pColumns{nullptr};
+  ChangeCallback  m_changeCallback{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,396 @@
+#include "plugin/Rules.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <mutex>
+#include <optional>
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+using std::string, std::string_view, std::vector;
+
+using BedrockWhiteList::Utils::RuleDecision;
+using BedrockWhiteList::Utils::RuleEngine;
+using BedrockWhiteList::Utils::RuleInput;
+
+
+constexpr uint8_t  EVERY_DAY      = 0x7F;
+constexpr uint16_t MINUTES_IN_DAY = 24 * 60;
+
+constexpr const char* DAY_NAMES[] =
+    {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+
+// sun .. sat by their first three letters, weekdays and weekend.
+inline static bool ParseDay(string day, uint8_t& mask) {
+  std::transform(day.begin(), day.end(), day.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+
+  if (day == "weekdays") {
+    mask |= 0b0111110;
+    return true;
+  }
+
+  if (day == "weekend") {
+    mask |= 0b1000001;
+    return true;
+  }
+
+  for (int i = 0; i < 7; i++) {
+    if (day.size() >= 3 and day.compare(0, 3, DAY_NAMES[i]) == 0) {
+      mask |= static_cast<uint8_t>(1 << i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// Digits only: from_chars takes no blank, and the sign is checked.
+inline static bool ParseNumber(string_view text, int& value) {
+  const auto end           = text.data() + text.size();
+  const auto [stop, error] = std::from_chars(text.data(), end, value);
+
+  return error == std::errc{} and stop == end and not text.empty()
+     and std::isdigit(static_cast<unsigned char>(text[0]));
+}
+
+
+// H:MM or HH:MM, from 0:00 to 24:00.
+inline static bool ParseMinute(string_view text, uint16_t& minute) {
+  const auto colon = text.find(':');
+  if (colon == string_view::npos or colon > 2 or text.size() != colon + 3) {
+    return false;
+  }
+
+  int hours{0}, minutes{0};
+  if (not ParseNumber(text.substr(0, colon), hours)
+      or not ParseNumber(text.substr(colon + 1), minutes) or hours > 24
+      or minutes >= 60 or hours * 60 + minutes > MINUTES_IN_DAY) {
+    return false;
+  }
+
+  minute = static_cast<uint16_t>(hours * 60 + minutes);
+  return true;
+}
+
+
+// "HH:MM-HH:MM", 24:00 closes a window at midnight.
+inline static bool ParseHours(const string& hours, uint16_t& from, uint16_t& to) {
+  const auto dash = hours.find('-');
+
+  return dash != string::npos and ParseMinute(hours.substr(0, dash), from)
+     and ParseMinute(hours.substr(dash + 1), to) and from != to
+     and from < MINUTES_IN_DAY;
+}
+
+
+// - - - - - - Input - - - - - -
+
+
+RuleInput BedrockWhiteList::Utils::RuleInput::At(std::time_t now) {
+  const auto local = fmt::localtime(now);
+
+  RuleInput input{};
+  input.Weekday = local.tm_wday;
+  input.Minute  = local.tm_hour * 60 + local.tm_min;
+  input.Hour    = static_cast<int64_t>(now) / 3600;
+  return input;
+}
+
+
+bool BedrockWhiteList::Utils::RuleDecision::Matched() const { return Rule >= 0; }
+
+
+// - - - - - - Engine - - - - - -
+
+
+bool BedrockWhiteList::Utils::RuleEngine::Compile(
+    const vector<RuleSource>& rules,
+    NamedLists*               lists,
+    GroupCache*               groups,
+    string&                   error
+) {
+  vector<Row>      table{};
+  vector<string>   expressions{};
+  GroupCache::Bits bits{};
+
+  for (size_t i = 0; i < rules.size(); i++) {
+    const auto& rule = rules[i];
+    const auto  fail = [&](const string& what) {
+      error = fmt::format("rule {} ({}): {}", i + 1, rule.Name, what);
+      return false;
+    };
+
+    Row row{EVERY_DAY, 0, MINUTES_IN_DAY, -1, 0, -1, 0, true};
+
+    if (not rule.Days.empty()) {
+      row.Days = 0;
+      for (auto& day : rule.Days) {
+        if (not ParseDay(day, row.Days)) {
+          return fail("unknown day '" + day + "'");
+        }
+      }
+    }
+
+    if (not rule.Hours.empty()
+        and not ParseHours(rule.Hours, row.FromMinute, row.ToMinute)) {
+      return fail("hours must look like 18:00-23:30");
+    }
+
+    if (0 <= rule.Newcomer) {
+      row.Newcomer = rule.Newcomer ? 1 : 0;
+    }
+
+    if (rule.LimitPerHour < 0) {
+      return fail("limitPerHour must not be negative");
+    }
+    row.LimitPerHour = rule.LimitPerHour;
+
+    if (rule.Action != "allow" and rule.Action != "deny") {
+      return fail("action must be allow or deny");
+    }
+    row.Allow = rule.Action == "allow";
+
+    if (not rule.Groups.empty()) {
+      if (groups == nullptr) {
+        return fail("groups are not available");
+      }
+
+      // The table in use keeps its bits until this one replaces it.
+      string why{};
+      if (not GroupCache::Register(rule.Groups, bits, row.Groups, why)) {
+        return fail(why);
+      }
+    }
+
+    if (not rule.Lists.empty()) {
+      if (lists == nullptr) {
+        return fail("lists need the sqlite backend");
+      }
+
+      row.Expression = static_cast<int32_t>(expressions.size());
+      expressions.push_back(rule.Lists);
+    }
+
+    table.push_back(row);
+  }
+
+
+  std::unique_lock lock(m_mutex);
+
+  if (lists != nullptr and not lists->SetExpressions(expressions, error)) {
+    error = "rules: " + error;
+    return false;
+  }
+
+  // Under the lock, so no connect tests the new rows with the old bits.
+  if (groups != nullptr) {
+    groups->SetBits(std::move(bits));
+  }
+
+  m_table    = std::move(table);
+  m_sources  = rules;
+  m_counters = std::make_unique<Counter[]>(m_table.size());
+  m_lists    = lists;
+  m_groups   = groups;
+  return true;
+}
+
+
+// The window starts over with the first connect of a new hour.
+bool BedrockWhiteList::Utils::RuleEngine::TakeSlot(
+    const Row& row,
+    Counter&   counter,
+    int64_t    hour,
+    SlotUse    slots
+) const {
+  auto current = counter.Hour.load(std::memory_order_relaxed);
+  if (current != hour and counter.Hour.compare_exchange_strong(current, hour)) {
+    counter.Taken.store(0, std::memory_order_relaxed);
+  }
+
+  if (slots == Peek) {
+    return counter.Taken.load(std::memory_order_relaxed) < row.LimitPerHour;
+  }
+
+  if (counter.Taken.fetch_add(1, std::memory_order_relaxed) >= row.LimitPerHour) {
+    counter.Taken.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  return true;
+}
+
+
+RuleDecision BedrockWhiteList::Utils::RuleEngine::Evaluate(
+    const RuleInput& input,
+    SlotUse          slots
+) const {
+  std::shared_lock lock(m_mutex);
+
+  RuleDecision decision{};
+  const auto   dayBit = static_cast<uint8_t>(1 << input.Weekday);
+  const auto   minute = static_cast<uint16_t>(input.Minute);
+
+  // Taken and looked up once, by the first row that has lists.
+  std::optional<NamedLists::Reader> reader{};
+  uint32_t                          playerId{0};
+  bool                              hasId{false};
+
+  // Likewise by the first row that has groups.
+  uint64_t playerGroups{0};
+  bool     hasGroups{false};
+
+  for (size_t i = 0; i < m_table.size(); i++) {
+    const auto& row = m_table[i];
+    decision.Scanned++;
+
+    if (not(row.Days & dayBit)) {
+      continue;
+    }
+
+    if (row.FromMinute < row.ToMinute
+            ? minute < row.FromMinute or minute >= row.ToMinute
+            : minute < row.FromMinute and minute >= row.ToMinute) {
+      continue;
+    }
+
+    if (0 <= row.Newcomer and row.Newcomer != static_cast<int8_t>(input.Newcomer)) {
+      continue;
+    }
+
+    if (row.Groups != 0) {
+      if (not hasGroups) {
+        playerGroups = m_groups->Mask(*input.PlayerUuid);
+        hasGroups    = true;
+      }
+
+      if (not(playerGroups & row.Groups)) {
+        continue;
+      }
+    }
+
+    if (0 <= row.Expression) {
+      if (not reader) {
+        reader.emplace(*m_lists);
+        hasId = reader->FindId(*input.PlayerUuid, playerId);
+      }
+
+      if (not reader->Evaluate(
+              row.Expression,
+              hasId,
+              playerId,
+              input.Whitelisted,
+              input.Blacklisted
+          )) {
+        continue;
+      }
+    }
+
+    if (0 < row.LimitPerHour and slots != Held
+        and not TakeSlot(row, m_counters[i], input.Hour, slots)) {
+      continue;
+    }
+
+    if (slots == Take) {
+      m_counters[i].Hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    decision.Rule  = static_cast<int>(i);
+    decision.Allow = row.Allow;
+    return decision;
+  }
+
+  return decision;
+}
+
+
+size_t BedrockWhiteList::Utils::RuleEngine::Size() const {
+  std::shared_lock lock(m_mutex);
+  return m_table.size();
+}
+
+
+string BedrockWhiteList::Utils::RuleEngine::Name(int rule) const {
+  std::shared_lock lock(m_mutex);
+
+  if (rule < 0 or static_cast<size_t>(rule) >= m_sources.size()) {
+    return {};
+  }
+
+  return m_sources[rule].Name;
+}
+
+
+string BedrockWhiteList::Utils::RuleEngine::Message(int rule) const {
+  std::shared_lock lock(m_mutex);
+
+  if (rule < 0 or static_cast<size_t>(rule) >= m_sources.size()) {
+    return {};
+  }
+
+  return m_sources[rule].Message;
+}
+
+
+vector<RuleEngine::Summary> BedrockWhiteList::Utils::RuleEngine::Describe() const {
+  std::shared_lock lock(m_mutex);
+
+  vector<Summary> summary{};
+  for (size_t i = 0; i < m_table.size(); i++) {
+    const auto& row    = m_table[i];
+    const auto& source = m_sources[i];
+    string      description{};
+
+    if (row.Days != EVERY_DAY) {
+      for (int day = 0; day < 7; day++) {
+        if (row.Days & (1 << day)) {
+          description += description.empty() ? "" : ",";
+          description += DAY_NAMES[day];
+        }
+      }
+      description += " ";
+    }
+
+    if (not source.Hours.empty()) {
+      description += source.Hours + " ";
+    }
+
+    if (0 <= row.Newcomer) {
+      description += row.Newcomer ? "newcomers " : "known players ";
+    }
+
+    if (not source.Groups.empty()) {
+      description += "groups ";
+      for (size_t group = 0; group < source.Groups.size(); group++) {
+        description += (group == 0 ? "" : ",") + source.Groups[group];
+      }
+      description += " ";
+    }
+
+    if (not source.Lists.empty()) {
+      description += "[" + source.Lists + "] ";
+    }
+
+    if (0 < row.LimitPerHour) {
+      description += fmt::format("{}/h ", row.LimitPerHour);
+    }
+
+    description += row.Allow ? "-> allow" : "-> deny";
+
+    const auto& counter = m_counters[i];
+    summary.push_back(
+        {source.Name,
+         description,
+         counter.Hits.load(std::memory_order_relaxed),
+         0 < row.LimitPerHour ? counter.Taken.load(std::memory_order_relaxed) : 0}
+    );
+  }
+
+  return summary;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "plugin/Groups.h"
+#include "plugin/NamedLists.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// One entry of the rules section, as written in config.yaml.
+// Days are mon .. sun, weekdays or weekend, Hours "HH:MM-HH:MM" in local
+// time and may wrap midnight; left empty, both mean always. Newcomer is -1
+// for anyone, 0 for known players and 1 for newcomers only. Groups match a
+// player in any of them.
+struct RuleSource {
+  std::string              Name;
+  std::vector<std::string> Days{};
+  std::string              Hours{};
+  int                      Newcomer{-1};
+  std::string              Lists{}; // list expression, see ListExpression
+  std::vector<std::string> Groups{};
+  int                      LimitPerHour{0};
+  std::string              Action{"allow"};
+  std::string              Message{};
+};
+
+
+// What a rule is matched against, worked out once per connect.
+struct RuleInput {
+  int                Weekday;   // 0 is Sunday
+  int                Minute;    // of the local day
+  int64_t            Hour;      // since the epoch, windows the slot limits
+  bool               Whitelisted;
+  bool               Blacklisted;
+  bool               Newcomer;
+  const std::string* PlayerUuid;
+
+  static RuleInput At(std::time_t now);
+};
+
+
+struct RuleDecision {
+  int    Rule{-1};
+  bool   Allow{false};
+  size_t Scanned{0};
+
+  bool Matched() const;
+};
+
+
+/*
+ * The rules section of config.yaml, compiled into a flat decision table:
+ * every rule becomes a fixed-size row of a weekday mask, a minute window, a
+ * newcomer test, a group mask, a handle of a list expression and a slot
+ * limit. The first row that matches decides, a connect no row matches falls
+ * through to the lists.admission expression.
+ *
+ *   rules:
+ *     - name: weekend-event
+ *       days: [weekend]
+ *       lists: event-2026
+ *       action: allow
+ *     - name: vip
+ *       groups: [vip]
+ *       action: allow
+ *     - name: newcomer-slots
+ *       newcomer: true
+ *       limitPerHour: 20
+ *       action: allow
+ *
+ * The groups of a player are looked up once per connect, by the first row
+ * that has any, and tested with one AND per row.
+ *
+ * Evaluate allocates only when the group cache asks its resolver about a
+ * player; slot counters and hit counts are atomics, so the admission worker
+ * may evaluate while the game thread does too.
+ */
+class RuleEngine {
+  public:
+  struct Summary {
+    std::string Name;
+    std::string Description;
+    uint64_t    Hits;
+    int32_t     SlotsTaken;
+  };
+
+  // How a match counts against limitPerHour: a connect takes a slot, a
+  // re-check only looks, a player already online holds one.
+  typedef enum __tagSlotUse { Take, Peek, Held } SlotUse;
+
+  public:
+  // Replaces the table, and the group bits, only when every rule compiles;
+  // error names the first rule that does not. lists may be null when no rule has lists, groups
+  // when no rule has groups.
+  bool Compile(
+      const std::vector<RuleSource>& rules,
+      NamedLists*                    lists,
+      GroupCache*                    groups,
+      std::string&                   error
+  );
+
+  // Only Take counts the hits.
+  RuleDecision Evaluate(const RuleInput& input, SlotUse slots) const;
+
+  size_t               Size() const;
+  std::string          Name(int rule) const;
+  std::string          Message(int rule) const;
+  std::vector<Summary> Describe() const;
+
+  private:
+  struct Row {
+    uint8_t  Days;       // bit per weekday, Sunday is bit 0
+    uint16_t FromMinute; // [FromMinute, ToMinute), wraps when From > To
+    uint16_t ToMinute;
+    int8_t   Newcomer;
+    uint64_t Groups;     // GroupCache bits, 0 for anyone
+    int32_t  Expression; // NamedLists expression handle, -1 for anyone
+    int32_t  LimitPerHour;
+    bool     Allow;
+  };
+
+  struct Counter {
+    std::atomic<int64_t>  Hour{-1};
+    std::atomic<int32_t>  Taken{0};
+    std::atomic<uint64_t> Hits{0};
+  };
+
+  bool TakeSlot(const Row& row, Counter& counter, int64_t hour, SlotUse slots)
+      const;
+
+  private:
+  mutable std::shared_mutex  m_mutex;
+  std::vector<Row>           m_table{};
+  std::vector<RuleSource>    m_sources{};
+  std::unique_ptr<Counter[]> m_counters{};
+  NamedLists*                m_lists{nullptr};
+  GroupCache*                m_groups{nullptr};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,675 @@
+#include "plugin/Shards.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iterator>
+#include <latch>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/core.h>
+#include <sqlite3.h>
+
+#include "plugin/Migration.h"
+
+using std::string, std::string_view, std::vector;
+
+using namespace std::chrono;
+
+using BedrockWhiteList::Utils::PlayerInfo;
+using BedrockWhiteList::Utils::RebalanceReport;
+using BedrockWhiteList::Utils::ShardedBackend;
+
+namespace filesystem = std::filesystem;
+
+
+// - - - - - - Layout - - - - - -
+
+
+uint32_t BedrockWhiteList::Utils::ShardOf(string_view playerUuid, size_t shards) {
+  if (shards <= 1) {
+    return 0;
+  }
+
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : playerUuid) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+
+  return static_cast<uint32_t>(hash % shards);
+}
+
+
+string BedrockWhiteList::Utils::ShardPath(
+    const string& databasePath,
+    size_t        shard,
+    size_t        shards
+) {
+  const filesystem::path path(databasePath);
+
+  return (path.parent_path()
+          / fmt::format(
+              "{0}.shard{1}-of-{2}{3}",
+              path.stem().string(),
+              shard,
+              shards,
+              path.extension().string()
+          ))
+      .string();
+}
+
+
+vector<string> BedrockWhiteList::Utils::RowDatabasePaths(
+    const string& databasePath,
+    size_t        shards
+) {
+  if (shards <= 1) {
+    return {databasePath};
+  }
+
+  vector<string> paths{};
+  for (size_t shard = 0; shard < shards; shard++) {
+    paths.push_back(ShardPath(databasePath, shard, shards));
+  }
+
+  return paths;
+}
+
+
+size_t BedrockWhiteList::Utils::StoredShardCount(SQLite::Database& database) {
+  SQLite::Statement query(
+      database,
+      "SELECT layout_value FROM storage_layout WHERE layout_key = 'shards'"
+  );
+
+  return query.executeStep() ? std::max<size_t>(query.getColumn(0).getInt64(), 1) : 1;
+}
+
+
+void BedrockWhiteList::Utils::StoreShardCount(
+    SQLite::Database& database,
+    size_t            shards
+) {
+  SQLite::Statement upsert(
+      database,
+      "INSERT OR REPLACE INTO storage_layout(layout_key, layout_value) "
+      "VALUES('shards', ?1)"
+  );
+  upsert.bind(1, static_cast<long long>(shards));
+  upsert.exec();
+}
+
+
+std::unique_ptr<SQLite::Database>
+BedrockWhiteList::Utils::OpenShardDatabase(const string& path) {
+  const auto created = not filesystem::exists(path);
+
+  auto database = std::make_unique<SQLite::Database>(
+      path,
+      SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+  );
+
+  // As the main database, see PluginConfig::OpenDatabase(). A new file has
+  // nothing to copy and takes every migration at once; an existing one gets
+  // the rest from PluginConfig::MigrateOnline().
+  database->exec("PRAGMA auto_vacuum = INCREMENTAL;");
+  database->exec("PRAGMA journal_mode = WAL;");
+  database->setBusyTimeout(250);
+
+  Migrator(*database, PlayerSchemaMigrations())
+      .Run(created ? -1 : PLAYER_SCHEMA_BASELINE);
+  return database;
+}
+
+
+// - - - - - - Rebalance - - - - - -
+
+
+inline static void
+ShardFunction(sqlite3_context* context, int, sqlite3_value** values) {
+  const auto text   = sqlite3_value_text(values[0]);
+  const auto length = sqlite3_value_bytes(values[0]);
+  const auto shards = sqlite3_value_int64(values[1]);
+
+  sqlite3_result_int64(
+      context,
+      BedrockWhiteList::Utils::ShardOf(
+          string_view(reinterpret_cast<const char*>(text), text ? length : 0),
+          static_cast<size_t>(std::max<sqlite3_int64>(shards, 1))
+      )
+  );
+}
+
+
+// The columns of table in target, but for a rowid alias that would clash
+// between the shards merged into it.
+inline static string CopiedColumns(SQLite::Database& target, const char* table) {
+  SQLite::Statement info(target, fmt::format("PRAGMA main.table_info({0})", table));
+
+  string columns{};
+  while (info.executeStep()) {
+    const auto name = info.getColumn(1).getString();
+    if (name == "history_id") {
+      continue;
+    }
+
+    columns += columns.empty() ? "" : ", ";
+    columns += name;
+  }
+
+  return columns;
+}
+
+
+size_t BedrockWhiteList::Utils::CopyShardRows(
+    SQLite::Database& target,
+    const string&     sourcePath,
+    size_t            shard,
+    size_t            shards
+) {
+  const auto result = sqlite3_create_function_v2(
+      target.getHandle(),
+      "bew_shard",
+      2,
+      SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+      nullptr,
+      ShardFunction,
+      nullptr,
+      nullptr,
+      nullptr
+  );
+  if (result != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errstr(result));
+  }
+
+  // Not within a transaction.
+  {
+    SQLite::Statement attach(target, "ATTACH DATABASE ?1 AS source");
+    attach.bind(1, sourcePath);
+    attach.exec();
+  }
+
+  size_t rows{0};
+
+  try {
+
+    SQLite::Transaction transaction(target);
+
+    for (auto table : PLAYER_ROW_TABLES) {
+      const auto        columns = CopiedColumns(target, table);
+      SQLite::Statement copy(
+          target,
+          fmt::format(
+              "INSERT OR REPLACE INTO main.{0}({1}) SELECT {1} FROM source.{0} "
+              "WHERE bew_shard(player_uuid, ?1) = ?2{2}",
+              table,
+              columns,
+              // A player's history keeps its order under the new ids.
+              string_view(table) == "player_history" ? " ORDER BY history_id" : ""
+          )
+      );
+      copy.bind(1, static_cast<long long>(shards));
+      copy.bind(2, static_cast<long long>(shard));
+
+      const auto copied = copy.exec();
+      if (string_view(table) == "whitelist" or string_view(table) == "blacklist") {
+        rows += static_cast<size_t>(copied);
+      }
+    }
+
+    transaction.commit();
+
+  } catch (...) {
+    target.exec("DETACH DATABASE source");
+    throw;
+  }
+
+  target.exec("DETACH DATABASE source");
+  return rows;
+}
+
+
+inline static void RemoveDatabaseFiles(const string& path) {
+  for (auto suffix : {"", "-wal", "-shm"}) {
+    std::error_code ec;
+    filesystem::remove(path + suffix, ec);
+  }
+}
+
+
+inline static void ClearRows(SQLite::Database& database) {
+  SQLite::Transaction transaction(database);
+  for (auto table : BedrockWhiteList::Utils::PLAYER_ROW_TABLES) {
+    database.exec(fmt::format("DELETE FROM {0}", table));
+  }
+  transaction.commit();
+}
+
+
+// Shard files of databasePath laid out for another count than shards.
+inline static void RemoveStrayShards(const string& databasePath, size_t shards) {
+  const filesystem::path path(databasePath);
+  const auto             directory =
+      path.parent_path().empty() ? filesystem::path(".") : path.parent_path();
+  const auto prefix = path.stem().string() + ".shard";
+
+  std::error_code          ec;
+  vector<filesystem::path> strays{};
+
+  for (auto& entry : filesystem::directory_iterator(directory, ec)) {
+    const auto name = entry.path().filename().string();
+    const auto of   = name.find("-of-");
+
+    if (name.rfind(prefix, 0) != 0 or of == string::npos) {
+      continue;
+    }
+
+    const auto count = std::strtoull(name.c_str() + of + 4, nullptr, 10);
+    if (shards <= 1 or count != shards) {
+      strays.push_back(entry.path());
+    }
+  }
+
+  for (auto& stray : strays) {
+    filesystem::remove(stray, ec);
+  }
+}
+
+
+RebalanceReport BedrockWhiteList::Utils::RebalanceShards(
+    SQLite::Database& database,
+    const string&     databasePath,
+    size_t            shards
+) {
+  const auto startTime = steady_clock::now();
+  const auto from      = StoredShardCount(database);
+
+  RebalanceReport report{from, shards, 0, 0};
+
+  if (from != shards) {
+    const auto sources = RowDatabasePaths(databasePath, from);
+    const auto targets = RowDatabasePaths(databasePath, shards);
+
+    // Whatever an interrupted run left in the targets goes first.
+    if (shards <= 1) {
+      ClearRows(database);
+    } else {
+      for (auto& target : targets) {
+        RemoveDatabaseFiles(target);
+      }
+    }
+
+
+    // One writer per new shard, each reading every old one.
+    vector<std::exception_ptr> errors(targets.size());
+    vector<size_t>             rows(targets.size());
+    vector<std::thread>        fillers{};
+
+    for (size_t shard = 0; shard < targets.size(); shard++) {
+      fillers.emplace_back([&, shard]() {
+        try {
+
+          auto target =
+              shards <= 1
+                  ? std::make_unique<SQLite::Database>(
+                        databasePath,
+                        SQLite::OPEN_READWRITE,
+                        5000
+                    )
+                  : OpenShardDatabase(targets[shard]);
+
+          for (auto& source : sources) {
+            rows[shard] += CopyShardRows(*target, source, shard, shards);
+          }
+
+        } catch (...) {
+          errors[shard] = std::current_exception();
+        }
+      });
+    }
+
+    for (auto& filler : fillers) {
+      filler.join();
+    }
+
+    for (auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+
+    // From here on the new layout is the one in use.
+    StoreShardCount(database, shards);
+
+    if (from <= 1) {
+      ClearRows(database);
+    }
+
+    for (auto count : rows) {
+      report.Rows += count;
+    }
+  }
+
+  RemoveStrayShards(databasePath, shards);
+
+  report.DurationMillis =
+      duration_cast<milliseconds>(steady_clock::now() - startTime).count();
+  return report;
+}
+
+
+// - - - - - - Backend - - - - - -
+
+
+BedrockWhiteList::Utils::ShardedBackend::ShardedBackend(
+    const string& databasePath,
+    size_t        shards
+) {
+  for (auto& path : RowDatabasePaths(databasePath, shards)) {
+    auto shard  = std::make_unique<Shard>();
+    shard->Rows = std::make_unique<SQLiteBackend>(OpenShardDatabase(path));
+
+    auto lookups = std::make_unique<SQLite::Database>(path, SQLite::OPEN_READONLY);
+    lookups->setBusyTimeout(250);
+    shard->Lookups = std::make_unique<SQLiteBackend>(std::move(lookups));
+
+    m_shards.push_back(std::move(shard));
+  }
+}
+
+
+// The writers finish their jobs before the connections close.
+BedrockWhiteList::Utils::ShardedBackend::~ShardedBackend() {
+  for (auto& shard : m_shards) {
+    shard->Writer.Stop();
+  }
+}
+
+
+BedrockWhiteList::Utils::StorageKind
+BedrockWhiteList::Utils::ShardedBackend::Kind() const {
+  return SQLiteStorage;
+}
+
+
+void BedrockWhiteList::Utils::ShardedBackend::FanOut(
+    const vector<size_t>&              shards,
+    const std::function<void(size_t)>& job
+) {
+  vector<std::exception_ptr> errors(m_shards.size());
+  std::latch                 done(static_cast<std::ptrdiff_t>(shards.size()));
+
+  for (auto index : shards) {
+    const auto posted =
+        m_shards[index]->Writer.Post([this, index, &job, &errors, &done]() {
+          try {
+            std::lock_guard lock(m_shards[index]->Mutex);
+            job(index);
+          } catch (...) {
+            errors[index] = std::current_exception();
+          }
+
+          done.count_down();
+        });
+
+    // Closing: the job will not run, and the latch must not wait for it.
+    if (not posted) {
+      errors[index] = std::make_exception_ptr(
+          std::runtime_error(fmt::format("Shard {0} is closed. ", index))
+      );
+      done.count_down();
+    }
+  }
+
+  done.wait();
+  m_fanOuts.fetch_add(1, std::memory_order_relaxed);
+
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+
+vector<vector<size_t>>
+BedrockWhiteList::Utils::ShardedBackend::Split(const vector<PlayerInfo>& batch) const {
+  vector<vector<size_t>> parts(m_shards.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    parts[ShardOf(batch[i].PlayerUuid, m_shards.size())].push_back(i);
+  }
+
+  return parts;
+}
+
+
+bool BedrockWhiteList::Utils::ShardedBackend::FindByUuid(
+    const string& playerUuid,
+    PlayerInfo&   info
+) {
+  auto& shard = *m_shards[ShardOf(playerUuid, m_shards.size())];
+  return shard.Lookups->FindByUuid(playerUuid, info);
+}
+
+
+// Names are not what the rows are sharded by, every shard is asked; the
+// lowest shard that has the name answers.
+bool BedrockWhiteList::Utils::ShardedBackend::FindByName(
+    const string& playerName,
+    PlayerInfo&   info
+) {
+  vector<PlayerInfo> found(m_shards.size());
+  vector<char>       hits(m_shards.size());
+  vector<size_t>     all(m_shards.size());
+
+  for (size_t shard = 0; shard < all.size(); shard++) {
+    all[shard] = shard;
+  }
+
+  FanOut(all, [&](size_t shard) {
+    hits[shard] = m_shards[shard]->Rows->FindByName(playerName, found[shard]);
+  });
+
+  for (size_t shard = 0; shard < hits.size(); shard++) {
+    if (hits[shard]) {
+      info = found[shard];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+vector<PlayerInfo>
+BedrockWhiteList::Utils::ShardedBackend::ListByStatus(PlayerStatus status) {
+  vector<vector<PlayerInfo>> lists(m_shards.size());
+  vector<size_t>             all(m_shards.size());
+
+  for (size_t shard = 0; shard < all.size(); shard++) {
+    all[shard] = shard;
+  }
+
+  FanOut(all, [&](size_t shard) {
+    lists[shard] = m_shards[shard]->Rows->ListByStatus(status);
+  });
+
+  size_t size{0};
+  for (auto& list : lists) {
+    size += list.size();
+  }
+
+  vector<PlayerInfo> infoList{};
+  infoList.reserve(size);
+  for (auto& list : lists) {
+    std::move(list.begin(), list.end(), std::back_inserter(infoList));
+  }
+
+  return infoList;
+}
+
+
+void BedrockWhiteList::Utils::ShardedBackend::ForEach(
+    const Visitor& visitor,
+    bool           withAutoRecorded
+) {
+  bool going{true};
+
+  for (auto& shard : m_shards) {
+    std::lock_guard lock(shard->Mutex);
+
+    shard->Rows->ForEach(
+        [&](const PlayerInfo& info) {
+          going = visitor(info);
+          return going;
+        },
+        withAutoRecorded
+    );
+
+    if (not going) {
+      return;
+    }
+  }
+}
+
+
+void BedrockWhiteList::Utils::ShardedBackend::WriteBatch(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos
+) {
+  const auto                 parts = Split(batch);
+  vector<vector<PlayerInfo>> olds(m_shards.size());
+  vector<size_t>             busy{};
+
+  for (size_t shard = 0; shard < parts.size(); shard++) {
+    if (not parts[shard].empty()) {
+      busy.push_back(shard);
+    }
+  }
+
+  FanOut(busy, [&](size_t shard) {
+    vector<PlayerInfo> part{};
+    part.reserve(parts[shard].size());
+    for (auto index : parts[shard]) {
+      part.push_back(batch[index]);
+    }
+
+    m_shards[shard]->Rows->WriteBatch(part, oldInfos ? &olds[shard] : nullptr);
+    m_shards[shard]->RowsWritten.fetch_add(part.size(), std::memory_order_relaxed);
+  });
+
+  // Back in the order of batch.
+  if (oldInfos != nullptr) {
+    const auto base = oldInfos->size();
+    oldInfos->resize(base + batch.size());
+
+    for (auto shard : busy) {
+      for (size_t i = 0; i < parts[shard].size(); i++) {
+        (*oldInfos)[base + parts[shard][i]] = olds[shard][i];
+      }
+    }
+  }
+}
+
+
+// The rows and the history of a player live in the same shard, so every
+// shard commits its part of both at once; shards do not commit together.
+// committed runs on the writer of each shard, under its lock.
+void BedrockWhiteList::Utils::ShardedBackend::WriteBatchWithHistory(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos,
+    const vector<PlayerInfo>& history,
+    const string&             actor,
+    const string&             reason,
+    int64_t                   time,
+    const Committed&          committed
+) {
+  const auto                 parts   = Split(batch);
+  const auto                 records = Split(history);
+  vector<vector<PlayerInfo>> olds(m_shards.size());
+  vector<size_t>             busy{};
+
+  for (size_t shard = 0; shard < parts.size(); shard++) {
+    if (not parts[shard].empty()) {
+      busy.push_back(shard);
+    }
+  }
+
+  FanOut(busy, [&](size_t shard) {
+    vector<PlayerInfo> part{}, partHistory{};
+    part.reserve(parts[shard].size());
+    for (auto index : parts[shard]) {
+      part.push_back(batch[index]);
+    }
+    for (auto index : records[shard]) {
+      partHistory.push_back(history[index]);
+    }
+
+    m_shards[shard]->Rows->WriteBatchWithHistory(
+        part,
+        oldInfos ? &olds[shard] : nullptr,
+        partHistory,
+        actor,
+        reason,
+        time,
+        committed
+    );
+    m_shards[shard]->RowsWritten.fetch_add(part.size(), std::memory_order_relaxed);
+  });
+
+  if (oldInfos != nullptr) {
+    const auto base = oldInfos->size();
+    oldInfos->resize(base + batch.size());
+
+    for (auto shard : busy) {
+      for (size_t i = 0; i < parts[shard].size(); i++) {
+        (*oldInfos)[base + parts[shard][i]] = olds[shard][i];
+      }
+    }
+  }
+}
+
+
+void BedrockWhiteList::Utils::ShardedBackend::WriteNotes(
+    const string& playerUuid,
+    const string& notes
+) {
+  auto&           shard = *m_shards[ShardOf(playerUuid, m_shards.size())];
+  std::lock_guard lock(shard.Mutex);
+
+  shard.Rows->WriteNotes(playerUuid, notes);
+}
+
+
+bool BedrockWhiteList::Utils::ShardedBackend::LoadMeta(
+    const string& playerUuid,
+    PlayerMeta&   meta,
+    size_t        historyLimit
+) {
+  auto&           shard = *m_shards[ShardOf(playerUuid, m_shards.size())];
+  std::lock_guard lock(shard.Mutex);
+
+  return shard.Rows->LoadMeta(playerUuid, meta, historyLimit);
+}
+
+
+size_t BedrockWhiteList::Utils::ShardedBackend::Shards() const {
+  return m_shards.size();
+}
+
+
+ShardedBackend::Statistics BedrockWhiteList::Utils::ShardedBackend::GetStatistics(
+) const {
+  Statistics stats{m_shards.size(), {}, m_fanOuts.load(std::memory_order_relaxed)};
+
+  for (auto& shard : m_shards) {
+    stats.RowsWritten.push_back(shard->RowsWritten.load(std::memory_order_relaxed));
+  }
+
+  return stats;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Storage.h"
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// The tables holding the rows of a player, which always share a shard.
+constexpr std::array<const char*, 4> PLAYER_ROW_TABLES =
+    {"whitelist", "blacklist", "player_meta", "player_history"};
+
+constexpr size_t MAX_SHARDS = 64;
+
+
+// The shard of a player's rows. FNV-1a over the uuid text, so the layout on
+// disk does not depend on the compiler; bew_shard(uuid, shards) in SQL.
+uint32_t ShardOf(std::string_view playerUuid, size_t shards);
+
+// "<stem>.shard<shard>-of-<shards><extension>" next to databasePath.
+std::string
+ShardPath(const std::string& databasePath, size_t shard, size_t shards);
+
+// The files holding the player rows: databasePath itself with one shard.
+std::vector<std::string>
+RowDatabasePaths(const std::string& databasePath, size_t shards);
+
+// The shard count the rows are laid out in, from storage_layout.
+size_t StoredShardCount(SQLite::Database& database);
+void   StoreShardCount(SQLite::Database& database, size_t shards);
+
+// A shard file in WAL mode, migrated to the latest player schema.
+std::unique_ptr<SQLite::Database> OpenShardDatabase(const std::string& path);
+
+// Copies the rows of the players of shard (out of shards) from the database
+// at sourcePath into target, in one transaction; shards of 1 copies them
+// all. Returns the list rows copied.
+size_t CopyShardRows(
+    SQLite::Database&  target,
+    const std::string& sourcePath,
+    size_t             shard,
+    size_t             shards
+);
+
+
+struct RebalanceReport {
+  size_t  From;
+  size_t  To;
+  size_t  Rows;
+  int64_t DurationMillis;
+};
+
+/*
+ * Moves the player rows of the database at databasePath from the shard
+ * count stored in it to shards: every new shard is filled on a thread of
+ * its own from all the old ones, then the new count is stored and the old
+ * files are deleted. Nothing may write the rows meanwhile.
+ *
+ * A rebalance interrupted by a crash starts over on the next run, the old
+ * layout stays in use until the new count is stored. Shard files of other
+ * counts, left behind by one, are deleted.
+ */
+RebalanceReport RebalanceShards(
+    SQLite::Database&  database,
+    const std::string& databasePath,
+    size_t             shards
+);
+
+
+/*
+ * The lists spread over several SQLite files by ShardOf(uuid). Every shard
+ * has a connection and a writer thread of its own: a batch is split by
+ * shard and written by all writers at once, one transaction per shard, and
+ * list or name queries fan out to every shard the same way. A lookup by
+ * uuid runs on the calling thread against its one shard, on a read
+ * connection of its own that does not wait for the shard's writer.
+ *
+ * A batch is atomic per shard, not across shards.
+ */
+class ShardedBackend : public StorageBackend {
+  public:
+  struct Statistics {
+    size_t                Shards;
+    std::vector<uint64_t> RowsWritten; // per shard
+    uint64_t              FanOuts;
+  };
+
+  // Opens or creates the shard files of databasePath for shards.
+  ShardedBackend(const std::string& databasePath, size_t shards);
+  ~ShardedBackend() override;
+
+  public:
+  StorageKind Kind() const override;
+
+  bool FindByUuid(const std::string& playerUuid, PlayerInfo& info) override;
+  bool FindByName(const std::string& playerName, PlayerInfo& info) override;
+
+  std::vector<PlayerInfo> ListByStatus(PlayerStatus status) override;
+
+  // Shard after shard on the calling thread, the visitor is not shared.
+  void ForEach(const Visitor& visitor, bool withAutoRecorded) override;
+
+  void WriteBatch(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos
+  ) override;
+
+  void WriteBatchWithHistory(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos,
+      const std::vector<PlayerInfo>& history,
+      const std::string&             actor,
+      const std::string&             reason,
+      int64_t                        time,
+      const Committed&               committed
+  ) override;
+
+  void WriteNotes(const std::string& playerUuid, const std::string& notes) override;
+
+  bool LoadMeta(const std::string& playerUuid, PlayerMeta& meta, size_t historyLimit)
+      override;
+
+  size_t     Shards() const;
+  Statistics GetStatistics() const;
+
+  private:
+  struct Shard {
+    std::mutex                     Mutex;
+    std::unique_ptr<SQLiteBackend> Rows;
+    std::unique_ptr<SQLiteBackend> Lookups; // read-only, WAL
+    SerialExecutor                 Writer;
+    std::atomic<uint64_t>          RowsWritten{0};
+  };
+
+  // Runs job(shard) on the writer of every shard job is given for and waits
+  // for all of them; the exception of the lowest shard is thrown again.
+  void FanOut(const std::vector<size_t>& shards, const std::function<void(size_t)>& job);
+
+  // The indices of batch, per shard.
+  std::vector<std::vector<size_t>> Split(const std::vector<PlayerInfo>& batch) const;
+
+  private:
+  std::vector<std::unique_ptr<Shard>> m_shards{};
+  std::atomic<uint64_t>               m_fanOuts{0};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
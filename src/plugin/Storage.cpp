@@ -0,0 +1,645 @@
+#include "plugin/Storage.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <random>
+
+using std::string, std::vector;
+
+using BedrockWhiteList::Utils::PlayerInfo;
+
+
+// - - - - - - - - - - - - - - - - - Users - - - - - - - - - - - - - - - - -
+
+
+BedrockWhiteList::Utils::PlayerInfo::PlayerInfo() {
+  *this = PlayerInfo(Utils::Whitelist, "", "", 0);
+}
+
+
+BedrockWhiteList::Utils::PlayerInfo::PlayerInfo(
+    Utils::PlayerStatus playerStatus,
+    string              playerName,
+    string              playerUuid,
+    TimeUnix            lastTime
+) {
+  PlayerStatus = playerStatus;
+  PlayerUuid   = playerUuid;
+  PlayerName   = playerName;
+  LastTime     = lastTime;
+}
+
+
+bool BedrockWhiteList::Utils::PlayerInfo::Empty() const {
+  return PlayerName.empty() or PlayerUuid.empty() or LastTime.Empty();
+}
+
+
+// -1 is forever and 0 no time at all.
+bool BedrockWhiteList::Utils::PlayerInfo::Expired(int64_t now) const {
+  return PlayerStatus == Blacklist and 0 < LastTime.Time
+     and LastTime.Time <= now;
+}
+
+
+void BedrockWhiteList::Utils::PlayerInfo::operator=(PlayerInfo info) {
+  this->PlayerStatus = info.PlayerStatus;
+  this->PlayerUuid   = info.PlayerUuid;
+  this->PlayerName   = info.PlayerName;
+  this->LastTime     = info.LastTime;
+  this->Flags        = info.Flags;
+  this->RecordedTime = info.RecordedTime;
+}
+
+
+BedrockWhiteList::Utils::TimeUnix::TimeUnix() { Time = -1; }
+
+
+BedrockWhiteList::Utils::TimeUnix::TimeUnix(time_t time) { Time = time; }
+
+
+bool BedrockWhiteList::Utils::TimeUnix::Empty() const { return this->Time == 0; }
+
+
+// The local date of a time and the UTC offset it is in, looked up once per
+// quarter of an hour of UTC; offsets only change on such a boundary.
+struct DatePrefix {
+  int64_t Quarter{-1};
+  int64_t Offset{0};
+  int64_t Day{-1}; // local days since the epoch
+  char    Text[11]{};
+};
+
+
+static thread_local DatePrefix g_datePrefix{};
+
+
+inline static void PutDigits(char* out, int64_t value, int digits) {
+  for (int i = digits - 1; 0 <= i; i--, value /= 10) {
+    out[i] = static_cast<char>('0' + value % 10);
+  }
+}
+
+
+// "YYYY-MM-DD HH:MM:SS" in local time, empty for forever and no time.
+string BedrockWhiteList::Utils::TimeUnix::ToString() {
+  using namespace std::chrono;
+
+  if (Time <= 0) {
+    return string();
+  }
+
+  auto& prefix = g_datePrefix;
+
+  if (const auto quarter = static_cast<int64_t>(Time) / 900;
+      quarter != prefix.Quarter) {
+    const auto tm   = fmt::localtime(Time);
+    const auto date = sys_days{
+        year{tm.tm_year + 1900} / month{static_cast<unsigned>(tm.tm_mon + 1)}
+        / day{static_cast<unsigned>(tm.tm_mday)}
+    };
+
+    prefix.Quarter = quarter;
+    prefix.Offset  = date.time_since_epoch().count() * 86400ll
+                  + tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec - Time;
+  }
+
+  const auto local = static_cast<int64_t>(Time) + prefix.Offset;
+  const auto today = local / 86400;
+
+  if (today != prefix.Day) {
+    const year_month_day date{sys_days{days{today}}};
+
+    prefix.Day = today;
+    PutDigits(prefix.Text, static_cast<int>(date.year()), 4);
+    prefix.Text[4] = '-';
+    PutDigits(prefix.Text + 5, static_cast<unsigned>(date.month()), 2);
+    prefix.Text[7] = '-';
+    PutDigits(prefix.Text + 8, static_cast<unsigned>(date.day()), 2);
+    prefix.Text[10] = ' ';
+  }
+
+  const auto second = local % 86400;
+
+  char text[19];
+  std::copy(prefix.Text, prefix.Text + 11, text);
+  PutDigits(text + 11, second / 3600, 2);
+  text[13] = ':';
+  PutDigits(text + 14, second / 60 % 60, 2);
+  text[16] = ':';
+  PutDigits(text + 17, second % 60, 2);
+
+  return string(text, sizeof(text));
+}
+
+
+bool BedrockWhiteList::Utils::TimeUnix::operator==(long long cmpTime) {
+  return Time == cmpTime;
+}
+
+
+long long BedrockWhiteList::Utils::TimeUnix::operator=(long long llTime) {
+  return Time = llTime;
+}
+
+
+// - - - - - - - - - - - - - - - - Backends - - - - - - - - - - - - - - - -
+
+
+BedrockWhiteList::Utils::StorageKind
+BedrockWhiteList::Utils::ParseStorageKind(const string& name) {
+  if (name == "leveldb") {
+    return KeyValueStorage;
+  }
+
+  return SQLiteStorage;
+}
+
+
+string BedrockWhiteList::Utils::StorageKindName(StorageKind kind) {
+  return kind == KeyValueStorage ? "leveldb" : "sqlite";
+}
+
+
+// - - - - - - SQLite - - - - - -
+
+
+// Both lists in one shape; the whitelist has no flags.
+constexpr auto SQLITE_PLAYER_COLUMNS =
+    "SELECT 0, player_uuid, player_name, player_last_time, 0, 0 "
+    "FROM whitelist {0} UNION ALL "
+    "SELECT 1, player_uuid, player_name, player_last_time, player_flags, "
+    "player_recorded_time FROM blacklist {1}";
+
+
+inline static PlayerInfo ReadPlayerRow(SQLite::Statement& row) {
+  PlayerInfo info{};
+  info.PlayerStatus = row.getColumn(0).getInt() == 0
+                        ? BedrockWhiteList::Utils::Whitelist
+                        : BedrockWhiteList::Utils::Blacklist;
+  info.PlayerUuid   = row.getColumn(1).getString();
+  info.PlayerName   = row.getColumn(2).getString();
+  info.LastTime     = row.getColumn(3).getInt64();
+  info.Flags        = row.getColumn(4).getInt();
+  info.RecordedTime = row.getColumn(5).getInt64();
+  return info;
+}
+
+
+BedrockWhiteList::Utils::SQLiteBackend::SQLiteBackend(SQLite::Database& database)
+: m_database(database) {}
+
+
+BedrockWhiteList::Utils::SQLiteBackend::SQLiteBackend(
+    std::unique_ptr<SQLite::Database> database
+)
+: m_ownedDatabase(std::move(database)),
+  m_database(*m_ownedDatabase) {}
+
+
+BedrockWhiteList::Utils::StorageKind
+BedrockWhiteList::Utils::SQLiteBackend::Kind() const {
+  return SQLiteStorage;
+}
+
+
+bool BedrockWhiteList::Utils::SQLiteBackend::FindBy(
+    std::unique_ptr<SQLite::Statement>& query,
+    const char*                         column,
+    const string&                       value,
+    PlayerInfo&                         info
+) {
+  // The whitelist row comes first, as it did with two separate queries.
+  if (query == nullptr) {
+    const auto where = fmt::format("WHERE {0} = ?1 ", column);
+
+    query = std::make_unique<SQLite::Statement>(
+        m_database,
+        fmt::format(fmt::runtime(SQLITE_PLAYER_COLUMNS), where, where)
+    );
+  }
+
+  query->bind(1, value);
+
+  const auto found = query->executeStep();
+  if (found) {
+    info = ReadPlayerRow(*query);
+  }
+
+  query->reset();
+  return found;
+}
+
+
+bool BedrockWhiteList::Utils::SQLiteBackend::FindByUuid(
+    const string& playerUuid,
+    PlayerInfo&   info
+) {
+  std::lock_guard lock(m_mutex);
+  return FindBy(m_findByUuid, "player_uuid", playerUuid, info);
+}
+
+
+bool BedrockWhiteList::Utils::SQLiteBackend::FindByName(
+    const string& playerName,
+    PlayerInfo&   info
+) {
+  std::lock_guard lock(m_mutex);
+  return FindBy(m_findByName, "player_name", playerName, info);
+}
+
+
+vector<PlayerInfo>
+BedrockWhiteList::Utils::SQLiteBackend::ListByStatus(PlayerStatus status) {
+  vector<PlayerInfo> infoList{};
+
+  ForEach(
+      [&](const PlayerInfo& info) {
+        if (info.PlayerStatus == status) {
+          infoList.push_back(info);
+        }
+        return true;
+      },
+      true
+  );
+
+  return infoList;
+}
+
+
+void BedrockWhiteList::Utils::SQLiteBackend::ForEach(
+    const Visitor& visitor,
+    bool           withAutoRecorded
+) {
+  std::lock_guard   lock(m_mutex);
+  SQLite::Statement query(
+      m_database,
+      fmt::format(
+          fmt::runtime(SQLITE_PLAYER_COLUMNS),
+          "",
+          withAutoRecorded ? "" : "WHERE player_flags != 1"
+      )
+  );
+
+  while (query.executeStep()) {
+    if (not visitor(ReadPlayerRow(query))) {
+      return;
+    }
+  }
+}
+
+
+// One transaction and one set of prepared statements for the whole batch, so
+// the cost is a single commit rather than one per player.
+//
+// The transaction takes the write lock up front: it reads the old rows
+// before writing, and a deferred one would then fail at once with
+// SQLITE_BUSY if a background writer committed in between, the busy timeout
+// only covers waiting for the lock, not a snapshot gone stale.
+void BedrockWhiteList::Utils::SQLiteBackend::WriteBatch(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos
+) {
+  std::lock_guard     lock(m_mutex);
+  SQLite::Transaction transaction(
+      m_database,
+      SQLite::TransactionBehavior::IMMEDIATE
+  );
+
+  PutRows(batch, oldInfos);
+
+  transaction.commit();
+}
+
+
+void BedrockWhiteList::Utils::SQLiteBackend::WriteBatchWithHistory(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos,
+    const vector<PlayerInfo>& history,
+    const string&             actor,
+    const string&             reason,
+    int64_t                   time,
+    const Committed&          committed
+) {
+  std::lock_guard     lock(m_mutex);
+  SQLite::Transaction transaction(
+      m_database,
+      SQLite::TransactionBehavior::IMMEDIATE
+  );
+
+  // The caller's oldInfos may already hold rows, the callback gets this
+  // batch's only.
+  vector<PlayerInfo> olds{};
+  PutRows(batch, oldInfos != nullptr ? &olds : nullptr);
+  if (not history.empty()) {
+    PutHistory(history, actor, reason, time);
+  }
+
+  transaction.commit();
+
+  if (committed) {
+    committed(batch, olds);
+  }
+
+  if (oldInfos != nullptr) {
+    oldInfos->insert(oldInfos->end(), olds.begin(), olds.end());
+  }
+}
+
+
+void BedrockWhiteList::Utils::SQLiteBackend::PutRows(
+    const vector<PlayerInfo>& batch,
+    vector<PlayerInfo>*       oldInfos
+) {
+  const auto recordedTime = static_cast<long long>(std::time(nullptr));
+
+  SQLite::Statement selectOld(
+      m_database,
+      fmt::format(
+          fmt::runtime(SQLITE_PLAYER_COLUMNS),
+          "WHERE player_uuid = ?1",
+          "WHERE player_uuid = ?1"
+      )
+  );
+
+  std::array<SQLite::Statement, 2> upsert{
+      SQLite::Statement(
+          m_database,
+          "INSERT INTO whitelist(player_uuid, player_name, player_last_time) "
+          "VALUES(?1, ?2, ?3) ON CONFLICT(player_uuid) "
+          "DO UPDATE SET player_name = ?2, player_last_time = ?3"
+      ),
+      SQLite::Statement(
+          m_database,
+          "INSERT INTO blacklist(player_uuid, player_name, player_last_time, "
+          "player_flags, player_recorded_time) "
+          "VALUES(?1, ?2, ?3, ?4, ?5) ON CONFLICT(player_uuid) "
+          "DO UPDATE SET player_name = ?2, player_last_time = ?3, "
+          "player_flags = ?4"
+      )
+  };
+
+  // A player lives in one list at a time.
+  std::array<SQLite::Statement, 2> remove{
+      SQLite::Statement(m_database, "DELETE FROM whitelist WHERE player_uuid = ?"),
+      SQLite::Statement(m_database, "DELETE FROM blacklist WHERE player_uuid = ?")
+  };
+
+
+  for (auto& playerInfo : batch) {
+    const auto target = playerInfo.PlayerStatus == Whitelist ? 0 : 1;
+
+    if (oldInfos != nullptr) {
+      selectOld.bind(1, playerInfo.PlayerUuid);
+      oldInfos->push_back(
+          selectOld.executeStep() ? ReadPlayerRow(selectOld) : PlayerInfo{}
+      );
+      selectOld.reset();
+    }
+
+    remove[1 - target].bind(1, playerInfo.PlayerUuid);
+    remove[1 - target].exec();
+    remove[1 - target].reset();
+
+    upsert[target].bind(1, playerInfo.PlayerUuid);
+    upsert[target].bind(2, playerInfo.PlayerName);
+    upsert[target].bind(3, static_cast<long long>(playerInfo.LastTime.Time));
+    if (target == 1) {
+      upsert[target].bind(4, playerInfo.Flags);
+      upsert[target].bind(
+          5,
+          playerInfo.RecordedTime != 0
+              ? static_cast<long long>(playerInfo.RecordedTime)
+              : recordedTime
+      );
+    }
+    upsert[target].exec();
+    upsert[target].reset();
+  }
+}
+
+
+// The metadata tables are written and read by commands only, one statement
+// each is not worth caching.
+void BedrockWhiteList::Utils::SQLiteBackend::PutHistory(
+    const vector<PlayerInfo>& history,
+    const string&             actor,
+    const string&             reason,
+    int64_t                   time
+) {
+  SQLite::Statement append(
+      m_database,
+      "INSERT INTO player_history(player_uuid, history_time, history_actor, "
+      "history_status, history_last_time, history_reason) "
+      "VALUES(?1, ?2, ?3, ?4, ?5, ?6)"
+  );
+  SQLite::Statement upsert(
+      m_database,
+      "INSERT INTO player_meta(player_uuid, meta_reason, meta_issuer, "
+      "meta_updated_time) VALUES(?1, ?2, ?3, ?4) ON CONFLICT(player_uuid) "
+      "DO UPDATE SET meta_reason = ?2, meta_issuer = ?3, meta_updated_time = ?4"
+  );
+
+  for (auto& playerInfo : history) {
+    append.bind(1, playerInfo.PlayerUuid);
+    append.bind(2, static_cast<long long>(time));
+    append.bind(3, actor);
+    append.bind(4, static_cast<int>(playerInfo.PlayerStatus));
+    append.bind(5, static_cast<long long>(playerInfo.LastTime.Time));
+    append.bind(6, reason);
+    append.exec();
+    append.reset();
+
+    upsert.bind(1, playerInfo.PlayerUuid);
+    upsert.bind(2, reason);
+    upsert.bind(3, actor);
+    upsert.bind(4, static_cast<long long>(time));
+    upsert.exec();
+    upsert.reset();
+  }
+}
+
+
+void BedrockWhiteList::Utils::SQLiteBackend::WriteNotes(
+    const string& playerUuid,
+    const string& notes
+) {
+  std::lock_guard   lock(m_mutex);
+  SQLite::Statement upsert(
+      m_database,
+      "INSERT INTO player_meta(player_uuid, meta_notes, meta_updated_time) "
+      "VALUES(?1, ?2, ?3) ON CONFLICT(player_uuid) "
+      "DO UPDATE SET meta_notes = ?2, meta_updated_time = ?3"
+  );
+
+  upsert.bind(1, playerUuid);
+  upsert.bind(2, notes);
+  upsert.bind(3, static_cast<long long>(std::time(nullptr)));
+  upsert.exec();
+}
+
+
+bool BedrockWhiteList::Utils::SQLiteBackend::LoadMeta(
+    const string& playerUuid,
+    PlayerMeta&   meta,
+    size_t        historyLimit
+) {
+  std::lock_guard lock(m_mutex);
+  bool            found{false};
+
+  SQLite::Statement current(
+      m_database,
+      "SELECT meta_reason, meta_issuer, meta_notes, meta_updated_time "
+      "FROM player_meta WHERE player_uuid = ?"
+  );
+  current.bind(1, playerUuid);
+
+  if (current.executeStep()) {
+    meta.Reason      = current.getColumn(0).getString();
+    meta.Issuer      = current.getColumn(1).getString();
+    meta.Notes       = current.getColumn(2).getString();
+    meta.UpdatedTime = current.getColumn(3).getInt64();
+    found            = true;
+  }
+
+
+  SQLite::Statement history(
+      m_database,
+      "SELECT history_time, history_actor, history_status, history_last_time, "
+      "history_reason FROM player_history WHERE player_uuid = ?1 "
+      "ORDER BY history_id DESC LIMIT ?2"
+  );
+  history.bind(1, playerUuid);
+  history.bind(2, static_cast<long long>(historyLimit));
+
+  meta.History.clear();
+  while (history.executeStep()) {
+    meta.History.push_back(
+        {history.getColumn(0).getInt64(),
+         history.getColumn(1).getString(),
+         history.getColumn(2).getInt() == 0 ? Whitelist : Blacklist,
+         history.getColumn(3).getInt64(),
+         history.getColumn(4).getString()}
+    );
+  }
+
+  return found or not meta.History.empty();
+}
+
+
+// - - - - - - - - - - - - - - - - Tooling - - - - - - - - - - - - - - - - -
+
+
+size_t BedrockWhiteList::Utils::CopyStorage(
+    StorageBackend&                                        source,
+    StorageBackend&                                        target,
+    size_t                                                 batchSize,
+    const std::function<void(const vector<PlayerInfo>&)>& onBatch
+) {
+  vector<PlayerInfo> batch{};
+  size_t             count{0};
+
+  batch.reserve(batchSize);
+
+  const auto flush = [&]() {
+    if (batch.empty()) {
+      return;
+    }
+
+    target.WriteBatch(batch, nullptr);
+    if (onBatch) {
+      onBatch(batch);
+    }
+
+    count += batch.size();
+    batch.clear();
+  };
+
+  source.ForEach(
+      [&](const PlayerInfo& info) {
+        batch.push_back(info);
+        if (batch.size() >= batchSize) {
+          flush();
+        }
+        return true;
+      },
+      true
+  );
+  flush();
+
+  return count;
+}
+
+
+inline static string BenchmarkUuid(uint64_t seed) {
+  return fmt::format(
+      "{0:08x}-{1:04x}-4{2:03x}-8{3:03x}-{4:012x}",
+      static_cast<uint32_t>(seed * 2654435761u),
+      static_cast<uint32_t>(seed >> 16) & 0xFFFF,
+      static_cast<uint32_t>(seed >> 8) & 0xFFF,
+      static_cast<uint32_t>(seed) & 0xFFF,
+      seed
+  );
+}
+
+
+BedrockWhiteList::Utils::StorageBenchmark BedrockWhiteList::Utils::BenchmarkStorage(
+    StorageBackend& backend,
+    size_t          rows,
+    size_t          batchSize
+) {
+  using namespace std::chrono;
+
+  StorageBenchmark result{rows, 0, 0, 0, 0};
+  std::mt19937_64  random(rows);
+
+  const auto elapsed = [](steady_clock::time_point since) {
+    return duration_cast<microseconds>(steady_clock::now() - since).count();
+  };
+
+
+  // Mostly newcomers, as on a public server.
+  auto               startTime = steady_clock::now();
+  vector<PlayerInfo> batch{};
+
+  for (size_t i = 0; i < rows; i++) {
+    PlayerInfo info(
+        i % 10 == 0 ? Whitelist : Blacklist,
+        fmt::format("bench{0}", i),
+        BenchmarkUuid(i),
+        -1
+    );
+    info.Flags = info.PlayerStatus == Blacklist ? AutoRecorded : 0;
+    batch.push_back(info);
+
+    if (batch.size() >= batchSize or i + 1 == rows) {
+      backend.WriteBatch(batch, nullptr);
+      batch.clear();
+    }
+  }
+  result.WriteMicros = elapsed(startTime);
+
+
+  PlayerInfo info{};
+
+  startTime = steady_clock::now();
+  for (size_t i = 0; i < rows; i++) {
+    backend.FindByUuid(BenchmarkUuid(random() % rows), info);
+  }
+  result.LookupMicros = elapsed(startTime);
+
+  startTime = steady_clock::now();
+  for (size_t i = 0; i < rows; i++) {
+    backend.FindByUuid(BenchmarkUuid(rows + random() % rows), info);
+  }
+  result.MissMicros = elapsed(startTime);
+
+  startTime = steady_clock::now();
+  backend.ForEach([](const PlayerInfo&) { return true; }, true);
+  result.ScanMicros = elapsed(startTime);
+
+  return result;
+}
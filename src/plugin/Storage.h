@@ -0,0 +1,273 @@
+#pragma once
+
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// Users
+
+
+struct TimeUnix {
+  TimeUnix();
+  TimeUnix(time_t);
+
+  time_t Time;
+
+  bool        Empty() const;
+  std::string ToString();
+
+  bool      operator==(long long cmpTime);
+  long long operator=(long long llTime);
+};
+
+
+typedef enum __tagPlayerStatus { Whitelist, Blacklist } PlayerStatus;
+
+
+// Stored in blacklist.player_flags.
+typedef enum __tagPlayerFlag { AutoRecorded = 1 } PlayerFlag;
+
+
+struct PlayerInfo {
+  PlayerInfo();
+  PlayerInfo(
+      Utils::PlayerStatus playerStatus,
+      std::string         playerName,
+      std::string         playerUuid,
+      TimeUnix            lastTime
+  );
+
+  Utils::PlayerStatus PlayerStatus;
+  std::string         PlayerName;
+  std::string         PlayerUuid;
+  TimeUnix            LastTime;
+  int                 Flags{0};
+
+  // When a blacklist row was first written, 0 means now.
+  int64_t RecordedTime{0};
+
+  bool Empty() const;
+
+  // A timed ban that has run out by now. The row stays until the next
+  // write, but the player is on neither list any more.
+  bool Expired(int64_t now) const;
+
+  void operator=(PlayerInfo info);
+};
+
+
+// One listing of a player, as kept in its history.
+struct BanRecord {
+  int64_t             Time;
+  std::string         Actor;
+  Utils::PlayerStatus Status;
+  int64_t             LastTime;
+  std::string         Reason;
+};
+
+
+/*
+ * The cold side of a player: why and by whom it was listed. Stored apart
+ * from the list rows and read only by commands, so the rows and verdicts
+ * the connect listener reads stay the same size however much is written
+ * here.
+ */
+struct PlayerMeta {
+  std::string            Reason;
+  std::string            Issuer;
+  std::string            Notes;
+  int64_t                UpdatedTime{0};
+  std::vector<BanRecord> History;
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - -
+
+
+// Which StorageBackend holds the player lists.
+typedef enum __tagStorageKind { SQLiteStorage, KeyValueStorage } StorageKind;
+
+StorageKind ParseStorageKind(const std::string& name);
+std::string StorageKindName(StorageKind kind);
+
+
+/*
+ * Where PlayerDB keeps the lists. PlayerDB adds the verdict cache and the
+ * journal on top; a backend only reads and writes rows.
+ *
+ * A player is in one list at a time, WriteBatch moves it out of the other.
+ *
+ * Backends are safe to call from several threads; each locks no more than
+ * the rows a call touches, so lookups need not wait for unrelated writes.
+ */
+class StorageBackend {
+  public:
+  typedef std::function<bool(const PlayerInfo&)> Visitor;
+
+  // Gets a committed part of a batch and the old rows of it, empty unless
+  // they were asked for, under the lock that orders writes of those players.
+  typedef std::function<
+      void(const std::vector<PlayerInfo>& part, const std::vector<PlayerInfo>& oldInfos)>
+      Committed;
+
+  virtual ~StorageBackend() = default;
+
+  public:
+  virtual StorageKind Kind() const = 0;
+
+  virtual bool FindByUuid(const std::string& playerUuid, PlayerInfo& info) = 0;
+  virtual bool FindByName(const std::string& playerName, PlayerInfo& info) = 0;
+
+  virtual std::vector<PlayerInfo> ListByStatus(PlayerStatus status) = 0;
+
+  // Stops when the visitor returns false. Auto-recorded newcomers are left
+  // out unless asked for, they are the bulk of the blacklist.
+  virtual void ForEach(const Visitor& visitor, bool withAutoRecorded) = 0;
+
+  // oldInfos, when given, receives the previous row of every player, empty
+  // for players not stored before.
+  virtual void WriteBatch(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos
+  ) = 0;
+
+  // WriteBatch, and in the same transaction a history record for every
+  // player of history, with actor and reason made its current issuer and
+  // reason. A crash keeps both or neither. committed, when set, sees every
+  // part as it is committed, before any later write of its players.
+  virtual void WriteBatchWithHistory(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos,
+      const std::vector<PlayerInfo>& history,
+      const std::string&             actor,
+      const std::string&             reason,
+      int64_t                        time,
+      const Committed&               committed
+  ) = 0;
+
+  virtual void WriteNotes(const std::string& playerUuid, const std::string& notes) = 0;
+
+  // History newest first, at most historyLimit records. False when nothing
+  // was ever recorded for the player.
+  virtual bool
+  LoadMeta(const std::string& playerUuid, PlayerMeta& meta, size_t historyLimit) = 0;
+};
+
+
+/*
+ * The lists as the whitelist and blacklist tables, on a connection migrated
+ * to PLAYER_SCHEMA_BASELINE.
+ */
+class SQLiteBackend : public StorageBackend {
+  public:
+  explicit SQLiteBackend(SQLite::Database& database);
+  explicit SQLiteBackend(std::unique_ptr<SQLite::Database> database);
+
+  public:
+  StorageKind Kind() const override;
+
+  bool FindByUuid(const std::string& playerUuid, PlayerInfo& info) override;
+  bool FindByName(const std::string& playerName, PlayerInfo& info) override;
+
+  std::vector<PlayerInfo> ListByStatus(PlayerStatus status) override;
+
+  void ForEach(const Visitor& visitor, bool withAutoRecorded) override;
+
+  void WriteBatch(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos
+  ) override;
+
+  void WriteBatchWithHistory(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos,
+      const std::vector<PlayerInfo>& history,
+      const std::string&             actor,
+      const std::string&             reason,
+      int64_t                        time,
+      const Committed&               committed
+  ) override;
+
+  void WriteNotes(const std::string& playerUuid, const std::string& notes) override;
+
+  bool LoadMeta(const std::string& playerUuid, PlayerMeta& meta, size_t historyLimit)
+      override;
+
+  private:
+  bool FindBy(
+      std::unique_ptr<SQLite::Statement>& query,
+      const char*                         column,
+      const std::string&                  value,
+      PlayerInfo&                         info
+  );
+
+  // The statements of WriteBatch and WriteBatchWithHistory, run in the
+  // transaction of the caller.
+  void PutRows(
+      const std::vector<PlayerInfo>& batch,
+      std::vector<PlayerInfo>*       oldInfos
+  );
+  void PutHistory(
+      const std::vector<PlayerInfo>& history,
+      const std::string&             actor,
+      const std::string&             reason,
+      int64_t                        time
+  );
+
+  private:
+  std::unique_ptr<SQLite::Database> m_ownedDatabase{};
+  SQLite::Database&                 m_database;
+
+  // One connection, and statements cached on it: calls take turns.
+  std::mutex m_mutex;
+
+  // Prepared on first use, the connect listener looks up every join.
+  std::unique_ptr<SQLite::Statement> m_findByUuid{};
+  std::unique_ptr<SQLite::Statement> m_findByName{};
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - -
+
+
+// Copies every row of source into target in batches, returns the row count.
+size_t CopyStorage(
+    StorageBackend&                                   source,
+    StorageBackend&                                   target,
+    size_t                                            batchSize,
+    const std::function<void(const std::vector<PlayerInfo>&)>& onBatch = {}
+);
+
+
+struct StorageBenchmark {
+  size_t  Rows;
+  int64_t WriteMicros;
+  int64_t LookupMicros;
+  int64_t MissMicros;
+  int64_t ScanMicros;
+};
+
+// Writes rows synthetic players in batches of batchSize, then looks up rows
+// random existing and rows unknown uuids and scans everything once.
+StorageBenchmark
+BenchmarkStorage(StorageBackend& backend, size_t rows, size_t batchSize);
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
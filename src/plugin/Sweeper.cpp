@@ -0,0 +1,192 @@
+#include "plugin/Sweeper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Shards.h"
+
+using std::vector;
+
+using namespace std::chrono;
+
+
+constexpr long long SWEEP_MIN_WINDOW = 64;
+constexpr long long SWEEP_MAX_WINDOW = 65536;
+
+
+BedrockWhiteList::Utils::RetentionSweeper::RetentionSweeper(Options options)
+: m_options(std::move(options)) {}
+
+
+BedrockWhiteList::Utils::RetentionSweeper::~RetentionSweeper() { Stop(); }
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::Start() {
+  if (m_task != nullptr) {
+    return;
+  }
+
+  m_task = std::make_unique<PeriodicTask>(
+      seconds(m_options.interval),
+      [this](PeriodicTask& task) { Pass(task); }
+  );
+  m_task->SetErrorHandler(m_onError);
+  m_task->Start();
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::Stop() {
+  if (m_task != nullptr) {
+    m_task->Stop();
+    m_task.reset();
+  }
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::Trigger() {
+  if (m_task != nullptr) {
+    m_task->Trigger();
+  }
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::SetDeleteCallback(
+    DeleteCallback callback
+) {
+  m_onDelete = std::move(callback);
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::SetReportCallback(
+    ReportCallback callback
+) {
+  m_onReport = std::move(callback);
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::SetErrorCallback(
+    ErrorCallback callback
+) {
+  m_onError = std::move(callback);
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::Pass(PeriodicTask& task) {
+  const auto passStart = steady_clock::now();
+
+  PassReport report{};
+
+  for (auto& path : RowDatabasePaths(m_options.databasePath, m_options.shards)) {
+    if (task.IsStopping()) {
+      break;
+    }
+
+    Sweep(task, path, report);
+  }
+
+  report.DurationMillis = duration_cast<milliseconds>(steady_clock::now() - passStart).count();
+
+  if (m_onReport) {
+    m_onReport(report);
+  }
+}
+
+
+void BedrockWhiteList::Utils::RetentionSweeper::Sweep(
+    PeriodicTask&      task,
+    const std::string& path,
+    PassReport&        report
+) {
+  const auto slice  = microseconds(m_options.sliceMillis * 1000ll);
+  const auto cutoff = std::time(nullptr) - m_options.newcomerTtl;
+
+  // Its own connection, the main one stays free for the connect path.
+  SQLite::Database session(path, SQLite::OPEN_READWRITE, 1000);
+
+  SQLite::Statement maxRowid(session, "SELECT ifnull(max(rowid), 0) FROM blacklist");
+  maxRowid.executeStep();
+  const auto lastRowid = maxRowid.getColumn(0).getInt64();
+
+  SQLite::Statement remove(
+      session,
+      "DELETE FROM blacklist WHERE rowid > ?1 AND rowid <= ?2 "
+      "AND player_flags = 1 AND player_recorded_time < ?3 "
+      "RETURNING player_uuid, player_name, player_last_time"
+  );
+
+  long long           cursor{0};
+  long long           window = std::max<long long>(m_options.batchSize, SWEEP_MIN_WINDOW);
+  vector<SweptPlayer> swept{};
+
+  while (cursor < lastRowid and not task.IsStopping()) {
+    const auto sliceStart = steady_clock::now();
+
+    {
+      SQLite::Transaction transaction(session);
+
+      remove.bind(1, cursor);
+      remove.bind(2, cursor + window);
+      remove.bind(3, static_cast<long long>(cutoff));
+
+      while (remove.executeStep()) {
+        swept.push_back(
+            {remove.getColumn(0).getString(),
+             remove.getColumn(1).getString(),
+             remove.getColumn(2).getInt64()}
+        );
+      }
+      remove.reset();
+
+      transaction.commit();
+    }
+
+    const auto elapsed = duration_cast<microseconds>(steady_clock::now() - sliceStart);
+
+    cursor                    += window;
+    report.Slices++;
+    report.Deleted            += swept.size();
+    report.LongestSliceMicros  = std::max<int64_t>(report.LongestSliceMicros, elapsed.count());
+
+    if (not swept.empty()) {
+      if (m_onDelete) {
+        m_onDelete(swept);
+      }
+      swept.clear();
+    }
+
+    // Keep each write transaction inside the slice budget.
+    if (elapsed > slice) {
+      window = std::max(window / 2, SWEEP_MIN_WINDOW);
+    } else if (elapsed < slice / 2) {
+      window = std::min(window * 2, SWEEP_MAX_WINDOW);
+    }
+
+    task.Sleep(duration_cast<milliseconds>(slice * 2) + milliseconds(1));
+  }
+
+
+  // Without auto_vacuum = INCREMENTAL the freed pages are reused by new rows
+  // but the file only shrinks with a full VACUUM.
+  SQLite::Statement autoVacuum(session, "PRAGMA auto_vacuum");
+  autoVacuum.executeStep();
+  report.CanShrink = autoVacuum.getColumn(0).getInt() == 2;
+
+  while (report.CanShrink and not task.IsStopping()) {
+    SQLite::Statement freePages(session, "PRAGMA freelist_count");
+    freePages.executeStep();
+    const auto count = freePages.getColumn(0).getInt64();
+
+    if (count == 0) {
+      break;
+    }
+
+    const auto pages = std::min<long long>(count, m_options.vacuumPages);
+    session.exec("PRAGMA incremental_vacuum(" + std::to_string(pages) + ");");
+    report.VacuumedPages += pages;
+
+    task.Sleep(duration_cast<milliseconds>(slice * 2) + milliseconds(1));
+  }
+}
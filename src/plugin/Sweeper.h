@@ -0,0 +1,90 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "plugin/Worker.h"
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+struct SweptPlayer {
+  std::string PlayerUuid;
+  std::string PlayerName;
+  int64_t     LastTime;
+};
+
+
+/*
+ * Deletes auto-recorded newcomers older than the TTL from the blacklist.
+ *
+ * A pass walks the table by rowid in windows, one short DELETE transaction
+ * each, and resizes the window so a transaction stays within sliceMillis.
+ * It pauses between windows to let other writers in, then gives free pages
+ * back to the file with incremental vacuum when the database supports it.
+ * With the rows sharded, a pass sweeps the shard files one after another.
+ */
+class RetentionSweeper {
+  public:
+  struct Options {
+    std::string databasePath{};
+    size_t      shards{1}; // of the player rows
+    int64_t     newcomerTtl{7 * 24 * 3600};
+    int64_t     interval{600};
+    int         batchSize{500};
+    int         sliceMillis{5};
+    int         vacuumPages{128};
+  };
+
+  struct PassReport {
+    uint64_t Deleted;
+    uint64_t Slices;
+    uint64_t VacuumedPages;
+    int64_t  DurationMillis;
+    int64_t  LongestSliceMicros;
+    bool     CanShrink;
+  };
+
+  typedef std::function<void(const std::vector<SweptPlayer>&)> DeleteCallback;
+  typedef std::function<void(const PassReport&)>               ReportCallback;
+  typedef PeriodicTask::ErrorHandler                           ErrorCallback;
+
+  explicit RetentionSweeper(Options options);
+  ~RetentionSweeper();
+
+  public:
+  void Start();
+  void Stop();
+  void Trigger();
+
+  // Called on the sweeper thread after each committed window.
+  void SetDeleteCallback(DeleteCallback callback);
+  void SetReportCallback(ReportCallback callback);
+  void SetErrorCallback(ErrorCallback callback);
+
+  private:
+  void Pass(PeriodicTask& task);
+  void Sweep(PeriodicTask& task, const std::string& path, PassReport& report);
+
+  private:
+  Options                       m_options;
+  DeleteCallback                m_onDelete{};
+  ReportCallback                m_onReport{};
+  ErrorCallback                 m_onError{};
+  std::unique_ptr<PeriodicTask> m_task{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,58 @@
+#include "plugin/VerdictCache.h"
+
+#include <mutex>
+
+
+bool BedrockWhiteList::Utils::VerdictCache::Get(
+    const std::string& playerUuid,
+    Verdict&           verdict
+) const {
+  std::shared_lock lock(m_mutex);
+
+  const auto it = m_verdicts.find(playerUuid);
+  if (it == m_verdicts.end()) {
+    return false;
+  }
+
+  verdict = it->second;
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::VerdictCache::Put(
+    const std::string& playerUuid,
+    Verdict            verdict
+) {
+  std::unique_lock lock(m_mutex);
+  m_verdicts.insert_or_assign(playerUuid, verdict);
+}
+
+
+void BedrockWhiteList::Utils::VerdictCache::PutBatch(
+    const std::vector<std::pair<std::string, Verdict>>& verdicts
+) {
+  std::unique_lock lock(m_mutex);
+
+  for (auto& [playerUuid, verdict] : verdicts) {
+    m_verdicts.insert_or_assign(playerUuid, verdict);
+  }
+}
+
+
+void BedrockWhiteList::Utils::VerdictCache::Erase(const std::string& playerUuid
+) {
+  std::unique_lock lock(m_mutex);
+  m_verdicts.erase(playerUuid);
+}
+
+
+void BedrockWhiteList::Utils::VerdictCache::Reserve(size_t count) {
+  std::unique_lock lock(m_mutex);
+  m_verdicts.reserve(count);
+}
+
+
+size_t BedrockWhiteList::Utils::VerdictCache::Size() const {
+  std::shared_lock lock(m_mutex);
+  return m_verdicts.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+struct Verdict {
+  uint8_t Status;
+  int64_t LastTime;
+};
+
+
+/*
+ * Last known verdict of every player, keyed by uuid.
+ *
+ * Filled by the startup preload and kept in step by PlayerDB writes, so the
+ * plugin has an answer for a player even while the database cannot give one.
+ */
+class VerdictCache {
+  public:
+  bool Get(const std::string& playerUuid, Verdict& verdict) const;
+  void Put(const std::string& playerUuid, Verdict verdict);
+  void Erase(const std::string& playerUuid);
+
+  // Takes the lock once for the whole batch.
+  void PutBatch(const std::vector<std::pair<std::string, Verdict>>& verdicts);
+
+  void   Reserve(size_t count);
+  size_t Size() const;
+
+  private:
+  mutable std::shared_mutex                m_mutex;
+  std::unordered_map<std::string, Verdict> m_verdicts{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
@@ -0,0 +1,66 @@
+#include "plugin/Warmup.h"
+
+
+BedrockWhiteList::Utils::WarmupPolicy
+BedrockWhiteList::Utils::ParseWarmupPolicy(const std::string& name) {
+  if (name == "fail-open") {
+    return FailOpen;
+  }
+
+  if (name == "fail-closed") {
+    return FailClosed;
+  }
+
+  return Hold;
+}
+
+
+std::string BedrockWhiteList::Utils::WarmupPolicyName(WarmupPolicy policy) {
+  switch (policy) {
+  case FailOpen:
+    return "fail-open";
+  case FailClosed:
+    return "fail-closed";
+  default:
+    return "hold";
+  }
+}
+
+
+void BedrockWhiteList::Utils::ReadinessGate::Open() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_state = Ready;
+  }
+  m_cond.notify_all();
+}
+
+
+void BedrockWhiteList::Utils::ReadinessGate::Fail() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_state = Failed;
+  }
+  m_cond.notify_all();
+}
+
+
+BedrockWhiteList::Utils::ReadinessGate::State
+BedrockWhiteList::Utils::ReadinessGate::GetState() const {
+  std::lock_guard lock(m_mutex);
+  return m_state;
+}
+
+
+bool BedrockWhiteList::Utils::ReadinessGate::IsReady() const {
+  return GetState() == Ready;
+}
+
+
+bool BedrockWhiteList::Utils::ReadinessGate::WaitFor(
+    std::chrono::milliseconds timeout
+) const {
+  std::unique_lock lock(m_mutex);
+  m_cond.wait_for(lock, timeout, [this] { return m_state != Pending; });
+  return m_state == Ready;
+}
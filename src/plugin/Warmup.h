@@ -0,0 +1,50 @@
+#pragma once
+
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+// What the connect listener does with a player while warm-up is running.
+typedef enum __tagWarmupPolicy { Hold, FailOpen, FailClosed } WarmupPolicy;
+
+WarmupPolicy ParseWarmupPolicy(const std::string& name);
+std::string  WarmupPolicyName(WarmupPolicy policy);
+
+
+/*
+ * Opened by the warm-up thread once the database is usable. Failed when the
+ * warm-up threw, in which case it never opens.
+ */
+class ReadinessGate {
+  public:
+  typedef enum __tagState { Pending, Ready, Failed } State;
+
+  void Open();
+  void Fail();
+
+  State GetState() const;
+  bool  IsReady() const;
+
+  // Blocks until the gate leaves Pending or the timeout expires.
+  bool WaitFor(std::chrono::milliseconds timeout) const;
+
+  private:
+  mutable std::mutex              m_mutex;
+  mutable std::condition_variable m_cond;
+  State                           m_state{Pending};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
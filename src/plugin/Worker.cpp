@@ -0,0 +1,252 @@
+#include "plugin/Worker.h"
+
+#include <algorithm>
+
+
+BedrockWhiteList::Utils::PeriodicTask::PeriodicTask(
+    std::chrono::milliseconds interval,
+    Body                      body
+)
+: m_interval(interval),
+  m_body(std::move(body)) {}
+
+
+BedrockWhiteList::Utils::PeriodicTask::~PeriodicTask() { Stop(); }
+
+
+void BedrockWhiteList::Utils::PeriodicTask::Start() {
+  if (m_thread.joinable()) {
+    return;
+  }
+
+  m_stopping = false;
+  m_thread   = std::thread(&PeriodicTask::Loop, this);
+}
+
+
+void BedrockWhiteList::Utils::PeriodicTask::Stop() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cond.notify_all();
+
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+
+void BedrockWhiteList::Utils::PeriodicTask::Trigger() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_triggered = true;
+  }
+  m_cond.notify_all();
+}
+
+
+void BedrockWhiteList::Utils::PeriodicTask::SetErrorHandler(ErrorHandler handler
+) {
+  m_onError = std::move(handler);
+}
+
+
+bool BedrockWhiteList::Utils::PeriodicTask::IsStopping() const {
+  return m_stopping;
+}
+
+
+bool BedrockWhiteList::Utils::PeriodicTask::Sleep(
+    std::chrono::milliseconds duration
+) {
+  std::unique_lock lock(m_mutex);
+  m_cond.wait_for(lock, duration, [this] { return m_stopping.load(); });
+  return not m_stopping;
+}
+
+
+void BedrockWhiteList::Utils::PeriodicTask::Loop() {
+  while (true) {
+    {
+      std::unique_lock lock(m_mutex);
+      m_cond.wait_for(lock, m_interval, [this] {
+        return m_stopping.load() or m_triggered;
+      });
+
+      if (m_stopping) {
+        return;
+      }
+      m_triggered = false;
+    }
+
+    try {
+      m_body(*this);
+    } catch (std::exception& e) {
+      if (m_onError) {
+        m_onError(e);
+      }
+    }
+  }
+}
+
+
+// - - - - - - - - - - - - - - - - Executor - - - - - - - - - - - - - - - -
+
+
+BedrockWhiteList::Utils::SerialExecutor::SerialExecutor()
+: m_thread(&SerialExecutor::Loop, this) {}
+
+
+BedrockWhiteList::Utils::SerialExecutor::~SerialExecutor() { Stop(); }
+
+
+bool BedrockWhiteList::Utils::SerialExecutor::Post(Job job) {
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_stopping) {
+      return false;
+    }
+    m_jobs.push_back(std::move(job));
+  }
+  m_cond.notify_one();
+  return true;
+}
+
+
+void BedrockWhiteList::Utils::SerialExecutor::Stop() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cond.notify_all();
+
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+
+size_t BedrockWhiteList::Utils::SerialExecutor::Pending() const {
+  std::lock_guard lock(m_mutex);
+  return m_jobs.size();
+}
+
+
+void BedrockWhiteList::Utils::SerialExecutor::Loop() {
+  std::vector<Job> jobs{};
+
+  while (true) {
+    {
+      std::unique_lock lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_stopping or not m_jobs.empty(); });
+
+      if (m_jobs.empty()) {
+        return;
+      }
+      jobs.swap(m_jobs);
+    }
+
+    // A job reports its own errors, one throwing must not end the thread.
+    for (auto& job : jobs) {
+      try {
+        job();
+      } catch (...) {}
+    }
+    jobs.clear();
+  }
+}
+
+
+// - - - - - - - - - - - - - - - - - Pool - - - - - - - - - - - - - - - - -
+
+
+BedrockWhiteList::Utils::WorkerPool::WorkerPool(size_t threads) {
+  for (size_t i = 0; i < std::max<size_t>(threads, 1); i++) {
+    m_threads.emplace_back(&WorkerPool::Loop, this);
+  }
+}
+
+
+BedrockWhiteList::Utils::WorkerPool::~WorkerPool() { Stop(); }
+
+
+void BedrockWhiteList::Utils::WorkerPool::Post(Job job) {
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_stopping) {
+      return;
+    }
+    m_jobs.push_back(std::move(job));
+  }
+  m_cond.notify_one();
+}
+
+
+void BedrockWhiteList::Utils::WorkerPool::Stop() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_cond.notify_all();
+
+  for (auto& thread : m_threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+
+size_t BedrockWhiteList::Utils::WorkerPool::Threads() const {
+  return m_threads.size();
+}
+
+
+size_t BedrockWhiteList::Utils::WorkerPool::Pending() const {
+  std::lock_guard lock(m_mutex);
+  return m_jobs.size();
+}
+
+
+void BedrockWhiteList::Utils::WorkerPool::Loop() {
+  while (true) {
+    Job job{};
+    {
+      std::unique_lock lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_stopping or not m_jobs.empty(); });
+
+      if (m_jobs.empty()) {
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+
+    try {
+      job();
+    } catch (...) {}
+  }
+}
+
+
+// - - - - - - - - - - - - - - - Main thread - - - - - - - - - - - - - - -
+
+
+void BedrockWhiteList::Utils::MainThreadQueue::Post(Job job) {
+  std::lock_guard lock(m_mutex);
+  m_jobs.push_back(std::move(job));
+}
+
+
+void BedrockWhiteList::Utils::MainThreadQueue::Drain() {
+  std::vector<Job> jobs{};
+  {
+    std::lock_guard lock(m_mutex);
+    jobs.swap(m_jobs);
+  }
+
+  for (auto& job : jobs) {
+    job();
+  }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace BedrockWhiteList {
+
+
+namespace Utils {
+
+
+/*
+ * A background thread running a body every interval.
+ *
+ * The body gets the task itself, so long running work can poll IsStopping()
+ * and pause with Sleep(), which returns early on Stop().
+ */
+class PeriodicTask {
+  public:
+  typedef std::function<void(PeriodicTask&)>          Body;
+  typedef std::function<void(const std::exception&)> ErrorHandler;
+
+  PeriodicTask(std::chrono::milliseconds interval, Body body);
+  ~PeriodicTask();
+
+  PeriodicTask(const PeriodicTask&)            = delete;
+  PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+  public:
+  void Start();
+  void Stop();
+
+  // Runs the body now instead of waiting for the interval.
+  void Trigger();
+
+  // An exception thrown by the body is handed here and the task keeps going.
+  void SetErrorHandler(ErrorHandler handler);
+
+  bool IsStopping() const;
+  bool Sleep(std::chrono::milliseconds duration);
+
+  private:
+  void Loop();
+
+  private:
+  std::chrono::milliseconds m_interval;
+  Body                      m_body;
+  ErrorHandler              m_onError{};
+
+  std::mutex              m_mutex;
+  std::condition_variable m_cond;
+  bool                    m_triggered{false};
+  std::atomic<bool>       m_stopping{false};
+  std::thread             m_thread{};
+};
+
+
+/*
+ * One background thread running posted jobs in order. Stop() runs the jobs
+ * already posted before returning, jobs posted after it are refused.
+ */
+class SerialExecutor {
+  public:
+  typedef std::function<void()> Job;
+
+  SerialExecutor();
+  ~SerialExecutor();
+
+  SerialExecutor(const SerialExecutor&)            = delete;
+  SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+  public:
+  // False once Stop() was called; the job is then never run.
+  bool Post(Job job);
+  void Stop();
+
+  size_t Pending() const;
+
+  private:
+  void Loop();
+
+  private:
+  mutable std::mutex      m_mutex;
+  std::condition_variable m_cond;
+  std::vector<Job>        m_jobs{};
+  bool                    m_stopping{false};
+  std::thread             m_thread{};
+};
+
+
+/*
+ * A fixed number of threads taking posted jobs from one queue, in no
+ * particular order between them. Stop() runs the jobs already posted before
+ * returning, jobs posted after it are dropped.
+ */
+class WorkerPool {
+  public:
+  typedef std::function<void()> Job;
+
+  explicit WorkerPool(size_t threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&)            = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  public:
+  void Post(Job job);
+  void Stop();
+
+  size_t Threads() const;
+  size_t Pending() const;
+
+  private:
+  void Loop();
+
+  private:
+  mutable std::mutex       m_mutex;
+  std::condition_variable  m_cond;
+  std::deque<Job>          m_jobs{};
+  bool                     m_stopping{false};
+  std::vector<std::thread> m_threads{};
+};
+
+
+/*
+ * Jobs handed from background threads to the game thread, which runs them
+ * from a scheduler task once per tick.
+ */
+class MainThreadQueue {
+  public:
+  typedef std::function<void()> Job;
+
+  public:
+  void Post(Job job);
+
+  // Game thread only.
+  void Drain();
+
+  private:
+  std::mutex       m_mutex;
+  std::vector<Job> m_jobs{};
+};
+
+
+}; // namespace Utils
+
+
+} // namespace BedrockWhiteList
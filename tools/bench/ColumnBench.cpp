@@ -0,0 +1,241 @@
+/*
+ * Cost of the /_whitelist find queries over the query columns, against the
+ * same filter over a vector of PlayerInfo, which is what the lists give
+ * without them. No server or database needed.
+ *
+ * Fills both with --rows synthetic players, a tenth whitelisted, a tenth
+ * with a timed ban and the rest auto-recorded newcomers, and prints the
+ * best of --repeat runs of every query and the bytes held per row.
+ *
+ *   xmake f --bench=y && xmake build ColumnBench
+ *   xmake run ColumnBench --rows 1000000
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fmt/core.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "plugin/Columns.h"
+
+using namespace std::chrono;
+using namespace BedrockWhiteList::Utils;
+
+using std::string, std::vector;
+
+
+struct Options {
+  size_t   rows{1000000};
+  size_t   repeat{5};
+  uint32_t seed{20240601};
+};
+
+
+inline static void Usage() {
+  std::puts(
+      "ColumnBench [options]\n"
+      "  --rows <n>            players in the lists (1000000)\n"
+      "  --repeat <n>          runs per query, the best is printed (5)\n"
+      "  --seed <n>            random seed"
+  );
+}
+
+
+inline static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    const string name = argv[i];
+
+    if (name == "--help" or name == "-h") {
+      return false;
+    }
+
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", name.c_str());
+      return false;
+    }
+
+    const string value = argv[++i];
+
+    if (name == "--rows") {
+      options.rows = std::stoull(value);
+    } else if (name == "--repeat") {
+      options.repeat = std::stoull(value);
+    } else if (name == "--seed") {
+      options.seed = static_cast<uint32_t>(std::stoul(value));
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", name.c_str());
+      return false;
+    }
+  }
+
+  if (options.rows == 0 or options.repeat == 0) {
+    std::fprintf(stderr, "--rows and --repeat must be positive\n");
+    return false;
+  }
+
+  return true;
+}
+
+
+inline static string RandomUuid(std::mt19937_64& random) {
+  const auto high = random();
+  const auto low  = random();
+
+  return fmt::format(
+      "{:08x}-{:04x}-{:04x}-{:04x}-{:012x}",
+      high >> 32,
+      (high >> 16) & 0xFFFF,
+      high & 0xFFFF,
+      low >> 48,
+      low & 0xFFFFFFFFFFFF
+  );
+}
+
+
+// Gamertag-like: a word, a second one or not, digits or not.
+inline static string RandomName(std::mt19937_64& random) {
+  static const char* words[] = {
+      "Shadow", "craft", "Steve", "ender", "Pixel", "wolf",  "Nova",
+      "blaze",  "Frost", "miner", "Lucky", "storm", "Echo", "river"
+  };
+  constexpr size_t count = sizeof(words) / sizeof(words[0]);
+
+  string name = words[random() % count];
+  if (random() % 2) {
+    name += words[random() % count];
+  }
+  if (random() % 3) {
+    name += std::to_string(random() % 10000);
+  }
+
+  return name;
+}
+
+
+// Bytes a vector of them holds, strings that do not fit inline included.
+inline static size_t HeapBytes(const vector<PlayerInfo>& players) {
+  size_t bytes = players.capacity() * sizeof(PlayerInfo);
+  for (auto& info : players) {
+    for (auto* text : {&info.PlayerName, &info.PlayerUuid}) {
+      bytes += text->capacity() > 15 ? text->capacity() + 1 : 0;
+    }
+  }
+
+  return bytes;
+}
+
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not ParseOptions(argc, argv, options)) {
+    Usage();
+    return 1;
+  }
+
+  std::mt19937_64 random(options.seed);
+
+  const int64_t now = 1717200000;
+
+  vector<PlayerInfo> players{};
+  players.reserve(options.rows);
+  for (size_t i = 0; i < options.rows; i++) {
+    const auto kind = random() % 10;
+
+    PlayerInfo info(
+        kind == 0 ? Whitelist : Blacklist,
+        RandomName(random),
+        RandomUuid(random),
+        kind == 1 ? now + static_cast<int64_t>(random() % (90 * 86400)) : -1
+    );
+    info.Flags        = 1 < kind ? AutoRecorded : 0;
+    info.RecordedTime =
+        kind == 0 ? 0 : now - static_cast<int64_t>(random() % (30 * 86400));
+    players.push_back(std::move(info));
+  }
+
+
+  PlayerColumns columns{};
+
+  const auto loadStart = steady_clock::now();
+  for (auto& info : players) {
+    columns.Apply(info, now);
+  }
+  const auto loadMillis =
+      duration_cast<microseconds>(steady_clock::now() - loadStart).count() / 1e3;
+
+  const auto stats = columns.GetStatistics();
+  std::printf(
+      "%zu rows applied in %.0f ms; columns %.1f bytes/row, vector %.1f bytes/row\n\n",
+      stats.Rows,
+      loadMillis,
+      static_cast<double>(stats.Bytes) / stats.Rows,
+      static_cast<double>(HeapBytes(players)) / players.size()
+  );
+
+
+  const vector<std::pair<const char*, PlayerQuery>> queries{
+      {"expiring in 7 days", {ExpiringBefore, now + 7 * 86400, now}},
+      {"newcomers of 1 day", {RecordedSince, now - 86400, now}},
+      {"name contains \"wolf\"", {NameContains, 0, now, "wolf"}},
+      {"name contains \"zq\"", {NameContains, 0, now, "zq"}},
+  };
+
+  std::printf(
+      "%-24s %10s %14s %14s %9s\n",
+      "query",
+      "matches",
+      "columns ms",
+      "vector ms",
+      "speedup"
+  );
+
+  for (auto& [label, query] : queries) {
+    size_t matches{0}, expected{0};
+    double columnMillis{1e9}, vectorMillis{1e9};
+
+    for (size_t run = 0; run < options.repeat; run++) {
+      vector<PlayerInfo> found{};
+
+      const auto columnStart = steady_clock::now();
+      matches                = columns.Select(query, 10, found);
+      columnMillis           = std::min(
+          columnMillis,
+          duration_cast<nanoseconds>(steady_clock::now() - columnStart).count() / 1e6
+      );
+
+      const auto vectorStart = steady_clock::now();
+      expected = std::count_if(players.begin(), players.end(), [&](auto& info) {
+        return query.Matches(info);
+      });
+      vectorMillis = std::min(
+          vectorMillis,
+          duration_cast<nanoseconds>(steady_clock::now() - vectorStart).count() / 1e6
+      );
+    }
+
+    std::printf(
+        "%-24s %10zu %14.2f %14.2f %8.1fx\n",
+        label,
+        matches,
+        columnMillis,
+        vectorMillis,
+        vectorMillis / columnMillis
+    );
+
+    if (matches != expected) {
+      std::fprintf(
+          stderr,
+          "%s: %zu matches, the vector has %zu\n",
+          label,
+          matches,
+          expected
+      );
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * Cost of the compiled admission rules per connect, no server needed.
+ *
+ * Compiles tables of --rules rows of one kind each, none of which matches
+ * the synthetic connects, so every evaluation scans the whole table; the
+ * time per scanned row is what one more rule in config.yaml costs. The
+ * lists rows probe named lists filled on a scratch database, the groups rows
+ * a group cache every player is in one group of.
+ *
+ *   xmake f --bench=y && xmake build RuleBench
+ *   xmake run RuleBench --rules 32 --evaluations 2000000
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fmt/core.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Groups.h"
+#include "plugin/Migration.h"
+#include "plugin/NamedLists.h"
+#include "plugin/Rules.h"
+
+using namespace std::chrono;
+using namespace BedrockWhiteList::Utils;
+
+using std::string, std::vector;
+
+namespace filesystem = std::filesystem;
+
+
+struct Options {
+  string   databasePath{"rule-bench.db"};
+  size_t   rules{16};
+  size_t   lists{4};
+  size_t   members{10000};
+  size_t   players{4096};
+  size_t   evaluations{1000000};
+  uint32_t seed{20240601};
+};
+
+
+inline static void Usage() {
+  std::puts(
+      "RuleBench [options]\n"
+      "  --db <path>           scratch database, recreated (rule-bench.db)\n"
+      "  --rules <n>           rows per table (16)\n"
+      "  --lists <n>           named lists the lists rows probe (4)\n"
+      "  --members <n>         players on each list (10000)\n"
+      "  --players <n>         distinct connecting players, half on a list (4096)\n"
+      "  --evaluations <n>     connects evaluated per table (1000000)\n"
+      "  --seed <n>            random seed"
+  );
+}
+
+
+inline static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    const string name = argv[i];
+
+    if (name == "--help" or name == "-h") {
+      return false;
+    }
+
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", name.c_str());
+      return false;
+    }
+
+    const string value = argv[++i];
+
+    if (name == "--db") {
+      options.databasePath = value;
+    } else if (name == "--rules") {
+      options.rules = std::stoull(value);
+    } else if (name == "--lists") {
+      options.lists = std::stoull(value);
+    } else if (name == "--members") {
+      options.members = std::stoull(value);
+    } else if (name == "--players") {
+      options.players = std::stoull(value);
+    } else if (name == "--evaluations") {
+      options.evaluations = std::stoull(value);
+    } else if (name == "--seed") {
+      options.seed = static_cast<uint32_t>(std::stoul(value));
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", name.c_str());
+      return false;
+    }
+  }
+
+  if (options.rules == 0 or options.lists == 0 or options.players == 0) {
+    std::fprintf(stderr, "--rules, --lists and --players must be positive\n");
+    return false;
+  }
+
+  return true;
+}
+
+
+inline static string RandomUuid(std::mt19937_64& random) {
+  const auto high = random();
+  const auto low  = random();
+
+  return fmt::format(
+      "{:08x}-{:04x}-{:04x}-{:04x}-{:012x}",
+      high >> 32,
+      (high >> 16) & 0xFFFF,
+      high & 0xFFFF,
+      low >> 48,
+      low & 0xFFFFFFFFFFFF
+  );
+}
+
+
+// Schema of PluginConfig::OpenDatabase(), named lists need nothing else.
+inline static void CreateScratchDatabase(const string& path) {
+  for (auto suffix : {"", "-wal", "-shm"}) {
+    std::error_code ec;
+    filesystem::remove(path + suffix, ec);
+  }
+
+  SQLite::Database database(path, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+  database.exec("PRAGMA journal_mode = WAL;");
+
+  Migrator(database, PlayerSchemaMigrations()).Run(PLAYER_SCHEMA_BASELINE);
+}
+
+
+// - - - - - - Tables - - - - - -
+
+
+// Rows of one kind that never match the connects of Run().
+inline static vector<RuleSource>
+MakeTable(const string& kind, const Options& options) {
+  vector<RuleSource> rules(options.rules);
+
+  for (size_t i = 0; i < rules.size(); i++) {
+    auto& rule  = rules[i];
+    rule.Name   = fmt::format("{}-{}", kind, i);
+    rule.Action = i % 2 ? "allow" : "deny";
+
+    if (kind == "days") {
+      rule.Days = {"weekend"};
+    } else if (kind == "hours") {
+      rule.Hours = "03:00-04:00";
+    } else if (kind == "newcomer") {
+      rule.Newcomer = 1;
+    } else if (kind == "groups") {
+      // Groups no player of Run() is in.
+      rule.Groups = {fmt::format("group{}", i % 8), "staff"};
+    } else if (kind == "lists") {
+      // The whole program runs, the blacklist operand keeps it false.
+      rule.Lists = fmt::format("list{} and blacklist", i % options.lists);
+    } else {
+      // Every test runs, the lists one fails.
+      rule.Days     = {"weekdays"};
+      rule.Hours    = "09:00-17:00";
+      rule.Newcomer = 0;
+      rule.Lists    = fmt::format("list{} and blacklist", i % options.lists);
+    }
+  }
+
+  return rules;
+}
+
+
+struct Result {
+  double   Nanos;
+  uint64_t Scanned;
+  uint64_t Matched;
+};
+
+
+inline static Result Run(
+    const RuleEngine&     engine,
+    const vector<string>& players,
+    const Options&        options
+) {
+  // Monday noon, a known whitelisted player who is not blacklisted.
+  RuleInput input{};
+  input.Weekday     = 1;
+  input.Minute      = 12 * 60;
+  input.Hour        = 0;
+  input.Whitelisted = true;
+  input.Blacklisted = false;
+  input.Newcomer    = false;
+
+  Result     result{};
+  const auto startTime = steady_clock::now();
+
+  for (size_t i = 0; i < options.evaluations; i++) {
+    input.PlayerUuid = &players[i % players.size()];
+
+    const auto decision = engine.Evaluate(input, RuleEngine::Peek);
+    result.Scanned += decision.Scanned;
+    result.Matched += decision.Matched();
+  }
+
+  result.Nanos = static_cast<double>(
+      duration_cast<nanoseconds>(steady_clock::now() - startTime).count()
+  );
+  return result;
+}
+
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not ParseOptions(argc, argv, options)) {
+    Usage();
+    return 1;
+  }
+
+  std::mt19937_64 random(options.seed);
+
+
+  CreateScratchDatabase(options.databasePath);
+
+  NamedLists lists(options.databasePath);
+  lists.Load();
+
+  vector<string> players{};
+  for (size_t i = 0; i < options.players; i++) {
+    players.push_back(RandomUuid(random));
+  }
+
+  const auto setupStart = steady_clock::now();
+  for (size_t l = 0; l < options.lists; l++) {
+    const auto name = fmt::format("list{}", l);
+    lists.Create(name);
+
+    // Half of the connecting players, the rest are strangers.
+    vector<string> members{};
+    for (size_t i = 0; i < options.members; i++) {
+      members.push_back(
+          i % 2 == 0 ? players[random() % players.size()] : RandomUuid(random)
+      );
+    }
+    lists.Add(name, members);
+  }
+
+  std::printf(
+      "Lists: %zu of %zu members, ready in %lld ms\n",
+      options.lists,
+      options.members,
+      static_cast<long long>(
+          duration_cast<milliseconds>(steady_clock::now() - setupStart).count()
+      )
+  );
+  // Pushed as a group plugin would, so no lookup misses.
+  GroupCache groups{};
+  for (auto& player : players) {
+    groups.Set(player, {"member"});
+  }
+
+  std::printf(
+      "%-10s %12s %12s %12s %10s\n",
+      "table",
+      "rows",
+      "ns/connect",
+      "ns/row",
+      "matched"
+  );
+
+
+  for (auto kind : {"days", "hours", "newcomer", "groups", "lists", "mixed"}) {
+    RuleEngine engine{};
+    string     error{};
+
+    if (not engine.Compile(MakeTable(kind, options), &lists, &groups, error)) {
+      std::fprintf(stderr, "%s: %s\n", kind, error.c_str());
+      return 1;
+    }
+
+    // Once to warm the caches, once measured.
+    Run(engine, players, options);
+    const auto result = Run(engine, players, options);
+
+    std::printf(
+        "%-10s %12zu %12.1f %12.2f %10llu\n",
+        kind,
+        engine.Size(),
+        result.Nanos / static_cast<double>(options.evaluations),
+        result.Nanos / static_cast<double>(std::max<uint64_t>(result.Scanned, 1)),
+        static_cast<unsigned long long>(result.Matched)
+    );
+  }
+
+  return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * Write throughput of the player rows over 1 .. N shard files, no server
+ * needed.
+ *
+ * For every shard count, --writers threads write --rows synthetic players
+ * through PlayerDB in batches of --batch, as /_whitelist set and the
+ * newcomer recorder do, with the verdict cache and the counters mirrored
+ * as in the plugin, while another thread looks players up. Then it times
+ * lookups alone and the fan-out list and name queries. Every shard commits
+ * on its own writer thread, so the write rate should grow with the count
+ * until the disk or the cores run out, and lookups should wait less for the
+ * writes. Finally the rows of the last count are rebalanced to the first.
+ *
+ *   xmake f --bench=y && xmake build ShardBench
+ *   xmake run ShardBench --rows 200000 --shards 1,2,4,8
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fmt/core.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Migration.h"
+#include "plugin/PlayerDB.h"
+#include "plugin/Shards.h"
+
+using namespace std::chrono;
+using namespace BedrockWhiteList::Utils;
+
+using std::string, std::vector;
+
+namespace filesystem = std::filesystem;
+
+
+struct Options {
+  string         directory{"shard-bench"};
+  size_t         rows{200000};
+  size_t         batch{1000};
+  size_t         writers{4};
+  size_t         lookups{100000};
+  vector<size_t> shards{1, 2, 4, 8};
+  uint32_t       seed{20240601};
+};
+
+
+inline static void Usage() {
+  std::puts(
+      "ShardBench [options]\n"
+      "  --dir <path>          scratch directory, recreated (shard-bench)\n"
+      "  --rows <n>            players written per shard count (200000)\n"
+      "  --batch <n>           players per write batch (1000)\n"
+      "  --writers <n>         threads writing batches at once (4)\n"
+      "  --lookups <n>         uuid lookups per shard count (100000)\n"
+      "  --shards <list>       shard counts to compare (1,2,4,8)\n"
+      "  --seed <n>            random seed"
+  );
+}
+
+
+inline static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    const string name = argv[i];
+
+    if (name == "--help" or name == "-h") {
+      return false;
+    }
+
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", name.c_str());
+      return false;
+    }
+
+    const string value = argv[++i];
+
+    if (name == "--dir") {
+      options.directory = value;
+    } else if (name == "--rows") {
+      options.rows = std::stoull(value);
+    } else if (name == "--batch") {
+      options.batch = std::stoull(value);
+    } else if (name == "--writers") {
+      options.writers = std::stoull(value);
+    } else if (name == "--lookups") {
+      options.lookups = std::stoull(value);
+    } else if (name == "--shards") {
+      options.shards.clear();
+      for (size_t start = 0; start < value.size();) {
+        const auto end = std::min(value.find(',', start), value.size());
+        options.shards.push_back(std::stoull(value.substr(start, end - start)));
+        start = end + 1;
+      }
+    } else if (name == "--seed") {
+      options.seed = static_cast<uint32_t>(std::stoul(value));
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", name.c_str());
+      return false;
+    }
+  }
+
+  for (auto shards : options.shards) {
+    if (shards == 0 or shards > MAX_SHARDS) {
+      std::fprintf(stderr, "Shard counts must be 1 .. %zu\n", MAX_SHARDS);
+      return false;
+    }
+  }
+
+  if (options.rows == 0 or options.batch == 0 or options.writers == 0
+      or options.shards.empty()) {
+    std::fprintf(stderr, "--rows, --batch, --writers and --shards must be positive\n");
+    return false;
+  }
+
+  return true;
+}
+
+
+inline static string RandomUuid(std::mt19937_64& random) {
+  const auto high = random();
+  const auto low  = random();
+
+  return fmt::format(
+      "{:08x}-{:04x}-{:04x}-{:04x}-{:012x}",
+      high >> 32,
+      (high >> 16) & 0xFFFF,
+      high & 0xFFFF,
+      low >> 48,
+      low & 0xFFFFFFFFFFFF
+  );
+}
+
+
+// The main database as PluginConfig::OpenDatabase() and the online
+// migrations leave it.
+inline static std::unique_ptr<SQLite::Database> CreateScratch(const string& directory) {
+  std::error_code ec;
+  filesystem::remove_all(directory, ec);
+  filesystem::create_directories(directory);
+
+  auto database = std::make_unique<SQLite::Database>(
+      (filesystem::path(directory) / "bench.sqlite3.db").string(),
+      SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+  );
+  database->exec("PRAGMA auto_vacuum = INCREMENTAL;");
+  database->exec("PRAGMA journal_mode = WAL;");
+
+  Migrator(*database, PlayerSchemaMigrations()).Run();
+  return database;
+}
+
+
+inline static double Seconds(steady_clock::time_point since) {
+  return duration_cast<microseconds>(steady_clock::now() - since).count() / 1e6;
+}
+
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not ParseOptions(argc, argv, options)) {
+    Usage();
+    return 1;
+  }
+
+  std::mt19937_64 random(options.seed);
+
+  vector<PlayerInfo> players{};
+  players.reserve(options.rows);
+  for (size_t i = 0; i < options.rows; i++) {
+    PlayerInfo info(
+        i % 10 == 0 ? Whitelist : Blacklist,
+        fmt::format("player{}", i),
+        RandomUuid(random),
+        1
+    );
+    info.Flags = info.PlayerStatus == Blacklist ? AutoRecorded : 0;
+    players.push_back(std::move(info));
+  }
+
+  std::printf(
+      "%-7s %12s %9s %14s %12s %12s %12s\n",
+      "shards",
+      "rows/s",
+      "speedup",
+      "busy lookup ns",
+      "lookup ns",
+      "list ms",
+      "name ms"
+  );
+
+
+  const auto databasePath =
+      (filesystem::path(options.directory) / "bench.sqlite3.db").string();
+  double baseline{0};
+
+  for (auto shards : options.shards) {
+    auto database = CreateScratch(options.directory);
+
+    double writeSeconds{0}, busyNanos{0}, lookupNanos{0}, listMillis{0},
+        nameMillis{0};
+    {
+      ShardedBackend backend(databasePath, shards);
+      VerdictCache   cache{};
+      ListCounters   counters("", 0);
+      PlayerDB       playerDB(&backend);
+      playerDB.SetCache(&cache);
+      playerDB.SetCounters(&counters);
+
+      std::atomic<size_t> nextBatch{0};
+      std::atomic<bool>   writing{true};
+      vector<std::thread> writers{};
+
+      const auto writeStart = steady_clock::now();
+      for (size_t i = 0; i < options.writers; i++) {
+        writers.emplace_back([&]() {
+          for (;;) {
+            const auto offset = nextBatch.fetch_add(1) * options.batch;
+            if (offset >= players.size()) {
+              return;
+            }
+
+            const auto end = std::min(offset + options.batch, players.size());
+            playerDB.SetPlayerInfoBatch(
+                vector<PlayerInfo>(players.begin() + offset, players.begin() + end),
+                "bench"
+            );
+          }
+        });
+      }
+
+      // Lookups while the writers run, as joins during a newcomer flood.
+      size_t      busyLookups{0};
+      std::thread reader([&]() {
+        std::mt19937_64 readerRandom(options.seed + 1);
+        const auto      busyStart = steady_clock::now();
+        while (writing) {
+          playerDB.GetPlayerInfoAsUUID(
+              players[readerRandom() % players.size()].PlayerUuid
+          );
+          busyLookups++;
+        }
+        busyNanos = Seconds(busyStart) * 1e9 / std::max<size_t>(busyLookups, 1);
+      });
+
+      for (auto& writer : writers) {
+        writer.join();
+      }
+      writeSeconds = Seconds(writeStart);
+      writing      = false;
+      reader.join();
+
+      const auto lookupStart = steady_clock::now();
+      for (size_t i = 0; i < options.lookups; i++) {
+        playerDB.GetPlayerInfoAsUUID(players[random() % players.size()].PlayerUuid);
+      }
+      lookupNanos = Seconds(lookupStart) * 1e9 / std::max<size_t>(options.lookups, 1);
+
+      PlayerInfo info{};
+
+      const auto listStart = steady_clock::now();
+      const auto listed    = backend.ListByStatus(Whitelist);
+      listMillis           = Seconds(listStart) * 1e3;
+
+      const auto nameStart = steady_clock::now();
+      backend.FindByName(players.back().PlayerName, info);
+      nameMillis = Seconds(nameStart) * 1e3;
+
+      if (listed.size() != (players.size() + 9) / 10) {
+        std::fprintf(stderr, "%zu shard(s) listed %zu players\n", shards, listed.size());
+        return 1;
+      }
+    }
+    StoreShardCount(*database, shards);
+
+    const auto rate = players.size() / writeSeconds;
+    baseline        = baseline == 0 ? rate : baseline;
+
+    std::printf(
+        "%-7zu %12.0f %8.2fx %14.0f %12.0f %12.1f %12.1f\n",
+        shards,
+        rate,
+        rate / baseline,
+        busyNanos,
+        lookupNanos,
+        listMillis,
+        nameMillis
+    );
+
+
+    // The last layout is spread back to the first, as a restart with a
+    // new database.shards would.
+    if (shards == options.shards.back() and shards != options.shards.front()) {
+      const auto report = RebalanceShards(*database, databasePath, options.shards.front());
+
+      std::printf(
+          "Rebalanced %zu -> %zu shard(s): %zu rows in %lld ms\n",
+          report.From,
+          report.To,
+          report.Rows,
+          static_cast<long long>(report.DurationMillis)
+      );
+
+      if (report.Rows != players.size()) {
+        std::fprintf(stderr, "Rebalance lost rows\n");
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+-- Micro-benchmarks of single modules, built like tools/loadgen without BDS
+-- or LeviLamina.
+if has_config("bench") then
+    add_requires("fmt")
+
+    target("RuleBench")
+        set_kind("binary")
+        set_languages("c++20")
+        add_packages("fmt")
+        add_packages("sqlite3")
+        add_packages("sqlitecpp")
+
+        if is_plat("windows") then
+            add_cxflags("/utf-8")
+            add_defines("NOMINMAX", "UNICODE")
+        else
+            add_syslinks("pthread")
+        end
+
+        add_includedirs("$(projectdir)/src")
+        add_files("RuleBench.cpp")
+        add_files(
+            "$(projectdir)/src/plugin/Bitmap.cpp",
+            "$(projectdir)/src/plugin/Groups.cpp",
+            "$(projectdir)/src/plugin/Migration.cpp",
+            "$(projectdir)/src/plugin/NamedLists.cpp",
+            "$(projectdir)/src/plugin/Rules.cpp"
+        )
+
+    target("ShardBench")
+        set_kind("binary")
+        set_languages("c++20")
+        add_packages("fmt")
+        add_packages("sqlite3")
+        add_packages("sqlitecpp")
+
+        if is_plat("windows") then
+            add_cxflags("/utf-8")
+            add_defines("NOMINMAX", "UNICODE")
+        else
+            add_syslinks("pthread")
+        end
+
+        add_includedirs("$(projectdir)/src")
+        add_files("ShardBench.cpp")
+        add_files(
+            "$(projectdir)/src/plugin/Columns.cpp",
+            "$(projectdir)/src/plugin/Counters.cpp",
+            "$(projectdir)/src/plugin/Journal.cpp",
+            "$(projectdir)/src/plugin/Migration.cpp",
+            "$(projectdir)/src/plugin/PlayerDB.cpp",
+            "$(projectdir)/src/plugin/Shards.cpp",
+            "$(projectdir)/src/plugin/Storage.cpp",
+            "$(projectdir)/src/plugin/VerdictCache.cpp",
+            "$(projectdir)/src/plugin/Worker.cpp"
+        )
+
+    target("ColumnBench")
+        set_kind("binary")
+        set_languages("c++20")
+        add_packages("fmt")
+        add_packages("sqlite3")
+        add_packages("sqlitecpp")
+
+        if is_plat("windows") then
+            add_cxflags("/utf-8")
+            add_defines("NOMINMAX", "UNICODE")
+        else
+            add_syslinks("pthread")
+        end
+
+        add_includedirs("$(projectdir)/src")
+        add_files("ColumnBench.cpp")
+        add_files(
+            "$(projectdir)/src/plugin/Columns.cpp",
+            "$(projectdir)/src/plugin/Storage.cpp"
+        )
+end
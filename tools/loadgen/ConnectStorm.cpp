@@ -0,0 +1,650 @@
+/*
+ * Synthetic connect storm against the admission pipeline, no server needed.
+ *
+ * Builds a scratch database with the plugin schema, fills it with
+ * whitelisted and blacklisted players and then replays joins through
+ * ConnectHandler::Handle() with a stub PlayerConnectEvent, at a target rate
+ * spread over several threads. Prints the decision latency percentiles and
+ * the database write rates, and fails when a rejected newcomer has no row
+ * once the queued writes are done.
+ *
+ *   xmake f --loadgen=y && xmake build ConnectStorm
+ *   xmake run ConnectStorm --rate 2000 --threads 8 --duration 30 --mix 60:20:20
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <fmt/core.h>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+
+#include "plugin/Admission.h"
+#include "plugin/Connect.h"
+#include "plugin/Counters.h"
+#include "plugin/Identity.h"
+#include "plugin/LastSeen.h"
+#include "plugin/Migration.h"
+#include "plugin/PlayerDB.h"
+#include "plugin/Storage.h"
+#include "plugin/VerdictCache.h"
+#include "plugin/Warmup.h"
+
+using namespace std::chrono;
+using namespace BedrockWhiteList::Utils;
+
+using std::string, std::vector;
+
+namespace filesystem = std::filesystem;
+
+
+struct Options {
+  string   databasePath{"connect-storm.db"};
+  size_t   whitelisted{10000};
+  size_t   blacklisted{50000};
+  size_t   unknownPool{0};
+  int      mixWhitelisted{60};
+  int      mixBlacklisted{20};
+  int      mixUnknown{20};
+  double   rate{1000};
+  int      threads{4};
+  int      duration{10};
+  int      budgetMillis{50};
+  string   fallbackPolicy{"fail-closed"};
+  int      warmupMillis{0};
+  string   warmupPolicy{"hold"};
+  int      holdTimeout{3000};
+  int64_t  flushInterval{1};
+  bool     preload{true};
+  uint32_t seed{20240601};
+};
+
+
+// - - - - - - Stub event - - - - - -
+
+
+// The part of mce::UUID, Player and PlayerConnectEvent the handler uses.
+struct StubUuid {
+  const string& Value;
+
+  string asString() const { return Value; }
+};
+
+
+struct StubPlayer {
+  string Uuid;
+  string Name;
+  string Xuid{};
+  string Kicked{};
+
+  StubUuid      getUuid() const { return {Uuid}; }
+  const string& getName() const { return Name; }
+  const string& getXuid() const { return Xuid; }
+  void          disconnect(const string& message) { Kicked = message; }
+};
+
+
+struct StubEvent {
+  StubPlayer& Player;
+
+  StubPlayer& self() { return Player; }
+};
+
+
+// - - - - - - Write counting - - - - - -
+
+
+class CountingBackend : public StorageBackend {
+  public:
+  explicit CountingBackend(StorageBackend& inner) : m_inner(inner) {}
+
+  StorageKind Kind() const override { return m_inner.Kind(); }
+
+  bool FindByUuid(const string& playerUuid, PlayerInfo& info) override {
+    return m_inner.FindByUuid(playerUuid, info);
+  }
+
+  bool FindByName(const string& playerName, PlayerInfo& info) override {
+    return m_inner.FindByName(playerName, info);
+  }
+
+  vector<PlayerInfo> ListByStatus(PlayerStatus status) override {
+    return m_inner.ListByStatus(status);
+  }
+
+  void ForEach(const Visitor& visitor, bool withAutoRecorded) override {
+    m_inner.ForEach(visitor, withAutoRecorded);
+  }
+
+  void WriteBatch(const vector<PlayerInfo>& batch, vector<PlayerInfo>* oldInfos)
+      override {
+    m_inner.WriteBatch(batch, oldInfos);
+
+    Transactions++;
+    Rows += batch.size();
+  }
+
+  void WriteBatchWithHistory(
+      const vector<PlayerInfo>& batch,
+      vector<PlayerInfo>*       oldInfos,
+      const vector<PlayerInfo>& history,
+      const string&             actor,
+      const string&             reason,
+      int64_t                   time,
+      const Committed&          committed
+  ) override {
+    m_inner.WriteBatchWithHistory(
+        batch,
+        oldInfos,
+        history,
+        actor,
+        reason,
+        time,
+        committed
+    );
+
+    Transactions++;
+    Rows += batch.size();
+  }
+
+  void WriteNotes(const string& playerUuid, const string& notes) override {
+    m_inner.WriteNotes(playerUuid, notes);
+  }
+
+  bool LoadMeta(const string& playerUuid, PlayerMeta& meta, size_t historyLimit)
+      override {
+    return m_inner.LoadMeta(playerUuid, meta, historyLimit);
+  }
+
+  public:
+  std::atomic<uint64_t> Transactions{0};
+  std::atomic<uint64_t> Rows{0};
+
+  private:
+  StorageBackend& m_inner;
+};
+
+
+// - - - - - - Helpers - - - - - -
+
+
+inline static string RandomUuid(std::mt19937_64& random) {
+  const auto high = random();
+  const auto low  = random();
+
+  return fmt::format(
+      "{:08x}-{:04x}-{:04x}-{:04x}-{:012x}",
+      high >> 32,
+      (high >> 16) & 0xFFFF,
+      high & 0xFFFF,
+      low >> 48,
+      low & 0xFFFFFFFFFFFF
+  );
+}
+
+
+inline static int64_t Percentile(const vector<int64_t>& sorted, double rank) {
+  if (sorted.empty()) {
+    return 0;
+  }
+
+  const auto index = static_cast<size_t>(rank * static_cast<double>(sorted.size()));
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+
+inline static void Usage() {
+  std::puts(
+      "ConnectStorm [options]\n"
+      "  --db <path>               scratch database, recreated (connect-storm.db)\n"
+      "  --whitelisted <n>         whitelisted players in the database (10000)\n"
+      "  --blacklisted <n>         blacklisted players in the database (50000)\n"
+      "  --mix <w:b:u>             share of whitelisted, blacklisted and unknown joins (60:20:20)\n"
+      "  --unknown-pool <n>        unknown joins reuse n uuids, 0 is always new (0)\n"
+      "  --rate <joins/s>          target join rate over all threads (1000)\n"
+      "  --threads <n>             joining threads (4)\n"
+      "  --duration <s>            length of the run (10)\n"
+      "  --budget <ms>             connect.budgetMillis (50)\n"
+      "  --fallback <policy>       connect.fallbackPolicy (fail-closed)\n"
+      "  --warmup <ms>             keep the readiness gate closed this long (0)\n"
+      "  --warmup-policy <policy>  startup.warmupPolicy (hold)\n"
+      "  --hold-timeout <ms>       startup.holdTimeout (3000)\n"
+      "  --flush-interval <s>      lastSeen.flushInterval, identities too (1)\n"
+      "  --no-preload              start with an empty verdict cache\n"
+      "  --seed <n>                random seed"
+  );
+}
+
+
+inline static bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    const string name = argv[i];
+
+    if (name == "--help" or name == "-h") {
+      return false;
+    }
+
+    if (name == "--no-preload") {
+      options.preload = false;
+      continue;
+    }
+
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", name.c_str());
+      return false;
+    }
+
+    const string value = argv[++i];
+
+    if (name == "--db") {
+      options.databasePath = value;
+    } else if (name == "--whitelisted") {
+      options.whitelisted = std::stoull(value);
+    } else if (name == "--blacklisted") {
+      options.blacklisted = std::stoull(value);
+    } else if (name == "--unknown-pool") {
+      options.unknownPool = std::stoull(value);
+    } else if (name == "--mix") {
+      if (std::sscanf(
+              value.c_str(),
+              "%d:%d:%d",
+              &options.mixWhitelisted,
+              &options.mixBlacklisted,
+              &options.mixUnknown
+          )
+          != 3) {
+        std::fprintf(stderr, "--mix takes w:b:u\n");
+        return false;
+      }
+    } else if (name == "--rate") {
+      options.rate = std::stod(value);
+    } else if (name == "--threads") {
+      options.threads = std::max(std::stoi(value), 1);
+    } else if (name == "--duration") {
+      options.duration = std::stoi(value);
+    } else if (name == "--budget") {
+      options.budgetMillis = std::stoi(value);
+    } else if (name == "--fallback") {
+      options.fallbackPolicy = value;
+    } else if (name == "--warmup") {
+      options.warmupMillis = std::stoi(value);
+    } else if (name == "--warmup-policy") {
+      options.warmupPolicy = value;
+    } else if (name == "--hold-timeout") {
+      options.holdTimeout = std::stoi(value);
+    } else if (name == "--flush-interval") {
+      options.flushInterval = std::stoll(value);
+    } else if (name == "--seed") {
+      options.seed = static_cast<uint32_t>(std::stoul(value));
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", name.c_str());
+      return false;
+    }
+  }
+
+  const auto mixTotal =
+      options.mixWhitelisted + options.mixBlacklisted + options.mixUnknown;
+  if (mixTotal <= 0 or options.rate <= 0) {
+    std::fprintf(stderr, "--mix and --rate must be positive\n");
+    return false;
+  }
+
+  if ((options.mixWhitelisted > 0 and options.whitelisted == 0)
+      or (options.mixBlacklisted > 0 and options.blacklisted == 0)) {
+    std::fprintf(stderr, "The mix joins players the database does not have\n");
+    return false;
+  }
+
+  return true;
+}
+
+
+// Same connection setup as PluginConfig::OpenDatabase(), and the online
+// migrations done, they have nothing to copy in a new database.
+inline static std::unique_ptr<SQLite::Database>
+OpenScratchDatabase(const string& path) {
+  for (auto suffix : {"", "-wal", "-shm"}) {
+    std::error_code ec;
+    filesystem::remove(path + suffix, ec);
+  }
+
+  auto database = std::make_unique<SQLite::Database>(
+      path,
+      SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+  );
+
+  database->exec("PRAGMA auto_vacuum = INCREMENTAL;");
+  database->exec("PRAGMA journal_mode = WAL;");
+  database->setBusyTimeout(250);
+
+  Migrator(*database, PlayerSchemaMigrations()).Run();
+  return database;
+}
+
+
+inline static vector<string> Populate(
+    PlayerDB&        playerDB,
+    PlayerStatus     status,
+    size_t           count,
+    std::mt19937_64& random
+) {
+  vector<string>     uuids{};
+  vector<PlayerInfo> batch{};
+
+  uuids.reserve(count);
+  batch.reserve(1000);
+
+  for (size_t i = 0; i < count; i++) {
+    uuids.push_back(RandomUuid(random));
+    batch.emplace_back(
+        status,
+        fmt::format("{}{}", status == Whitelist ? "white" : "black", i),
+        uuids.back(),
+        -1
+    );
+
+    if (batch.size() == 1000 or i + 1 == count) {
+      playerDB.SetPlayerInfoBatch(batch, "loadgen");
+      batch.clear();
+    }
+  }
+
+  return uuids;
+}
+
+
+// - - - - - - Run - - - - - -
+
+
+constexpr size_t OUTCOMES = ConnectOutcome::RuleRejected + 1;
+
+
+struct ThreadResult {
+  vector<int64_t> Nanos{};
+  uint64_t        Late{0};
+  uint64_t        Outcomes[OUTCOMES]{};
+  vector<string>  Newcomers{};
+};
+
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not ParseOptions(argc, argv, options)) {
+    Usage();
+    return 1;
+  }
+
+  std::mt19937_64 random(options.seed);
+
+
+  auto            database = OpenScratchDatabase(options.databasePath);
+  SQLiteBackend   sqlite(*database);
+  CountingBackend backend(sqlite);
+  VerdictCache    cache{};
+  PlayerDB        playerDB(&backend);
+
+  auto setupStart  = steady_clock::now();
+  auto whitelisted = Populate(playerDB, Whitelist, options.whitelisted, random);
+  auto blacklisted = Populate(playerDB, Blacklist, options.blacklisted, random);
+
+  vector<string> unknownPool{};
+  for (size_t i = 0; i < options.unknownPool; i++) {
+    unknownPool.push_back(RandomUuid(random));
+  }
+
+  // Counted once here, kept up to date by the newcomer writes from here on.
+  ListCounters counters(options.databasePath, options.flushInterval);
+  playerDB.SetCounters(&counters);
+  if (not counters.Load(std::time(nullptr))) {
+    playerDB.RecountCounters();
+  }
+
+  playerDB.SetCache(&cache);
+  if (options.preload) {
+    playerDB.Preload(cache);
+  }
+
+  std::printf(
+      "Database: %zu whitelisted, %zu blacklisted, ready in %lld ms\n",
+      options.whitelisted,
+      options.blacklisted,
+      static_cast<long long>(
+          duration_cast<milliseconds>(steady_clock::now() - setupStart).count()
+      )
+  );
+
+  // Only joins are counted from here on.
+  backend.Transactions = 0;
+  backend.Rows         = 0;
+
+
+  AdmissionController::Options admissionOptions{};
+  admissionOptions.budget   = milliseconds(options.budgetMillis);
+  admissionOptions.fallback = ParseWarmupPolicy(options.fallbackPolicy);
+
+  AdmissionController admission(playerDB, cache, admissionOptions);
+  LastSeenTracker     lastSeen(options.databasePath, options.flushInterval);
+  IdentityIndex       identities(options.databasePath, options.flushInterval);
+  ReadinessGate       gate{};
+  ConnectHandler      handler(
+      gate,
+      {ParseWarmupPolicy(options.warmupPolicy), milliseconds(options.holdTimeout)}
+  );
+
+  identities.Load();
+  handler.Attach(&admission, &lastSeen, nullptr, nullptr, &identities, &counters);
+  lastSeen.Start();
+  identities.Start();
+  counters.Start();
+
+  std::thread warmup([&gate, &options]() {
+    std::this_thread::sleep_for(milliseconds(options.warmupMillis));
+    gate.Open();
+  });
+
+
+  const auto mixTotal =
+      options.mixWhitelisted + options.mixBlacklisted + options.mixUnknown;
+  const auto interval = duration_cast<steady_clock::duration>(
+      duration<double>(options.threads / options.rate)
+  );
+  const auto startTime = steady_clock::now();
+  const auto endTime   = startTime + seconds(options.duration);
+
+  vector<ThreadResult> results(options.threads);
+  vector<std::thread>  threads{};
+
+  for (int t = 0; t < options.threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937_64 threadRandom(options.seed + t + 1);
+      auto&           result = results[t];
+
+      result.Nanos.reserve(static_cast<size_t>(
+          options.rate / options.threads * options.duration * 1.1
+      ));
+
+      // Staggered so the threads do not join in lockstep.
+      auto scheduled = startTime + interval * t / options.threads;
+
+      while (scheduled < endTime) {
+        std::this_thread::sleep_until(scheduled);
+
+        if (steady_clock::now() - scheduled > interval) {
+          result.Late++;
+        }
+
+
+        const auto pick = static_cast<int>(threadRandom() % mixTotal);
+        StubPlayer player{};
+
+        if (pick < options.mixWhitelisted) {
+          player.Uuid = whitelisted[threadRandom() % whitelisted.size()];
+        } else if (pick < options.mixWhitelisted + options.mixBlacklisted) {
+          player.Uuid = blacklisted[threadRandom() % blacklisted.size()];
+        } else if (not unknownPool.empty()) {
+          player.Uuid = unknownPool[threadRandom() % unknownPool.size()];
+        } else {
+          player.Uuid = RandomUuid(threadRandom);
+        }
+        player.Name = player.Uuid.substr(0, 8);
+        player.Xuid = std::to_string(std::hash<string>{}(player.Uuid) >> 1 | 1);
+
+        StubEvent ev{player};
+
+        const auto callStart = steady_clock::now();
+        const auto outcome =
+            handler.Handle(ev, [](const ConnectOutcome&) { return "kicked"; });
+
+        result.Nanos.push_back(
+            duration_cast<nanoseconds>(steady_clock::now() - callStart).count()
+        );
+        result.Outcomes[outcome.What]++;
+        if (outcome.What == ConnectOutcome::NewcomerRejected) {
+          result.Newcomers.push_back(player.Uuid);
+        }
+
+        scheduled += interval;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const auto joinSeconds =
+      duration<double>(steady_clock::now() - startTime).count();
+
+  warmup.join();
+
+  // Queued newcomer writes, the last last-seen and identity batches and the
+  // counters.
+  admission.Stop();
+  lastSeen.Stop();
+  identities.Stop();
+  counters.Stop();
+
+  const auto totalSeconds =
+      duration<double>(steady_clock::now() - startTime).count();
+
+
+  vector<int64_t> nanos{};
+  uint64_t        late{0};
+  uint64_t        outcomes[OUTCOMES]{};
+  vector<string>  newcomers{};
+
+  for (auto& result : results) {
+    nanos.insert(nanos.end(), result.Nanos.begin(), result.Nanos.end());
+    newcomers.insert(
+        newcomers.end(),
+        result.Newcomers.begin(),
+        result.Newcomers.end()
+    );
+    late += result.Late;
+
+    for (size_t i = 0; i < OUTCOMES; i++) {
+      outcomes[i] += result.Outcomes[i];
+    }
+  }
+  std::sort(nanos.begin(), nanos.end());
+
+  // A pooled uuid can be rejected again before its row is written.
+  std::sort(newcomers.begin(), newcomers.end());
+  newcomers.erase(std::unique(newcomers.begin(), newcomers.end()), newcomers.end());
+
+  size_t lost{0};
+  for (auto& playerUuid : newcomers) {
+    PlayerInfo info{};
+    if (not sqlite.FindByUuid(playerUuid, info)) {
+      lost++;
+    }
+  }
+
+  const auto micros = [](int64_t value) { return value / 1000.0; };
+
+  std::printf(
+      "Joins: %zu in %.2f s (%.0f/s, target %.0f/s), %llu behind schedule\n",
+      nanos.size(),
+      joinSeconds,
+      nanos.size() / joinSeconds,
+      options.rate,
+      static_cast<unsigned long long>(late)
+  );
+  std::printf(
+      "Outcomes: %llu admitted, %llu blacklisted, %llu newcomers, %llu by "
+      "policy, %llu warm-up admitted, %llu warm-up rejected\n",
+      static_cast<unsigned long long>(outcomes[ConnectOutcome::Admitted]),
+      static_cast<unsigned long long>(outcomes[ConnectOutcome::BlacklistRejected]),
+      static_cast<unsigned long long>(outcomes[ConnectOutcome::NewcomerRejected]),
+      static_cast<unsigned long long>(outcomes[ConnectOutcome::PolicyRejected]),
+      static_cast<unsigned long long>(outcomes[ConnectOutcome::WarmupAdmitted]),
+      static_cast<unsigned long long>(outcomes[ConnectOutcome::WarmupRejected])
+  );
+  std::printf(
+      "Decision latency: p50 %.1f us, p99 %.1f us, p999 %.1f us, max %.1f us\n",
+      micros(Percentile(nanos, 0.50)),
+      micros(Percentile(nanos, 0.99)),
+      micros(Percentile(nanos, 0.999)),
+      micros(nanos.empty() ? 0 : nanos.back())
+  );
+
+  const auto stats = admission.GetStatistics();
+  std::printf(
+      "Admission: %llu over budget, %llu from cache, %llu by policy, %llu "
+      "re-checked, %llu error(s)\n",
+      static_cast<unsigned long long>(stats.Overruns),
+      static_cast<unsigned long long>(stats.CacheFallbacks),
+      static_cast<unsigned long long>(stats.PolicyFallbacks),
+      static_cast<unsigned long long>(stats.Rechecks),
+      static_cast<unsigned long long>(stats.Errors)
+  );
+
+  const auto seen = lastSeen.GetStatistics();
+  std::printf(
+      "Writes: newcomers %llu rows in %llu transactions (%.0f rows/s), "
+      "last seen %llu rows in %llu flushes (%.0f rows/s, slowest flush %lld us)\n",
+      static_cast<unsigned long long>(backend.Rows.load()),
+      static_cast<unsigned long long>(backend.Transactions.load()),
+      backend.Rows / totalSeconds,
+      static_cast<unsigned long long>(seen.RowsWritten),
+      static_cast<unsigned long long>(seen.Flushes),
+      seen.RowsWritten / totalSeconds,
+      static_cast<long long>(seen.MaxFlushMicros)
+  );
+  std::printf(
+      "Newcomers: %zu players rejected, %zu recorded, %zu lost\n",
+      newcomers.size(),
+      newcomers.size() - lost,
+      lost
+  );
+
+  const auto known = identities.GetStatistics();
+  std::printf(
+      "Identities: %llu players by xuid, %llu joins resolved, %llu rows written\n",
+      static_cast<unsigned long long>(known.Identities),
+      static_cast<unsigned long long>(known.Resolved),
+      static_cast<unsigned long long>(known.Recorded)
+  );
+
+  const auto counted = counters.GetStatistics(std::time(nullptr));
+  std::printf(
+      "Counters: %lld whitelisted, %lld blacklisted, %lld newcomers (%lld in "
+      "the last hour), %lld rejects in the last hour\n",
+      static_cast<long long>(counted.Whitelisted),
+      static_cast<long long>(counted.Blacklisted),
+      static_cast<long long>(counted.AutoRecorded),
+      static_cast<long long>(counted.NewcomersLastHour),
+      static_cast<long long>(counted.RejectsLastHour)
+  );
+
+  return lost == 0 ? 0 : 1;
+}
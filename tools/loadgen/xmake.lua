@@ -0,0 +1,43 @@
+-- Runs on Linux and Windows without BDS or LeviLamina, only the portable
+-- modules of src/plugin are linked.
+if has_config("loadgen") then
+    add_requires("fmt")
+
+    target("ConnectStorm")
+        set_kind("binary")
+        set_languages("c++20")
+        add_packages("fmt")
+        add_packages("sqlite3")
+        add_packages("sqlitecpp")
+        add_packages("zlib")
+
+        if is_plat("windows") then
+            add_cxflags("/utf-8")
+            add_defines("NOMINMAX", "UNICODE")
+        else
+            add_syslinks("pthread")
+        end
+
+        add_includedirs("$(projectdir)/src")
+        add_files("ConnectStorm.cpp")
+        add_files(
+            "$(projectdir)/src/plugin/Admission.cpp",
+            "$(projectdir)/src/plugin/Bitmap.cpp",
+            "$(projectdir)/src/plugin/Columns.cpp",
+            "$(projectdir)/src/plugin/Connect.cpp",
+            "$(projectdir)/src/plugin/Counters.cpp",
+            "$(projectdir)/src/plugin/Groups.cpp",
+            "$(projectdir)/src/plugin/Identity.cpp",
+            "$(projectdir)/src/plugin/Journal.cpp",
+            "$(projectdir)/src/plugin/LastSeen.cpp",
+            "$(projectdir)/src/plugin/Migration.cpp",
+            "$(projectdir)/src/plugin/NamedLists.cpp",
+            "$(projectdir)/src/plugin/PlayerDB.cpp",
+            "$(projectdir)/src/plugin/Rules.cpp",
+            "$(projectdir)/src/plugin/Shards.cpp",
+            "$(projectdir)/src/plugin/Storage.cpp",
+            "$(projectdir)/src/plugin/VerdictCache.cpp",
+            "$(projectdir)/src/plugin/Warmup.cpp",
+            "$(projectdir)/src/plugin/Worker.cpp"
+        )
+end
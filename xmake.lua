@@ -3,10 +3,28 @@ add_rules("mode.debug", "mode.release")
 add_repositories("liteldev-repo https://github.com/LiteLDev/xmake-repo.git")
 
 
-add_requires("levilamina")
-add_requires("cryptopp")
-add_requires("yaml-cpp")
+option("loadgen")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the connect-storm load generator (tools/loadgen) instead of the plugin")
+option_end()
+
+option("bench")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the micro-benchmarks (tools/bench) instead of the plugin")
+option_end()
+
+
+local tools_only = has_config("loadgen") or has_config("bench")
+
+if not tools_only then
+    add_requires("levilamina")
+    add_requires("cryptopp")
+    add_requires("yaml-cpp")
+end
 add_requires("sqlite3")
+add_requires("zlib")
 add_requires("sqlitecpp", {configs = {column_metadata = true, stack_protection = true, sqlite3_external = true}})
 
 if not has_config("vs_runtime") then
@@ -14,6 +32,7 @@ if not has_config("vs_runtime") then
 end
 
 target("BedrockWhitelist")
+    set_enabled(not tools_only)
     add_cxflags(
         "/EHa",
         "/utf-8",
@@ -26,12 +45,13 @@ target("BedrockWhitelist")
         "/w45204"
     )
 
-    add_defines("NOMINMAX", "UNICODE")
+    add_defines("NOMINMAX", "UNICODE", "BEDROCK_WHITELIST_EXPORTS")
     add_packages("levilamina")
     add_packages("cryptopp")
     add_packages("yaml-cpp")
     add_packages("sqlite3")
     add_packages("sqlitecpp")
+    add_packages("zlib")
 
 
     add_includedirs("src")
@@ -64,3 +84,7 @@ target("BedrockWhitelist")
         plugin_packer.pack_plugin(target,plugin_define)
 		    plugin_update.UpdateToServer()
     end)
+
+
+includes("tools/bench")
+includes("tools/loadgen")